@@ -1,17 +1,32 @@
 #version 330 core
 
-in vec3 vertex_color;
-in vec3 vertex_tex_coord;
+flat in vec3 vertex_color;
+flat in vec3 vertex_alternate_color;
+in float vertex_x;
+in vec2 vertex_tex_coord;
 
 out vec4 out_frag_color;
 
 uniform sampler2D texture_sampler;
+uniform float cell_width;
+// The absolute line of the row being drawn.
+uniform int row_line;
+// The sorted selection, as (column, absolute line) pairs. Nothing is selected if the end is before the start.
+uniform ivec2 selection_start;
+uniform ivec2 selection_end;
+
+bool is_selected(int x, int line) {
+    return line >= selection_start.y && line <= selection_end.y &&
+           (line != selection_start.y || x >= selection_start.x) && (line != selection_end.y || x <= selection_end.x);
+}
 
 void main() {
-    vec4 texture_color = texture(texture_sampler, vertex_tex_coord.xy);
+    vec4 texture_color = texture(texture_sampler, vertex_tex_coord);
     if (texture_color.a < 1.0) {
         discard;
     }
 
-    out_frag_color = vec4(vertex_color, 1.0f) * texture_color;
+    bool is_fragment_selected = is_selected(int(floor(vertex_x / cell_width)), row_line);
+    vec3 color = is_fragment_selected ? vertex_alternate_color : vertex_color;
+    out_frag_color = vec4(color, 1.0f) * texture_color;
 }
\ No newline at end of file
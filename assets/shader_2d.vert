@@ -1,17 +1,38 @@
 #version 330 core
 
-layout (location = 0) in vec3 in_position;
-layout (location = 1) in vec3 in_color;
-layout (location = 2) in vec3 in_tex_coord;
+layout (location = 0) in vec2 in_position;
+layout (location = 1) in uint in_color;
+layout (location = 2) in uint in_alternate_color;
+layout (location = 3) in vec2 in_tex_coord;
 
-out vec3 vertex_color;
-out vec3 vertex_tex_coord;
+flat out vec3 vertex_color;
+flat out vec3 vertex_alternate_color;
+out float vertex_x;
+out vec2 vertex_tex_coord;
 
 uniform mat4 projection_matrix;
 uniform float offset_y;
+// Shifts every row down while scrolled by part of a row.
+uniform float scroll_offset;
+uniform sampler2D texture_sampler;
+uniform sampler2D palette_sampler;
+
+// Matches GRID_COLOR_TRUECOLOR, colors without it are palette indices.
+const uint truecolor_flag = 0x1000000u;
+
+vec3 resolve_color(uint color) {
+    if ((color & truecolor_flag) != 0u) {
+        return vec3((color >> 16) & 0xffu, (color >> 8) & 0xffu, color & 0xffu) / 255.0;
+    }
+
+    return texelFetch(palette_sampler, ivec2(int(color), 0), 0).rgb;
+}
 
 void main() {
-    gl_Position = projection_matrix * vec4(in_position + vec3(0.0f, offset_y, 0.0f), 1.0);
-    vertex_color = in_color;
-    vertex_tex_coord = in_tex_coord;
+    gl_Position = projection_matrix * vec4(in_position + vec2(0.0f, offset_y - scroll_offset), 0.0f, 1.0);
+    vertex_color = resolve_color(in_color);
+    vertex_alternate_color = resolve_color(in_alternate_color);
+    vertex_x = in_position.x;
+    // Texture coordinates are stored in pixels.
+    vertex_tex_coord = in_tex_coord / vec2(textureSize(texture_sampler, 0));
 }
\ No newline at end of file
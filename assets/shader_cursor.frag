@@ -0,0 +1,14 @@
+#version 330 core
+
+in vec2 vertex_tex_coord;
+
+out vec4 out_frag_color;
+
+uniform sampler2D texture_sampler;
+uniform bool has_glyph;
+
+void main() {
+    // Block cursors invert the glyph underneath them.
+    bool is_glyph = has_glyph && texture(texture_sampler, vertex_tex_coord).a == 1.0;
+    out_frag_color = is_glyph ? vec4(0.0f, 0.0f, 0.0f, 1.0f) : vec4(1.0f);
+}
\ No newline at end of file
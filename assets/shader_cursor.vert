@@ -0,0 +1,33 @@
+#version 330 core
+
+out vec2 vertex_tex_coord;
+
+uniform mat4 projection_matrix;
+uniform vec2 cursor_position;
+uniform vec2 cell_size;
+uniform float line_width;
+// Matches enum GridCursorStyle.
+uniform int cursor_style;
+// The glyph under the cursor, in atlas pixels.
+uniform vec2 glyph_position;
+uniform vec2 glyph_size;
+uniform sampler2D texture_sampler;
+
+const int cursor_style_block = 0;
+const int cursor_style_underline = 1;
+
+void main() {
+    // The quad is generated from the vertex index, drawn as a triangle strip.
+    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+
+    vec2 size = vec2(line_width, cell_size.y);
+    if (cursor_style == cursor_style_block) {
+        size = cell_size;
+    } else if (cursor_style == cursor_style_underline) {
+        size = vec2(cell_size.x, line_width);
+    }
+
+    gl_Position = projection_matrix * vec4(cursor_position + corner * size, 0.0f, 1.0);
+    vertex_tex_coord =
+        (glyph_position + vec2(corner.x, 1.0f - corner.y) * glyph_size) / vec2(textureSize(texture_sampler, 0));
+}
\ No newline at end of file
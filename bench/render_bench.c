@@ -0,0 +1,306 @@
+// Measures what the renderer costs in a few synthetic scenarios, across a sweep of grid sizes. It only needs a GL 3.3
+// context, so with TERM_USE_OSMESA it also runs headless on machines without a GPU, using a software GL
+// implementation. Every grid size is measured with 1, 2, 4 and so on threads building rows, up to one per processor.
+//
+// Usage: term-render-bench [frame count] [--threads count] [--no-budget]
+//
+// --threads only measures that many threads instead of sweeping. --no-budget lets every frame build all of its dirty
+// rows, instead of leaving the ones past the renderer's per frame budget to later frames.
+
+#include "window.h"
+#include "grid.h"
+#include "font.h"
+#include "clock.h"
+#include "graphics/renderer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include <math.h>
+
+#define BENCH_DEFAULT_FRAME_COUNT 120
+// Frames before measuring starts, so that one time costs like growing meshes aren't counted.
+#define BENCH_WARMUP_FRAME_COUNT 10
+
+struct BenchGridSize {
+    size_t width;
+    size_t height;
+};
+
+static const struct BenchGridSize bench_grid_sizes[] = {
+    {80, 24},
+    {200, 60},
+    {400, 120},
+};
+
+struct BenchContext {
+    struct Renderer *renderer;
+    struct Grid *grid;
+    struct BenchGridSize size;
+    size_t thread_count;
+    // Counts frames since the scenario started, including warm up frames.
+    uint32_t frame;
+    uint32_t random_state;
+};
+
+// Changes the grid or renderer the way the scenario would between two frames.
+struct BenchScenario {
+    const char *name;
+    void (*update)(struct BenchContext *context);
+};
+
+static uint32_t bench_random(struct BenchContext *context) {
+    // Xorshift, so every run draws the same frames.
+    uint32_t x = context->random_state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    context->random_state = x;
+
+    return x;
+}
+
+static uint32_t bench_random_char(struct BenchContext *context) {
+    return '!' + bench_random(context) % ('~' - '!' + 1);
+}
+
+static void bench_fill_row(struct BenchContext *context, int32_t y) {
+    for (int32_t x = 0; x < context->grid->width; x++) {
+        grid_set_char(context->grid, x, y, bench_random_char(context));
+    }
+}
+
+static void bench_full_repaint(struct BenchContext *context) {
+    for (int32_t y = 0; y < context->grid->height; y++) {
+        bench_fill_row(context, y);
+    }
+}
+
+static void bench_single_dirty_row(struct BenchContext *context) {
+    struct Grid *grid = context->grid;
+
+    grid_set_char(grid, context->frame % grid->width, grid->height / 2, bench_random_char(context));
+}
+
+// Output scrolling past the bottom of the screen, one line per frame.
+static void bench_scrolling(struct BenchContext *context) {
+    renderer_scroll_down(context->renderer, 1, true);
+    grid_scroll_down(context->grid);
+    bench_fill_row(context, context->grid->height - 1);
+}
+
+// Scrolling back and forth through the history left behind by the scrolling scenario.
+static void bench_scrollback(struct BenchContext *context) {
+    if (context->frame / 32 % 2 == 0) {
+        renderer_scroll_up(context->renderer, context->grid, 1);
+    } else {
+        renderer_scroll_down(context->renderer, 1, false);
+    }
+}
+
+static void bench_selection_drag(struct BenchContext *context) {
+    struct Grid *grid = context->grid;
+
+    if (context->frame == 0) {
+        renderer_scroll_reset(context->renderer);
+        renderer_set_selection_start(context->renderer, grid, 0, 0);
+    }
+
+    renderer_set_selection_end(context->renderer, grid, context->frame % grid->width, context->frame % grid->height);
+}
+
+// Full screen redraws where every cell has its own colors, like a busy TUI.
+static void bench_colored_tui(struct BenchContext *context) {
+    struct Grid *grid = context->grid;
+
+    if (context->frame == 0) {
+        renderer_clear_selection(context->renderer);
+    }
+
+    for (int32_t y = 0; y < grid->height; y++) {
+        for (int32_t x = 0; x < grid->width; x++) {
+            uint32_t color = bench_random(context);
+
+            grid->current_foreground_color = color % GRID_PALETTE_TABLE_LENGTH;
+            grid->current_background_color = color & 1 ? GRID_COLOR_TRUECOLOR | (color >> 8) : (color >> 8) % 16;
+            grid_set_char(grid, x, y, bench_random_char(context));
+        }
+    }
+
+    grid->current_foreground_color = GRID_COLOR_FOREGROUND_DEFAULT;
+    grid->current_background_color = GRID_COLOR_BACKGROUND_DEFAULT;
+}
+
+// Dragging the window's edge, the grid alternates between its size and a slightly smaller one.
+static void bench_resize_storm(struct BenchContext *context) {
+    size_t width = context->size.width - context->frame % 2 * (context->size.width / 10);
+    size_t height = context->size.height - context->frame % 2 * (context->size.height / 10);
+
+    renderer_resize(context->renderer, width, height);
+    grid_resize(context->grid, width, height);
+}
+
+// The scrollback scenario needs the history from the scrolling one, and resizing is last since it changes the size.
+static const struct BenchScenario bench_scenarios[] = {
+    {"full repaint", bench_full_repaint},
+    {"single row", bench_single_dirty_row},
+    {"scrolling", bench_scrolling},
+    {"scrollback", bench_scrollback},
+    {"selection drag", bench_selection_drag},
+    {"colored tui", bench_colored_tui},
+    {"resize storm", bench_resize_storm},
+};
+
+static void bench_run_scenario(
+    struct BenchContext *context, const struct BenchScenario *scenario, struct Window *window, uint32_t frame_count
+) {
+
+    struct Renderer *renderer = context->renderer;
+
+    double total_build_time = 0.0;
+    double total_frame_time = 0.0;
+    size_t total_built_row_count = 0;
+    size_t total_upload_byte_count = 0;
+
+    context->frame = 0;
+
+    for (uint32_t i = 0; i < BENCH_WARMUP_FRAME_COUNT + frame_count; i++) {
+        scenario->update(context);
+        context->frame++;
+
+        double start_time = clock_get_time();
+
+        renderer_update_glyph_cache(renderer);
+        renderer_draw(renderer, context->grid, renderer->viewport_height, window);
+        // Wait for the GPU so that the frame time includes the uploads and draws.
+        glFinish();
+
+        if (i < BENCH_WARMUP_FRAME_COUNT) {
+            continue;
+        }
+
+        total_frame_time += clock_get_time() - start_time;
+        total_build_time += renderer->frame_stats.build_time;
+        total_built_row_count += renderer->frame_stats.built_row_count;
+        total_upload_byte_count += renderer->frame_stats.upload_byte_count;
+    }
+
+    printf(
+        "%-16s %4zux%-4zu %3zu threads, build %8.3f ms, %7.1f rows, upload %9.1f KiB, frame %8.3f ms\n",
+        scenario->name,
+        context->size.width,
+        context->size.height,
+        context->thread_count,
+        total_build_time * 1000.0 / frame_count,
+        (double)total_built_row_count / frame_count,
+        total_upload_byte_count / 1024.0 / frame_count,
+        total_frame_time * 1000.0 / frame_count
+    );
+}
+
+static void bench_run_grid_size(
+    struct BenchGridSize size, size_t thread_count, bool is_budget_enabled, struct Window *window, uint32_t frame_count
+) {
+
+    struct Renderer renderer = renderer_create(size.width, size.height, thread_count);
+    renderer_resize_viewport(&renderer, size.width * FONT_GLYPH_WIDTH, size.height * FONT_GLYPH_HEIGHT);
+
+    if (!is_budget_enabled) {
+        renderer.row_build_budget = INFINITY;
+    }
+
+    struct Grid grid = grid_create(
+        size.width,
+        size.height,
+        &renderer,
+        renderer_on_row_changed_callback,
+        renderer_on_cursor_changed_callback
+    );
+
+    struct BenchContext context = {
+        .renderer = &renderer,
+        .grid = &grid,
+        .size = size,
+        .thread_count = thread_count,
+        .random_state = 0x12345678,
+    };
+
+    size_t scenario_count = sizeof(bench_scenarios) / sizeof(bench_scenarios[0]);
+    for (size_t scenario_i = 0; scenario_i < scenario_count; scenario_i++) {
+        bench_run_scenario(&context, &bench_scenarios[scenario_i], window, frame_count);
+    }
+
+    // The renderer's prefetch thread may still be reading scrollback lines, so it has to stop before the grid is
+    // freed.
+    renderer_destroy(&renderer);
+    grid_destroy(&grid);
+}
+
+int main(int argc, char **argv) {
+    uint32_t frame_count = BENCH_DEFAULT_FRAME_COUNT;
+    size_t only_thread_count = 0;
+    bool is_budget_enabled = true;
+
+    for (int32_t i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            i++;
+            only_thread_count = strtoul(argv[i], NULL, 10);
+
+            if (only_thread_count == 0) {
+                puts("Usage: term-render-bench [frame count] [--threads count] [--no-budget]");
+                return -1;
+            }
+        } else if (strcmp(argv[i], "--no-budget") == 0) {
+            is_budget_enabled = false;
+        } else {
+            frame_count = (uint32_t)strtoul(argv[i], NULL, 10);
+
+            if (frame_count == 0) {
+                puts("Usage: term-render-bench [frame count] [--threads count] [--no-budget]");
+                return -1;
+            }
+        }
+    }
+
+    size_t grid_size_count = sizeof(bench_grid_sizes) / sizeof(bench_grid_sizes[0]);
+    struct BenchGridSize largest_size = bench_grid_sizes[grid_size_count - 1];
+
+    // The window is never shown, every grid size is drawn into the corner of its framebuffer.
+    struct Window window = window_create(
+        "term-render-bench",
+        largest_size.width * FONT_GLYPH_WIDTH,
+        largest_size.height * FONT_GLYPH_HEIGHT
+    );
+    // The cursor is only drawn while focused.
+    window.is_focused = true;
+
+    printf("renderer: %s\n", (const char *)glGetString(GL_RENDERER));
+    printf("row build budget: %s\n", is_budget_enabled ? "on" : "off");
+
+    size_t processor_count = thread_get_processor_count();
+
+    for (size_t i = 0; i < grid_size_count; i++) {
+        if (only_thread_count > 0) {
+            bench_run_grid_size(bench_grid_sizes[i], only_thread_count, is_budget_enabled, &window, frame_count);
+            continue;
+        }
+
+        // Doubles the thread count each time, then finishes with one thread per processor.
+        for (size_t thread_count = 1;; thread_count *= 2) {
+            if (thread_count > processor_count) {
+                thread_count = processor_count;
+            }
+
+            bench_run_grid_size(bench_grid_sizes[i], thread_count, is_budget_enabled, &window, frame_count);
+
+            if (thread_count == processor_count) {
+                break;
+            }
+        }
+    }
+
+    window_destroy(&window);
+
+    return 0;
+}
\ No newline at end of file
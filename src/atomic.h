@@ -0,0 +1,47 @@
+#ifndef ATOMIC_H
+#define ATOMIC_H
+
+#include "detect_leak.h"
+
+#include <inttypes.h>
+
+// Loads and stores for values shared between threads without a lock, MSVC only has stdatomic.h behind an
+// experimental flag.
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+static inline uint64_t atomic_load_acquire_uint64(uint64_t *value) {
+    return (uint64_t)InterlockedCompareExchange64((volatile LONG64 *)value, 0, 0);
+}
+
+static inline void atomic_store_release_uint64(uint64_t *value, uint64_t new_value) {
+    InterlockedExchange64((volatile LONG64 *)value, (LONG64)new_value);
+}
+
+static inline void *atomic_load_acquire_pointer(void **value) {
+    return InterlockedCompareExchangePointer(value, NULL, NULL);
+}
+
+static inline void atomic_store_release_pointer(void **value, void *new_value) {
+    InterlockedExchangePointer(value, new_value);
+}
+#else
+static inline uint64_t atomic_load_acquire_uint64(uint64_t *value) {
+    return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+}
+
+static inline void atomic_store_release_uint64(uint64_t *value, uint64_t new_value) {
+    __atomic_store_n(value, new_value, __ATOMIC_RELEASE);
+}
+
+static inline void *atomic_load_acquire_pointer(void **value) {
+    return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+}
+
+static inline void atomic_store_release_pointer(void **value, void *new_value) {
+    __atomic_store_n(value, new_value, __ATOMIC_RELEASE);
+}
+#endif
+
+#endif
\ No newline at end of file
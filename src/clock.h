@@ -0,0 +1,10 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include "detect_leak.h"
+
+// Seconds since an arbitrary point, from a monotonic high resolution clock. Unlike glfwGetTime this works before
+// GLFW is initialized.
+double clock_get_time(void);
+
+#endif
\ No newline at end of file
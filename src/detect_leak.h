@@ -1,3 +1,8 @@
+// Leak detection uses the MSVC debug heap, elsewhere this only includes stdlib.h like it does on Windows.
+#ifdef _WIN32
 #define _CRTDBG_MAP_ALLOC
 #include <stdlib.h>
-#include <crtdbg.h>
\ No newline at end of file
+#include <crtdbg.h>
+#else
+#include <stdlib.h>
+#endif
\ No newline at end of file
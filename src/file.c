@@ -1,11 +1,14 @@
+// fopen_s is only available with MSVC.
+#define _CRT_SECURE_NO_WARNINGS
+
 #include "file.h"
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <assert.h>
 
 char *get_file_string(char *file_path) {
-    FILE *file;
-    fopen_s(&file, file_path, "rb");
+    FILE *file = fopen(file_path, "rb");
 
     if (!file) {
         printf("Failed to open file: %s\n", file_path);
@@ -29,5 +32,30 @@ char *get_file_string(char *file_path) {
     fread(buffer, 1, string_length, file);
     buffer[string_length] = '\0';
 
+    return buffer;
+}
+
+uint8_t *get_file_data(char *file_path, size_t *length) {
+    FILE *file = fopen(file_path, "rb");
+
+    if (!file) {
+        return NULL;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long file_length = ftell(file);
+    rewind(file);
+
+    if (file_length == -1) {
+        fclose(file);
+        return NULL;
+    }
+
+    uint8_t *buffer = malloc(file_length);
+    assert(buffer);
+
+    *length = fread(buffer, 1, file_length, file);
+    fclose(file);
+
     return buffer;
 }
\ No newline at end of file
@@ -3,6 +3,11 @@
 
 #include "detect_leak.h"
 
+#include <stddef.h>
+#include <inttypes.h>
+
 char *get_file_string(char *file_path);
+// Returns NULL if the file couldn't be read, unlike get_file_string which exits.
+uint8_t *get_file_data(char *file_path, size_t *length);
 
 #endif
\ No newline at end of file
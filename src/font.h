@@ -6,5 +6,11 @@
 #define FONT_GLYPH_HEIGHT 14
 #define FONT_GLYPH_PADDING 2
 #define FONT_LENGTH 95
+// Glyphs outside of the texture atlas are rasterized from this font.
+#ifdef _WIN32
+#define FONT_TRUETYPE_PATH "C:\\Windows\\Fonts\\consola.ttf"
+#else
+#define FONT_TRUETYPE_PATH "/usr/share/fonts/truetype/dejavu/DejaVuSansMono.ttf"
+#endif
 
 #endif
\ No newline at end of file
@@ -0,0 +1,516 @@
+#include "glyph_cache.h"
+
+#include "../atomic.h"
+#include "../file.h"
+#include "../trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define GLYPH_CACHE_CELL_WIDTH (FONT_GLYPH_WIDTH + FONT_GLYPH_PADDING)
+#define GLYPH_CACHE_CELL_HEIGHT (FONT_GLYPH_HEIGHT + FONT_GLYPH_PADDING)
+#define GLYPH_CACHE_INITIAL_DYNAMIC_ROW_COUNT 4
+#define GLYPH_CACHE_MAX_HEIGHT 2048
+// Must be a power of two.
+#define GLYPH_CACHE_INITIAL_ENTRY_CAPACITY 256
+#define GLYPH_CACHE_CODEPOINT_MASK 0xffffff
+#define GLYPH_CACHE_ENTRY_STATE_BIT_COUNT 2
+
+static void glyph_cache_rasterizer_start(void *data) {
+    struct GlyphCacheShared *shared = data;
+
+    TRACE_SET_THREAD_NAME("glyph rasterizer");
+
+    size_t font_data_length = 0;
+    uint8_t *font_data = get_file_data(FONT_TRUETYPE_PATH, &font_data_length);
+
+    struct TrueTypeFont font;
+    bool has_font = font_data && truetype_font_init(&font, font_data, font_data_length);
+    if (!has_font) {
+        printf("Failed to load font: %s\n", FONT_TRUETYPE_PATH);
+    }
+
+    mutex_lock(&shared->mutex);
+
+    while (true) {
+        while (shared->requests.length == 0 && !shared->should_stop) {
+            condition_variable_wait(&shared->has_requests, &shared->mutex);
+        }
+
+        if (shared->should_stop) {
+            break;
+        }
+
+        uint32_t key = list_pop_uint32_t(&shared->requests);
+
+        mutex_unlock(&shared->mutex);
+        TRACE_BEGIN("rasterize glyph");
+
+        struct GlyphRasterization rasterization = {
+            .key = key,
+            .is_missing = true,
+        };
+
+        if (has_font) {
+            uint32_t glyph_index = truetype_get_glyph_index(&font, key & GLYPH_CACHE_CODEPOINT_MASK);
+
+            if (glyph_index != 0) {
+                truetype_rasterize_glyph(&font, glyph_index, FONT_GLYPH_WIDTH, FONT_GLYPH_HEIGHT, rasterization.bitmap);
+                rasterization.is_missing = false;
+            }
+        }
+
+        TRACE_END();
+        mutex_lock(&shared->mutex);
+
+        list_push_struct_GlyphRasterization(&shared->results, rasterization);
+        event_set(&shared->ready_event);
+    }
+
+    mutex_unlock(&shared->mutex);
+
+    free(font_data);
+}
+
+struct GlyphCache glyph_cache_create(const uint8_t *atlas_pixels, int32_t atlas_width, int32_t atlas_height) {
+    // Dynamic glyphs start at the first row of cells after the static atlas.
+    int32_t static_height =
+        (atlas_height + GLYPH_CACHE_CELL_HEIGHT - 1) / GLYPH_CACHE_CELL_HEIGHT * GLYPH_CACHE_CELL_HEIGHT;
+    int32_t height = static_height + GLYPH_CACHE_INITIAL_DYNAMIC_ROW_COUNT * GLYPH_CACHE_CELL_HEIGHT;
+    size_t column_count = atlas_width / GLYPH_CACHE_CELL_WIDTH;
+
+    uint8_t *pixels = calloc(atlas_width * height * 4, sizeof(uint8_t));
+    assert(pixels);
+    memcpy(pixels, atlas_pixels, atlas_width * atlas_height * 4);
+
+    struct GlyphCacheShared *shared = malloc(sizeof(struct GlyphCacheShared));
+    assert(shared);
+
+    struct GlyphCacheTable *table = malloc(sizeof(struct GlyphCacheTable));
+    assert(table);
+
+    *table = (struct GlyphCacheTable){
+        .entries = calloc(GLYPH_CACHE_INITIAL_ENTRY_CAPACITY, sizeof(uint64_t)),
+        .capacity = GLYPH_CACHE_INITIAL_ENTRY_CAPACITY,
+    };
+
+    assert(table->entries);
+
+    *shared = (struct GlyphCacheShared){
+        .table = table,
+        .requests = list_create_uint32_t(64),
+        .results = list_create_struct_GlyphRasterization(64),
+    };
+
+    mutex_init(&shared->mutex);
+    condition_variable_init(&shared->has_requests);
+    event_init(&shared->ready_event);
+
+    struct GlyphCache glyph_cache = (struct GlyphCache){
+        .shared = shared,
+        .rasterizer_thread = thread_create(glyph_cache_rasterizer_start, shared),
+
+        .texture = texture_create(pixels, atlas_width, height),
+        .pixels = pixels,
+        .static_height = static_height,
+
+        .pending_results = list_create_struct_GlyphRasterization(64),
+
+        .slot_capacity = column_count * GLYPH_CACHE_INITIAL_DYNAMIC_ROW_COUNT,
+        .column_count = column_count,
+    };
+
+    glyph_cache.slots = malloc(glyph_cache.slot_capacity * sizeof(struct GlyphCacheSlot));
+    assert(glyph_cache.slots);
+
+    return glyph_cache;
+}
+
+void glyph_cache_begin_frame(struct GlyphCache *glyph_cache) {
+    glyph_cache->frame++;
+}
+
+static uint32_t glyph_cache_hash(uint32_t key) {
+    key ^= key >> 16;
+    key *= 0x7feb352d;
+    key ^= key >> 15;
+    key *= 0x846ca68b;
+    key ^= key >> 16;
+
+    return key;
+}
+
+// The empty state is zero, so a zeroed entry is empty.
+static uint64_t glyph_cache_pack_entry(struct GlyphCacheEntry entry) {
+    uint64_t state_and_slot = (uint64_t)entry.slot_i << GLYPH_CACHE_ENTRY_STATE_BIT_COUNT | entry.state;
+    return state_and_slot << 32 | entry.key;
+}
+
+static struct GlyphCacheEntry glyph_cache_unpack_entry(uint64_t packed_entry) {
+    uint32_t state_and_slot = packed_entry >> 32;
+
+    return (struct GlyphCacheEntry){
+        .key = (uint32_t)packed_entry,
+        .slot_i = state_and_slot >> GLYPH_CACHE_ENTRY_STATE_BIT_COUNT,
+        .state = state_and_slot & ((1 << GLYPH_CACHE_ENTRY_STATE_BIT_COUNT) - 1),
+    };
+}
+
+// Returns the index of the entry with the given key, or of the empty entry where it would be inserted. Safe to call
+// while the main thread changes the table, since the table is never full there's always an empty entry to stop at.
+static size_t glyph_cache_find_entry(struct GlyphCacheTable *table, uint32_t key, struct GlyphCacheEntry *entry) {
+    size_t mask = table->capacity - 1;
+    size_t i = glyph_cache_hash(key) & mask;
+
+    while (true) {
+        *entry = glyph_cache_unpack_entry(atomic_load_acquire_uint64(&table->entries[i]));
+
+        if (entry->state == GLYPH_CACHE_ENTRY_STATE_EMPTY || entry->key == key) {
+            return i;
+        }
+
+        i = (i + 1) & mask;
+    }
+}
+
+static void glyph_cache_set_entry(struct GlyphCacheTable *table, size_t i, struct GlyphCacheEntry entry) {
+    atomic_store_release_uint64(&table->entries[i], glyph_cache_pack_entry(entry));
+}
+
+// The new table is filled in before it's published, threads that are still reading the old one see entries from
+// before the table grew.
+static void glyph_cache_grow_entries(struct GlyphCache *glyph_cache) {
+    struct GlyphCacheShared *shared = glyph_cache->shared;
+    struct GlyphCacheTable *old_table = shared->table;
+
+    struct GlyphCacheTable *table = malloc(sizeof(struct GlyphCacheTable));
+    assert(table);
+
+    *table = (struct GlyphCacheTable){
+        .entries = calloc(old_table->capacity * 2, sizeof(uint64_t)),
+        .capacity = old_table->capacity * 2,
+        .retired_table = old_table,
+    };
+
+    assert(table->entries);
+
+    for (size_t i = 0; i < old_table->capacity; i++) {
+        struct GlyphCacheEntry old_entry = glyph_cache_unpack_entry(old_table->entries[i]);
+        if (old_entry.state == GLYPH_CACHE_ENTRY_STATE_EMPTY) {
+            continue;
+        }
+
+        struct GlyphCacheEntry entry;
+        table->entries[glyph_cache_find_entry(table, old_entry.key, &entry)] = old_table->entries[i];
+    }
+
+    atomic_store_release_pointer((void **)&shared->table, table);
+}
+
+// Removes an entry without leaving a tombstone, by shifting back any later entries that would no longer be
+// reachable from their home position. Other threads can miss an entry while it's being moved.
+static void glyph_cache_remove_entry(struct GlyphCache *glyph_cache, uint32_t key) {
+    struct GlyphCacheTable *table = glyph_cache->shared->table;
+
+    struct GlyphCacheEntry entry;
+    size_t hole_i = glyph_cache_find_entry(table, key, &entry);
+    if (entry.state == GLYPH_CACHE_ENTRY_STATE_EMPTY) {
+        return;
+    }
+
+    size_t mask = table->capacity - 1;
+    size_t i = hole_i;
+
+    while (true) {
+        i = (i + 1) & mask;
+
+        entry = glyph_cache_unpack_entry(table->entries[i]);
+        if (entry.state == GLYPH_CACHE_ENTRY_STATE_EMPTY) {
+            break;
+        }
+
+        size_t home_i = glyph_cache_hash(entry.key) & mask;
+
+        // The entry can fill the hole if the hole is between its home and its current position.
+        if (((i - home_i) & mask) >= ((i - hole_i) & mask)) {
+            glyph_cache_set_entry(table, hole_i, entry);
+            hole_i = i;
+        }
+    }
+
+    glyph_cache_set_entry(table, hole_i, (struct GlyphCacheEntry){.state = GLYPH_CACHE_ENTRY_STATE_EMPTY});
+    glyph_cache->entry_count--;
+}
+
+static void glyph_cache_get_slot_position(
+    struct GlyphCache *glyph_cache, uint32_t slot_i, uint16_t *texture_x, uint16_t *texture_y
+) {
+
+    *texture_x = (slot_i % glyph_cache->column_count) * GLYPH_CACHE_CELL_WIDTH;
+    *texture_y = glyph_cache->static_height + (slot_i / glyph_cache->column_count) * GLYPH_CACHE_CELL_HEIGHT;
+}
+
+void glyph_cache_get(
+    struct GlyphCache *glyph_cache,
+    uint32_t codepoint,
+    enum GlyphStyle style,
+    uint16_t *texture_x,
+    uint16_t *texture_y,
+    struct List_uint32_t *used_keys
+) {
+
+    // Printable ASCII is always in the static part of the atlas.
+    if (style == GLYPH_STYLE_REGULAR && codepoint >= 32 && codepoint < 32 + FONT_LENGTH) {
+        *texture_x = (codepoint - 32) * GLYPH_CACHE_CELL_WIDTH;
+        *texture_y = 0;
+        return;
+    }
+
+    *texture_x = FONT_LENGTH * GLYPH_CACHE_CELL_WIDTH;
+    *texture_y = 0;
+
+    uint32_t key = (codepoint & GLYPH_CACHE_CODEPOINT_MASK) | (uint32_t)style << 24;
+
+    if (used_keys->length == 0 || used_keys->data[used_keys->length - 1] != key) {
+        list_push_uint32_t(used_keys, key);
+    }
+
+    struct GlyphCacheTable *table = atomic_load_acquire_pointer((void **)&glyph_cache->shared->table);
+
+    struct GlyphCacheEntry entry;
+    glyph_cache_find_entry(table, key, &entry);
+
+    if (entry.state == GLYPH_CACHE_ENTRY_STATE_READY) {
+        glyph_cache_get_slot_position(glyph_cache, entry.slot_i, texture_x, texture_y);
+    }
+}
+
+void glyph_cache_use(struct GlyphCache *glyph_cache, const uint32_t *keys, size_t key_count) {
+    struct GlyphCacheShared *shared = glyph_cache->shared;
+    bool has_requested = false;
+
+    for (size_t i = 0; i < key_count; i++) {
+        struct GlyphCacheEntry entry;
+        size_t entry_i = glyph_cache_find_entry(shared->table, keys[i], &entry);
+
+        switch (entry.state) {
+            case GLYPH_CACHE_ENTRY_STATE_EMPTY: {
+                // Keep the table at most half full so probes stay short.
+                if ((glyph_cache->entry_count + 1) * 2 > shared->table->capacity) {
+                    glyph_cache_grow_entries(glyph_cache);
+                    entry_i = glyph_cache_find_entry(shared->table, keys[i], &entry);
+                }
+
+                glyph_cache_set_entry(
+                    shared->table,
+                    entry_i,
+                    (struct GlyphCacheEntry){
+                        .key = keys[i],
+                        .state = GLYPH_CACHE_ENTRY_STATE_PENDING,
+                    }
+                );
+                glyph_cache->entry_count++;
+
+                if (!has_requested) {
+                    mutex_lock(&shared->mutex);
+                    has_requested = true;
+                }
+
+                list_push_uint32_t(&shared->requests, keys[i]);
+                break;
+            }
+            case GLYPH_CACHE_ENTRY_STATE_READY: {
+                glyph_cache->slots[entry.slot_i].last_used_frame = glyph_cache->frame;
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    if (has_requested) {
+        condition_variable_signal(&shared->has_requests);
+        mutex_unlock(&shared->mutex);
+    }
+}
+
+static bool glyph_cache_grow_texture(struct GlyphCache *glyph_cache) {
+    int32_t width = glyph_cache->texture.width;
+    int32_t old_height = glyph_cache->texture.height;
+    int32_t new_height = old_height * 2;
+
+    if (new_height > GLYPH_CACHE_MAX_HEIGHT) {
+        return false;
+    }
+
+    glyph_cache->pixels = realloc(glyph_cache->pixels, width * new_height * 4);
+    assert(glyph_cache->pixels);
+    memset(glyph_cache->pixels + width * old_height * 4, 0, width * (new_height - old_height) * 4);
+
+    glyph_cache->slot_capacity =
+        glyph_cache->column_count * ((new_height - glyph_cache->static_height) / GLYPH_CACHE_CELL_HEIGHT);
+    glyph_cache->slots = realloc(glyph_cache->slots, glyph_cache->slot_capacity * sizeof(struct GlyphCacheSlot));
+    assert(glyph_cache->slots);
+
+    texture_resize(&glyph_cache->texture, glyph_cache->pixels, width, new_height);
+
+    return true;
+}
+
+// Finds a slot for a new glyph, growing the atlas if possible and otherwise evicting the least recently used glyph.
+// Glyphs used in the most recent frame are never evicted, the keys of evicted glyphs are pushed to changed_keys.
+static bool glyph_cache_allocate_slot(
+    struct GlyphCache *glyph_cache, uint32_t *slot_i, struct List_uint32_t *changed_keys
+) {
+
+    if (glyph_cache->slot_count < glyph_cache->slot_capacity || glyph_cache_grow_texture(glyph_cache)) {
+        *slot_i = glyph_cache->slot_count;
+        glyph_cache->slot_count++;
+        return true;
+    }
+
+    bool did_find_slot = false;
+    uint32_t oldest_frame = glyph_cache->frame;
+
+    for (uint32_t i = 0; i < glyph_cache->slot_count; i++) {
+        uint32_t last_used_frame = glyph_cache->slots[i].last_used_frame;
+
+        if (last_used_frame == glyph_cache->frame || (did_find_slot && last_used_frame >= oldest_frame)) {
+            continue;
+        }
+
+        *slot_i = i;
+        oldest_frame = last_used_frame;
+        did_find_slot = true;
+    }
+
+    if (did_find_slot) {
+        glyph_cache_remove_entry(glyph_cache, glyph_cache->slots[*slot_i].key);
+        list_push_uint32_t(changed_keys, glyph_cache->slots[*slot_i].key);
+    }
+
+    return did_find_slot;
+}
+
+static void glyph_cache_upload(struct GlyphCache *glyph_cache, uint32_t slot_i, const uint8_t *bitmap) {
+    uint8_t glyph_pixels[FONT_GLYPH_WIDTH * FONT_GLYPH_HEIGHT * 4];
+
+    for (size_t i = 0; i < FONT_GLYPH_WIDTH * FONT_GLYPH_HEIGHT; i++) {
+        uint8_t value = bitmap[i] ? 0xff : 0x00;
+        memset(glyph_pixels + i * 4, value, 4);
+    }
+
+    uint16_t texture_x;
+    uint16_t texture_y;
+    glyph_cache_get_slot_position(glyph_cache, slot_i, &texture_x, &texture_y);
+
+    // Keep the CPU copy in sync in case the texture needs to grow later.
+    size_t row_size = FONT_GLYPH_WIDTH * 4;
+    for (size_t y = 0; y < FONT_GLYPH_HEIGHT; y++) {
+        size_t pixels_i = ((texture_y + y) * glyph_cache->texture.width + texture_x) * 4;
+        memcpy(glyph_cache->pixels + pixels_i, glyph_pixels + y * row_size, row_size);
+    }
+
+    texture_update_region(
+        &glyph_cache->texture,
+        texture_x,
+        texture_y,
+        FONT_GLYPH_WIDTH,
+        FONT_GLYPH_HEIGHT,
+        glyph_pixels
+    );
+}
+
+void glyph_cache_update(struct GlyphCache *glyph_cache, struct List_uint32_t *changed_keys) {
+    struct GlyphCacheShared *shared = glyph_cache->shared;
+    struct List_struct_GlyphRasterization *results = &glyph_cache->pending_results;
+
+    mutex_lock(&shared->mutex);
+
+    for (size_t i = 0; i < shared->results.length; i++) {
+        list_push_struct_GlyphRasterization(results, shared->results.data[i]);
+    }
+
+    list_reset_struct_GlyphRasterization(&shared->results);
+
+    mutex_unlock(&shared->mutex);
+
+    size_t result_i = 0;
+    for (; result_i < results->length; result_i++) {
+        struct GlyphRasterization *rasterization = &results->data[result_i];
+
+        struct GlyphCacheEntry entry;
+        size_t entry_i = glyph_cache_find_entry(shared->table, rasterization->key, &entry);
+
+        if (entry.state != GLYPH_CACHE_ENTRY_STATE_PENDING) {
+            continue;
+        }
+
+        // The fallback glyph is already being drawn for missing glyphs, so nothing needs to be redrawn.
+        if (rasterization->is_missing) {
+            entry.state = GLYPH_CACHE_ENTRY_STATE_MISSING;
+            glyph_cache_set_entry(shared->table, entry_i, entry);
+            continue;
+        }
+
+        // Every slot was used in the last frame, try again next time.
+        uint32_t slot_i;
+        if (!glyph_cache_allocate_slot(glyph_cache, &slot_i, changed_keys)) {
+            break;
+        }
+
+        // Allocating a slot may have evicted another entry, which can move this one.
+        entry_i = glyph_cache_find_entry(shared->table, rasterization->key, &entry);
+        entry.slot_i = slot_i;
+        entry.state = GLYPH_CACHE_ENTRY_STATE_READY;
+        glyph_cache_set_entry(shared->table, entry_i, entry);
+
+        glyph_cache->slots[slot_i] = (struct GlyphCacheSlot){
+            .key = rasterization->key,
+            .last_used_frame = glyph_cache->frame,
+        };
+
+        glyph_cache_upload(glyph_cache, slot_i, rasterization->bitmap);
+        list_push_uint32_t(changed_keys, rasterization->key);
+    }
+
+    size_t remaining_count = results->length - result_i;
+    memmove(results->data, results->data + result_i, remaining_count * sizeof(struct GlyphRasterization));
+    results->length = remaining_count;
+}
+
+void glyph_cache_destroy(struct GlyphCache *glyph_cache) {
+    struct GlyphCacheShared *shared = glyph_cache->shared;
+
+    mutex_lock(&shared->mutex);
+    shared->should_stop = true;
+    condition_variable_broadcast(&shared->has_requests);
+    mutex_unlock(&shared->mutex);
+
+    thread_join(&glyph_cache->rasterizer_thread);
+
+    list_destroy_uint32_t(&shared->requests);
+    list_destroy_struct_GlyphRasterization(&shared->results);
+    condition_variable_destroy(&shared->has_requests);
+    event_destroy(&shared->ready_event);
+    mutex_destroy(&shared->mutex);
+
+    struct GlyphCacheTable *table = shared->table;
+    while (table) {
+        struct GlyphCacheTable *retired_table = table->retired_table;
+
+        free(table->entries);
+        free(table);
+
+        table = retired_table;
+    }
+
+    free(shared);
+
+    list_destroy_struct_GlyphRasterization(&glyph_cache->pending_results);
+    texture_destroy(&glyph_cache->texture);
+    free(glyph_cache->pixels);
+    free(glyph_cache->slots);
+}
\ No newline at end of file
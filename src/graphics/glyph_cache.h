@@ -0,0 +1,122 @@
+#ifndef GLYPH_CACHE_H
+#define GLYPH_CACHE_H
+
+#include "../detect_leak.h"
+
+#include "../font.h"
+#include "../list.h"
+#include "../thread.h"
+#include "resources.h"
+#include "truetype.h"
+
+#include <stdbool.h>
+#include <inttypes.h>
+
+enum GlyphStyle {
+    GLYPH_STYLE_REGULAR,
+};
+
+enum GlyphCacheEntryState {
+    GLYPH_CACHE_ENTRY_STATE_EMPTY,
+    // Waiting for the rasterizer thread.
+    GLYPH_CACHE_ENTRY_STATE_PENDING,
+    GLYPH_CACHE_ENTRY_STATE_READY,
+    // The font doesn't contain the glyph, the fallback glyph is used instead.
+    GLYPH_CACHE_ENTRY_STATE_MISSING,
+};
+
+struct GlyphCacheEntry {
+    uint32_t key;
+    uint32_t slot_i;
+    enum GlyphCacheEntryState state;
+};
+
+// Entries are packed into 64 bits in the table so that they can be read with a single atomic load while the main
+// thread changes them.
+struct GlyphCacheTable {
+    uint64_t *entries;
+    size_t capacity;
+    // Tables that were replaced when the table grew are kept until the glyph cache is destroyed, since other threads
+    // might still be reading them. Each one is half the size of the next, so they use less memory than the table.
+    struct GlyphCacheTable *retired_table;
+};
+
+struct GlyphCacheSlot {
+    uint32_t key;
+    uint32_t last_used_frame;
+};
+
+struct GlyphRasterization {
+    uint32_t key;
+    bool is_missing;
+    uint8_t bitmap[FONT_GLYPH_WIDTH * FONT_GLYPH_HEIGHT];
+};
+
+typedef struct GlyphRasterization struct_GlyphRasterization;
+LIST_DEFINE(struct_GlyphRasterization)
+
+// State shared with the rasterizer thread and the threads that build rows. It's allocated separately so that it
+// doesn't move when the glyph cache is copied.
+struct GlyphCacheShared {
+    // Only the main thread changes the table, other threads look glyphs up without a lock.
+    struct GlyphCacheTable *table;
+
+    // Protects the requests and results.
+    struct Mutex mutex;
+    struct ConditionVariable has_requests;
+    // Set whenever rasterized glyphs are ready to be uploaded.
+    struct Event ready_event;
+
+    struct List_uint32_t requests;
+    struct List_struct_GlyphRasterization results;
+
+    bool should_stop;
+};
+
+// Printable ASCII comes from a fixed region at the top of the atlas, everything else is rasterized on demand into
+// slots below it. The atlas grows until it reaches its maximum height, then the least recently used slots are reused.
+struct GlyphCache {
+    struct GlyphCacheShared *shared;
+    struct Thread rasterizer_thread;
+
+    struct Texture texture;
+    // A CPU copy of the atlas, used to refill the texture when it grows.
+    uint8_t *pixels;
+    int32_t static_height;
+
+    size_t entry_count;
+    // Results taken from the rasterizer thread that are waiting for a slot.
+    struct List_struct_GlyphRasterization pending_results;
+
+    struct GlyphCacheSlot *slots;
+    size_t slot_capacity;
+    size_t slot_count;
+    size_t column_count;
+
+    uint32_t frame;
+};
+
+// The atlas pixels are RGBA, they're copied so they don't need to outlive the glyph cache.
+struct GlyphCache glyph_cache_create(const uint8_t *atlas_pixels, int32_t atlas_width, int32_t atlas_height);
+void glyph_cache_begin_frame(struct GlyphCache *glyph_cache);
+// Gets the position of a glyph in the atlas, the fallback glyph is used until it's ready. Glyphs that aren't in the
+// static part of the atlas are pushed to used_keys, consecutive repeats only once. Never blocks, and can be called
+// from any thread.
+void glyph_cache_get(
+    struct GlyphCache *glyph_cache,
+    uint32_t codepoint,
+    enum GlyphStyle style,
+    uint16_t *texture_x,
+    uint16_t *texture_y,
+    struct List_uint32_t *used_keys
+);
+// Keeps glyphs that were used in this frame from being evicted, and requests the ones that haven't been rasterized
+// yet. Only called from the main thread.
+void glyph_cache_use(struct GlyphCache *glyph_cache, const uint32_t *keys, size_t key_count);
+// Uploads finished glyphs, pushing the keys of glyphs that became ready or got evicted to changed_keys. Anything drawn
+// with those glyphs looks different now. Lookups on other threads that overlap an update can miss glyphs that get
+// moved, so whatever they built should be thrown away if any keys changed.
+void glyph_cache_update(struct GlyphCache *glyph_cache, struct List_uint32_t *changed_keys);
+void glyph_cache_destroy(struct GlyphCache *glyph_cache);
+
+#endif
\ No newline at end of file
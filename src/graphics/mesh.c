@@ -1,12 +1,48 @@
 #include "mesh.h"
 
 #include <assert.h>
+#include <stdlib.h>
+#include <stddef.h>
 
-const size_t vertex_component_count = 9;
-const uint64_t sizeof_vec3 = sizeof(float) * 3;
-const uint64_t sizeof_vertex = sizeof_vec3 * 3;
+// Matches the vertex order of a quad: bottom left, top left, top right, bottom right.
+const uint32_t quad_indices[] = {0, 2, 1, 0, 3, 2};
+
+struct IndexBuffer index_buffer_create_quads(uint32_t max_quad_count) {
+    size_t index_count = max_quad_count * 6;
+    uint32_t *indices = malloc(index_count * sizeof(uint32_t));
+    assert(indices);
+
+    for (size_t quad_i = 0; quad_i < max_quad_count; quad_i++) {
+        uint32_t first_vertex = quad_i * 4;
+
+        for (size_t index_i = 0; index_i < 6; index_i++) {
+            indices[quad_i * 6 + index_i] = first_vertex + quad_indices[index_i];
+        }
+    }
+
+    uint32_t ebo;
+    glGenBuffers(1, &ebo);
+
+    // Unbind any vertex array so that binding the element buffer doesn't change its state.
+    glBindVertexArray(0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_count * sizeof(uint32_t), indices, GL_STATIC_DRAW);
+
+    free(indices);
+
+    return (struct IndexBuffer){
+        .ebo = ebo,
+        .max_quad_count = max_quad_count,
+    };
+}
+
+void index_buffer_destroy(struct IndexBuffer *index_buffer) {
+    glDeleteBuffers(1, &index_buffer->ebo);
+}
+
+struct Mesh mesh_create(uint32_t max_vertex_count, struct IndexBuffer *index_buffer) {
+    assert(max_vertex_count <= index_buffer->max_quad_count * 4);
 
-struct Mesh mesh_create(uint32_t max_vertex_count, uint32_t max_index_count) {
     uint32_t vbo;
     glGenBuffers(1, &vbo);
 
@@ -16,42 +52,48 @@ struct Mesh mesh_create(uint32_t max_vertex_count, uint32_t max_index_count) {
     glBindVertexArray(vao);
 
     glBindBuffer(GL_ARRAY_BUFFER, vbo);
-    glBufferData(GL_ARRAY_BUFFER, sizeof_vertex * max_vertex_count, NULL, GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(struct Vertex) * max_vertex_count, NULL, GL_STATIC_DRAW);
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof_vertex, (void *)0);
+    glVertexAttribPointer(0, 2, GL_UNSIGNED_SHORT, GL_FALSE, sizeof(struct Vertex), (void *)offsetof(struct Vertex, x));
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof_vertex, (void *)sizeof_vec3);
+    glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(struct Vertex), (void *)offsetof(struct Vertex, color));
     glEnableVertexAttribArray(1);
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof_vertex, (void *)(sizeof_vec3 * 2));
+    glVertexAttribIPointer(
+        2,
+        1,
+        GL_UNSIGNED_INT,
+        sizeof(struct Vertex),
+        (void *)offsetof(struct Vertex, alternate_color)
+    );
     glEnableVertexAttribArray(2);
+    glVertexAttribPointer(
+        3,
+        2,
+        GL_UNSIGNED_SHORT,
+        GL_FALSE,
+        sizeof(struct Vertex),
+        (void *)offsetof(struct Vertex, texture_x)
+    );
+    glEnableVertexAttribArray(3);
 
-    uint32_t ebo;
-    glGenBuffers(1, &ebo);
+    // The vertex array remembers the element buffer, so the shared indices only need to be bound once.
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer->ebo);
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(uint32_t) * max_index_count, NULL, GL_STATIC_DRAW);
+    glBindVertexArray(0);
 
     return (struct Mesh){
         .vao = vao,
         .vbo = vbo,
-        .ebo = ebo,
         .max_vertex_count = max_vertex_count,
-        .max_index_count = max_index_count,
         .index_count = 0,
     };
 }
 
-void mesh_update(
-    struct Mesh *mesh, const float *vertices, uint32_t vertex_count, const uint32_t *indices, uint32_t index_count
-) {
+void mesh_update(struct Mesh *mesh, const struct Vertex *vertices, uint32_t vertex_count, uint32_t index_count) {
     assert(vertex_count <= mesh->max_vertex_count);
-    assert(index_count <= mesh->max_index_count);
 
     glBindBuffer(GL_ARRAY_BUFFER, mesh->vbo);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof_vertex * vertex_count, vertices);
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->ebo);
-    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, sizeof(uint32_t) * index_count, indices);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(struct Vertex) * vertex_count, vertices);
 
     mesh->index_count = index_count;
 }
@@ -62,7 +104,6 @@ void mesh_draw(struct Mesh *mesh) {
     }
 
     glBindVertexArray(mesh->vao);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh->ebo);
     glDrawElements(GL_TRIANGLES, mesh->index_count, GL_UNSIGNED_INT, 0);
 }
 
@@ -72,6 +113,5 @@ void mesh_destroy(struct Mesh *mesh) {
     }
 
     glDeleteBuffers(1, &mesh->vbo);
-    glDeleteBuffers(1, &mesh->ebo);
     glDeleteVertexArrays(1, &mesh->vao);
 }
\ No newline at end of file
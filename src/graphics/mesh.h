@@ -7,20 +7,35 @@
 
 #include <inttypes.h>
 
-extern const size_t vertex_component_count;
+// Positions and texture coordinates are in pixels, texture coordinates are normalized in the shader.
+struct Vertex {
+    uint16_t x;
+    uint16_t y;
+    // Grid colors, resolved against the palette in the shader. The alternate color is used when selected.
+    uint32_t color;
+    uint32_t alternate_color;
+    uint16_t texture_x;
+    uint16_t texture_y;
+};
+
+// An immutable index buffer containing the same quad pattern repeated, shared by every mesh made of quads.
+struct IndexBuffer {
+    uint32_t ebo;
+    uint32_t max_quad_count;
+};
 
 struct Mesh {
     uint32_t vbo;
     uint32_t vao;
-    uint32_t ebo;
     uint32_t max_vertex_count;
-    uint32_t max_index_count;
     uint32_t index_count;
 };
 
-struct Mesh mesh_create(uint32_t max_vertex_count, uint32_t max_index_count);
-void mesh_update(
-    struct Mesh *mesh, const float *vertices, uint32_t vertex_count, const uint32_t *indices, uint32_t index_count);
+struct IndexBuffer index_buffer_create_quads(uint32_t max_quad_count);
+void index_buffer_destroy(struct IndexBuffer *index_buffer);
+
+struct Mesh mesh_create(uint32_t max_vertex_count, struct IndexBuffer *index_buffer);
+void mesh_update(struct Mesh *mesh, const struct Vertex *vertices, uint32_t vertex_count, uint32_t index_count);
 void mesh_draw(struct Mesh *mesh);
 void mesh_destroy(struct Mesh *mesh);
 
@@ -1,26 +1,112 @@
 #include "renderer.h"
 
 #include "../font.h"
+#include "../trace.h"
+#include <embedded_assets.h>
 #include <stdlib.h>
-
-struct Renderer renderer_create(size_t width, size_t height) {
-    glEnable(GL_DEPTH_TEST);
+#include <math.h>
+
+// Enough to cover scrolling back and forth over a few screens of history.
+#define RENDERER_ROW_CACHE_CAPACITY 512
+#define RENDERER_PREFETCH_ROW_COUNT 16
+// Extra rows above and below the screen, they're partially visible while scrolled by part of a row.
+#define RENDERER_OVERSCAN_ROW_COUNT 1
+// How quickly pending scroll distance is applied, higher values stop sooner.
+#define RENDERER_SCROLL_EASING_RATE 18.0f
+// Longer frames are treated as this long, so that the first frame after being idle doesn't skip the animation.
+#define RENDERER_SCROLL_MAX_DELTA_TIME (1.0f / 30.0f)
+// Waking the thread pool costs more than building a few rows, so smaller updates are built on the calling thread.
+#define RENDERER_MIN_PARALLEL_ROW_COUNT 8
+#define RENDERER_DEFAULT_ROW_BUILD_BUDGET 0.004
+// Enough for a glyph per character of a few lines of stats.
+#define RENDERER_HUD_SPRITE_CAPACITY 1024
+// The first and last lines of a selection can be partial, every line between them is drawn as one quad.
+#define RENDERER_SELECTION_SPRITE_CAPACITY 3
+// Selected cells show their foreground color as their background. Cells with default colors don't get a background box,
+// so the selection shows the default foreground underneath them.
+#define RENDERER_SELECTION_COLOR GRID_COLOR_FOREGROUND_DEFAULT
+#define RENDERER_HUD_BACKGROUND_COLOR (GRID_COLOR_TRUECOLOR | 0x202020)
+#define RENDERER_HUD_FOREGROUND_COLOR (GRID_COLOR_TRUECOLOR | 0xe0e0e0)
+
+static void renderer_prefetch_start(void *data);
+
+struct Renderer renderer_create(size_t width, size_t height, size_t thread_count) {
+    assert(thread_count > 0);
+
+    // Sprites are layered by the order they're drawn in, so there's no need for depth testing.
     glEnable(GL_CULL_FACE);
 
     struct Renderer renderer = (struct Renderer){
         .scale = 1,
-        .background_color = color_from_hex(GRID_COLOR_BACKGROUND_DEFAULT),
 
-        .program = program_create("assets/shader_2d.vert", "assets/shader_2d.frag"),
-        .texture_atlas = texture_create("assets/texture_atlas.png"),
+        .program = program_create(embedded_shader_2d_vert, embedded_shader_2d_frag),
+        .cursor_program = program_create(embedded_shader_cursor_vert, embedded_shader_cursor_frag),
+        .glyph_cache = glyph_cache_create(
+            embedded_texture_atlas_png.pixels,
+            embedded_texture_atlas_png.width,
+            embedded_texture_atlas_png.height
+        ),
+        .glyph_keys = list_create_uint32_t(16),
+        .changed_glyph_keys = list_create_uint32_t(64),
+        // Filled in from the grid's palette before the first draw.
+        .palette_texture = texture_create(NULL, GRID_PALETTE_LENGTH, 1),
+        .row_cache = row_cache_create(RENDERER_ROW_CACHE_CAPACITY),
+        // The thread that draws works on rows too, so it doesn't need a thread of its own.
+        .thread_pool = thread_pool_create(thread_count - 1),
+        .row_builds = list_create_struct_RendererRowBuild(64),
+        .row_build_budget = RENDERER_DEFAULT_ROW_BUILD_BUDGET,
 
         .needs_redraw = true,
     };
 
     renderer.projection_matrix_location = glGetUniformLocation(renderer.program, "projection_matrix");
     renderer.offset_y_location = glGetUniformLocation(renderer.program, "offset_y");
+    renderer.row_line_location = glGetUniformLocation(renderer.program, "row_line");
+    renderer.cell_width_location = glGetUniformLocation(renderer.program, "cell_width");
+    renderer.selection_start_location = glGetUniformLocation(renderer.program, "selection_start");
+    renderer.selection_end_location = glGetUniformLocation(renderer.program, "selection_end");
+    renderer.scroll_offset_location = glGetUniformLocation(renderer.program, "scroll_offset");
+
+    glUseProgram(renderer.program);
+    glUniform1i(glGetUniformLocation(renderer.program, "texture_sampler"), 0);
+    glUniform1i(glGetUniformLocation(renderer.program, "palette_sampler"), 1);
+
+    renderer.cursor_projection_matrix_location = glGetUniformLocation(renderer.cursor_program, "projection_matrix");
+    renderer.cursor_position_location = glGetUniformLocation(renderer.cursor_program, "cursor_position");
+    renderer.cursor_cell_size_location = glGetUniformLocation(renderer.cursor_program, "cell_size");
+    renderer.cursor_line_width_location = glGetUniformLocation(renderer.cursor_program, "line_width");
+    renderer.cursor_style_location = glGetUniformLocation(renderer.cursor_program, "cursor_style");
+    renderer.cursor_has_glyph_location = glGetUniformLocation(renderer.cursor_program, "has_glyph");
+    renderer.cursor_glyph_position_location = glGetUniformLocation(renderer.cursor_program, "glyph_position");
+
+    glUseProgram(renderer.cursor_program);
+    glUniform1i(glGetUniformLocation(renderer.cursor_program, "texture_sampler"), 0);
+    glUniform2f(glGetUniformLocation(renderer.cursor_program, "glyph_size"), FONT_GLYPH_WIDTH, FONT_GLYPH_HEIGHT);
+
+    // The cursor's vertices are generated from gl_VertexID, but core profiles still need a vertex array to draw.
+    glGenVertexArrays(1, &renderer.cursor_vao);
+
+    struct RowPrefetchShared *prefetch_shared = malloc(sizeof(struct RowPrefetchShared));
+    assert(prefetch_shared);
+
+    *prefetch_shared = (struct RowPrefetchShared){
+        .requests = list_create_struct_RowPrefetchRequest(RENDERER_PREFETCH_ROW_COUNT),
+        .results = list_create_struct_RowPrefetchResult(RENDERER_PREFETCH_ROW_COUNT),
+    };
+
+    mutex_init(&prefetch_shared->mutex);
+    condition_variable_init(&prefetch_shared->has_requests);
 
-    renderer_resize(&renderer, width, height, renderer.scale);
+    renderer.prefetch_shared = prefetch_shared;
+    renderer.prefetch_thread = thread_create(renderer_prefetch_start, prefetch_shared);
+
+    renderer.selection_index_buffer = index_buffer_create_quads(RENDERER_SELECTION_SPRITE_CAPACITY);
+    renderer.selection_sprite_batch =
+        sprite_batch_create(RENDERER_SELECTION_SPRITE_CAPACITY, &renderer.selection_index_buffer);
+    renderer.hud_index_buffer = index_buffer_create_quads(RENDERER_HUD_SPRITE_CAPACITY);
+    renderer.hud_sprite_batch = sprite_batch_create(RENDERER_HUD_SPRITE_CAPACITY, &renderer.hud_index_buffer);
+
+    renderer_resize(&renderer, width, height);
 
     return renderer;
 }
@@ -30,10 +116,15 @@ void renderer_on_row_changed_callback(void *context, int32_t y) {
     renderer_on_row_changed(renderer, y);
 }
 
+void renderer_on_cursor_changed_callback(void *context) {
+    struct Renderer *renderer = context;
+    renderer->needs_redraw = true;
+}
+
 void renderer_on_row_changed(struct Renderer *renderer, int32_t y) {
-    int32_t sprite_batch_y = y + renderer->scrollback_distance;
+    int32_t sprite_batch_y = y + renderer->scrollback_distance + RENDERER_OVERSCAN_ROW_COUNT;
 
-    if (sprite_batch_y >= renderer->sprite_batch_count) {
+    if (sprite_batch_y < 0 || sprite_batch_y >= renderer->sprite_batch_count) {
         return;
     }
 
@@ -41,127 +132,105 @@ void renderer_on_row_changed(struct Renderer *renderer, int32_t y) {
     renderer->needs_redraw = true;
 }
 
-static void renderer_on_selection_changed(struct Renderer *renderer, struct Selection *old_selection) {
-    struct Selection sorted_old_selection = selection_sorted(old_selection);
-    struct Selection sorted_new_selection = selection_sorted(&renderer->selection);
-
-    int32_t min_y = int32_min(sorted_old_selection.start_y, sorted_new_selection.start_y);
-    int32_t max_y = int32_max(sorted_old_selection.end_y, sorted_new_selection.end_y);
-
-    for (int32_t y = min_y; y <= max_y; y++) {
-        renderer_on_row_changed(renderer, y);
-    }
-}
-
-static void renderer_on_scroll(struct Renderer *renderer) {
-    renderer_on_selection_changed(renderer, &renderer->selection);
-}
-
 void renderer_clear_selection(struct Renderer *renderer) {
-    renderer_on_selection_changed(renderer, &renderer->selection);
     renderer->selection_state = SELECTION_STATE_NONE;
+    renderer->needs_redraw = true;
 }
 
-void renderer_set_selection_start(struct Renderer *renderer, uint32_t x, uint32_t y) {
-    struct Selection old_selection = renderer->selection;
+// Selections are stored in absolute lines, where line 0 is the oldest scrollback line. That way they stay attached
+// to the same text while scrolling or when new lines are pushed into the scrollback.
+static int32_t renderer_get_absolute_line(struct Renderer *renderer, struct Grid *grid, int32_t y) {
+    return grid->scrollback_lines.length - renderer->scrollback_distance + y;
+}
 
+void renderer_set_selection_start(struct Renderer *renderer, struct Grid *grid, uint32_t x, int32_t y) {
     renderer->selection.start_x = x;
-    renderer->selection.start_y = y - renderer->scrollback_distance;
+    renderer->selection.start_y = renderer_get_absolute_line(renderer, grid, y);
 
     renderer->selection_state = SELECTION_STATE_STARTED;
-
-    renderer_on_selection_changed(renderer, &old_selection);
+    renderer->needs_redraw = true;
 }
 
-void renderer_set_selection_end(struct Renderer *renderer, uint32_t x, uint32_t y) {
+void renderer_set_selection_end(struct Renderer *renderer, struct Grid *grid, uint32_t x, int32_t y) {
     if (renderer->selection_state == SELECTION_STATE_NONE) {
         return;
     }
 
-    struct Selection old_selection = renderer->selection;
-
     renderer->selection.end_x = x;
-    renderer->selection.end_y = y - renderer->scrollback_distance;
+    renderer->selection.end_y = renderer_get_absolute_line(renderer, grid, y);
 
     renderer->selection_state = SELECTION_STATE_FINISHED;
-
-    renderer_on_selection_changed(renderer, &old_selection);
+    renderer->needs_redraw = true;
 }
 
-static int32_t renderer_get_visible_scrollback_line_count(struct Renderer *renderer) {
-    int32_t visible_scrollback_line_count = renderer->scrollback_distance;
-    if (visible_scrollback_line_count > renderer->sprite_batch_count) {
-        visible_scrollback_line_count = renderer->sprite_batch_count;
-    }
-
-    return visible_scrollback_line_count;
-}
+// Sprites are positioned in whole pixels, so lines have to fit exactly in the middle of their cells.
+_Static_assert((FONT_GLYPH_WIDTH - FONT_LINE_WIDTH) % 2 == 0, "Lines can't be centered horizontally");
+_Static_assert((FONT_GLYPH_HEIGHT - FONT_LINE_WIDTH) % 2 == 0, "Lines can't be centered vertically");
 
 static void renderer_draw_horizontal_line(
-    struct SpriteBatch *sprite_batch,
+    struct List_struct_Sprite *sprites,
     int32_t x,
     int32_t offset_x,
-    int32_t z,
     int32_t width,
-    float scale,
-    float r,
-    float g,
-    float b
+    uint32_t color,
+    uint32_t alternate_color
 ) {
-    sprite_batch_add(
-        sprite_batch,
+
+    list_push_struct_Sprite(
+        sprites,
         (struct Sprite){
-            .x = (x * FONT_GLYPH_WIDTH + offset_x) * scale,
-            .y = (FONT_GLYPH_HEIGHT - FONT_LINE_WIDTH) * 0.5f * scale,
-            .z = z,
-            .width = width * scale,
-            .height = FONT_LINE_WIDTH * scale,
+            .x = x * FONT_GLYPH_WIDTH + offset_x,
+            .y = (FONT_GLYPH_HEIGHT - FONT_LINE_WIDTH) / 2,
+            .width = width,
+            .height = FONT_LINE_WIDTH,
 
             .texture_x = 0,
             .texture_width = FONT_GLYPH_WIDTH,
             .texture_height = FONT_LINE_WIDTH,
 
-            .r = r,
-            .g = g,
-            .b = b,
+            .color = color,
+            .alternate_color = alternate_color,
         }
     );
 }
 
 static void renderer_draw_vertical_line(
-    struct SpriteBatch *sprite_batch,
+    struct List_struct_Sprite *sprites,
     int32_t x,
     int32_t offset_y,
-    int32_t z,
     int32_t height,
-    float scale,
-    float r,
-    float g,
-    float b
+    uint32_t color,
+    uint32_t alternate_color
 ) {
-    sprite_batch_add(
-        sprite_batch,
+
+    list_push_struct_Sprite(
+        sprites,
         (struct Sprite){
-            .x = (x * FONT_GLYPH_WIDTH + (FONT_GLYPH_WIDTH - FONT_LINE_WIDTH) * 0.5f) * scale,
-            .y = offset_y * scale,
-            .z = z,
-            .width = FONT_LINE_WIDTH * scale,
-            .height = height * scale,
+            .x = x * FONT_GLYPH_WIDTH + (FONT_GLYPH_WIDTH - FONT_LINE_WIDTH) / 2,
+            .y = offset_y,
+            .width = FONT_LINE_WIDTH,
+            .height = height,
 
             .texture_x = 0,
             .texture_width = FONT_LINE_WIDTH,
             .texture_height = FONT_GLYPH_HEIGHT,
 
-            .r = r,
-            .g = g,
-            .b = b,
+            .color = color,
+            .alternate_color = alternate_color,
         }
     );
 }
 
 static void renderer_draw_character(
-    uint32_t character, struct SpriteBatch *sprite_batch, int32_t x, int32_t z, float scale, float r, float g, float b
+    uint32_t character,
+    struct GlyphCache *glyph_cache,
+    struct List_uint32_t *glyph_keys,
+    struct List_struct_Sprite *sprites,
+    int32_t x,
+    uint32_t color,
+    uint32_t alternate_color
 ) {
+
     if (character == ' ') {
         return;
     }
@@ -174,316 +243,746 @@ static void renderer_draw_character(
     switch (character) {
         case 0x2500: {
             // Thin horizontal line:
-            renderer_draw_horizontal_line(sprite_batch, x, 0, z, FONT_GLYPH_WIDTH, scale, r, g, b);
+            renderer_draw_horizontal_line(sprites, x, 0, FONT_GLYPH_WIDTH, color, alternate_color);
             return;
         }
         case 0x2502: {
             // Thin vertical line:
-            renderer_draw_vertical_line(sprite_batch, x, 0, z, FONT_GLYPH_HEIGHT, scale, r, g, b);
+            renderer_draw_vertical_line(sprites, x, 0, FONT_GLYPH_HEIGHT, color, alternate_color);
             return;
         }
         case 0x250C: {
             // Thin top left corner:
-            renderer_draw_horizontal_line(sprite_batch, x, corner_left, z, corner_right, scale, r, g, b);
-            renderer_draw_vertical_line(sprite_batch, x, 0, z, corner_top, scale, r, g, b);
+            renderer_draw_horizontal_line(sprites, x, corner_left, corner_right, color, alternate_color);
+            renderer_draw_vertical_line(sprites, x, 0, corner_top, color, alternate_color);
             return;
         }
         case 0x2510: {
             // Thin top right corner:
-            renderer_draw_horizontal_line(sprite_batch, x, 0, z, corner_right, scale, r, g, b);
-            renderer_draw_vertical_line(sprite_batch, x, 0, z, corner_top, scale, r, g, b);
+            renderer_draw_horizontal_line(sprites, x, 0, corner_right, color, alternate_color);
+            renderer_draw_vertical_line(sprites, x, 0, corner_top, color, alternate_color);
             return;
         }
         case 0x2514: {
             // Thin bottom left corner:
-            renderer_draw_horizontal_line(sprite_batch, x, corner_left, z, corner_right, scale, r, g, b);
-            renderer_draw_vertical_line(sprite_batch, x, corner_bottom, z, corner_top, scale, r, g, b);
+            renderer_draw_horizontal_line(sprites, x, corner_left, corner_right, color, alternate_color);
+            renderer_draw_vertical_line(sprites, x, corner_bottom, corner_top, color, alternate_color);
             return;
         }
         case 0x2518: {
             // Thin bottom right corner:
-            renderer_draw_horizontal_line(sprite_batch, x, 0, z, corner_right, scale, r, g, b);
-            renderer_draw_vertical_line(sprite_batch, x, corner_bottom, z, corner_top, scale, r, g, b);
+            renderer_draw_horizontal_line(sprites, x, 0, corner_right, color, alternate_color);
+            renderer_draw_vertical_line(sprites, x, corner_bottom, corner_top, color, alternate_color);
             return;
         }
     }
 
-    uint32_t atlas_x = int32_min(character - 32, FONT_LENGTH);
+    uint16_t texture_x;
+    uint16_t texture_y;
+    glyph_cache_get(glyph_cache, character, GLYPH_STYLE_REGULAR, &texture_x, &texture_y, glyph_keys);
 
-    sprite_batch_add(
-        sprite_batch,
+    list_push_struct_Sprite(
+        sprites,
         (struct Sprite){
-            .x = x * FONT_GLYPH_WIDTH * scale,
-            .z = z,
-            .width = FONT_GLYPH_WIDTH * scale,
-            .height = FONT_GLYPH_HEIGHT * scale,
+            .x = x * FONT_GLYPH_WIDTH,
+            .width = FONT_GLYPH_WIDTH,
+            .height = FONT_GLYPH_HEIGHT,
 
-            .texture_x = (FONT_GLYPH_WIDTH + FONT_GLYPH_PADDING) * atlas_x,
+            .texture_x = texture_x,
+            .texture_y = texture_y,
             .texture_width = FONT_GLYPH_WIDTH,
             .texture_height = FONT_GLYPH_HEIGHT,
 
-            .r = r,
-            .g = g,
-            .b = b,
+            .color = color,
+            .alternate_color = alternate_color,
         }
     );
 }
 
 static void renderer_draw_box(
-    struct SpriteBatch *sprite_batch, int32_t x, int32_t z, float scale, float r, float g, float b
+    struct List_struct_Sprite *sprites, int32_t x, int32_t width, uint32_t color, uint32_t alternate_color
 ) {
-    sprite_batch_add(
-        sprite_batch,
+
+    list_push_struct_Sprite(
+        sprites,
         (struct Sprite){
-            .x = x * FONT_GLYPH_WIDTH * scale,
-            .z = z,
-            .width = FONT_GLYPH_WIDTH * scale,
-            .height = FONT_GLYPH_HEIGHT * scale,
+            .x = x * FONT_GLYPH_WIDTH,
+            .width = width * FONT_GLYPH_WIDTH,
+            .height = FONT_GLYPH_HEIGHT,
 
             .texture_x = 0,
             .texture_width = FONT_GLYPH_WIDTH,
             .texture_height = FONT_GLYPH_HEIGHT,
 
-            .r = r,
-            .g = g,
-            .b = b,
+            .color = color,
+            .alternate_color = alternate_color,
         }
     );
 }
 
-static void renderer_draw_bar(
-    struct SpriteBatch *sprite_batch, int32_t x, int32_t z, float scale, float r, float g, float b
+static void renderer_get_row_tile(
+    struct RendererRow *row, int32_t x, uint32_t *character, uint32_t *foreground_color, uint32_t *background_color
 ) {
-    sprite_batch_add(
-        sprite_batch,
-        (struct Sprite){
-            .x = x * FONT_GLYPH_WIDTH * scale,
-            .z = z,
-            .width = FONT_LINE_WIDTH * scale,
-            .height = FONT_GLYPH_HEIGHT * scale,
 
-            .texture_x = 0,
-            .texture_width = FONT_LINE_WIDTH,
-            .texture_height = FONT_GLYPH_HEIGHT,
+    *character = ' ';
+    *background_color = GRID_COLOR_BACKGROUND_DEFAULT;
+    *foreground_color = GRID_COLOR_FOREGROUND_DEFAULT;
 
-            .r = r,
-            .g = g,
-            .b = b,
-        }
-    );
+    if (x < row->length) {
+        *character = row->data[x];
+        *background_color = row->background_colors[x];
+        *foreground_color = row->foreground_colors[x];
+    }
 }
 
-static void renderer_draw_underline(
-    struct SpriteBatch *sprite_batch, int32_t x, int32_t z, float scale, float r, float g, float b
+// Rows are built without knowing about the selection, so changing the selection never requires rebuilding rows.
+// Sprites store the color they should have while selected for the shader to pick, backgrounds store the cell's
+// foreground and characters store the cell's background. Cells with default colors are covered by the selection
+// that's drawn underneath the rows instead.
+// Rows only depend on the arguments passed here so that they can also be built on the prefetch thread. The keys of
+// the glyphs the row uses are pushed to glyph_keys.
+static void renderer_build_row(
+    struct GlyphCache *glyph_cache,
+    size_t width,
+    struct RendererRow *row,
+    struct List_struct_Sprite *sprites,
+    struct List_uint32_t *glyph_keys
 ) {
-    sprite_batch_add(
-        sprite_batch,
-        (struct Sprite){
-            .x = x * FONT_GLYPH_WIDTH * scale,
-            .z = z,
-            .width = FONT_GLYPH_WIDTH * scale,
-            .height = FONT_LINE_WIDTH * scale,
 
-            .texture_x = 0,
-            .texture_width = FONT_GLYPH_WIDTH,
-            .texture_height = FONT_LINE_WIDTH,
+    uint32_t character;
+    uint32_t foreground_color;
+    uint32_t background_color;
+
+    // Draw backgrounds, merging runs of tiles with the same colors into a single box. Runs with both default colors
+    // are skipped, the clear color and the selection already cover them.
+    int32_t run_start_x = 0;
+    uint32_t run_background_color = GRID_COLOR_BACKGROUND_DEFAULT;
+    uint32_t run_foreground_color = GRID_COLOR_FOREGROUND_DEFAULT;
 
-            .r = r,
-            .g = g,
-            .b = b,
+    for (int32_t x = 0; x <= width; x++) {
+        bool is_row_end = x == width;
+
+        if (!is_row_end) {
+            renderer_get_row_tile(row, x, &character, &foreground_color, &background_color);
+
+            if (background_color == run_background_color && foreground_color == run_foreground_color) {
+                continue;
+            }
         }
-    );
+
+        bool is_run_default = run_background_color == GRID_COLOR_BACKGROUND_DEFAULT &&
+                              run_foreground_color == GRID_COLOR_FOREGROUND_DEFAULT;
+
+        if (x > run_start_x && !is_run_default) {
+            renderer_draw_box(sprites, run_start_x, x - run_start_x, run_background_color, run_foreground_color);
+        }
+
+        run_start_x = x;
+        run_background_color = background_color;
+        run_foreground_color = foreground_color;
+    }
+
+    // Draw characters after the backgrounds so that they end up on top.
+    for (int32_t x = 0; x < width; x++) {
+        renderer_get_row_tile(row, x, &character, &foreground_color, &background_color);
+
+        if (character == ' ') {
+            continue;
+        }
+
+        renderer_draw_character(character, glyph_cache, glyph_keys, sprites, x, foreground_color, background_color);
+    }
 }
 
-static void renderer_draw_tile(
-    uint32_t character,
-    struct Color foreground_color,
-    struct Color background_color,
-    struct SpriteBatch *sprite_batch,
-    int32_t x,
-    int32_t z,
-    float scale
-) {
+// A slice of the queued rows, built by the thread pool.
+struct RendererRowBuildSlice {
+    struct Renderer *renderer;
+    struct RendererRowBuild *row_builds;
+};
+
+// Builds a row's sprites and vertices on one of the thread pool's threads. Each row only writes to its own sprite
+// batch, so rows can be built in any order.
+static void renderer_build_row_task(void *data, size_t task_i, size_t worker_i) {
+    struct RendererRowBuildSlice *slice = data;
+    struct Renderer *renderer = slice->renderer;
+    struct RendererRowBuild *row_build = &slice->row_builds[task_i];
+    struct SpriteBatch *sprite_batch = &renderer->sprite_batches[row_build->sprite_batch_i];
+    struct List_uint32_t *glyph_keys = &renderer->sprite_batch_glyph_keys[row_build->sprite_batch_i];
+
+    TRACE_BEGIN("build row");
+
+    list_reset_struct_Sprite(&sprite_batch->sprites);
+    list_reset_uint32_t(glyph_keys);
+
+    if (row_build->has_row) {
+        renderer_build_row(
+            &renderer->glyph_cache,
+            renderer->width,
+            &row_build->row,
+            &sprite_batch->sprites,
+            glyph_keys
+        );
+    }
 
-    renderer_draw_box(sprite_batch, x, z, scale, background_color.r, background_color.g, background_color.b);
-    renderer_draw_character(
-        character,
-        sprite_batch,
-        x,
-        z + 1,
-        scale,
-        foreground_color.r,
-        foreground_color.g,
-        foreground_color.b
-    );
+    sprite_batch_build_vertices(&sprite_batch->sprites, &sprite_batch->vertices);
+
+    TRACE_END();
 }
 
-static void renderer_draw_cursor(
-    struct Grid *grid, struct SpriteBatch *sprite_batch, int32_t x, int32_t y, int32_t z, float scale
-) {
+// Queues a dirty row to be built, scrollback lines come from the row cache when possible. Rows past either end of
+// the scrollback and grid are left empty.
+static void renderer_queue_row(struct Renderer *renderer, struct Grid *grid, size_t i) {
+    if (!renderer->are_sprite_batches_dirty[i]) {
+        return;
+    }
+
+    struct SpriteBatch *sprite_batch = &renderer->sprite_batches[i];
+
+    int32_t line = renderer_get_absolute_line(renderer, grid, (int32_t)i - RENDERER_OVERSCAN_ROW_COUNT);
+    int32_t grid_y = line - (int32_t)grid->scrollback_lines.length;
+    bool is_scrollback_line = line >= 0 && grid_y < 0;
+
+    struct RendererRowBuild row_build = {
+        .sprite_batch_i = i,
+        .line = line,
+        .is_scrollback_line = is_scrollback_line,
+    };
+
+    if (is_scrollback_line) {
+        struct RowCacheEntry *cached_row = row_cache_get(&renderer->row_cache, line);
+        if (cached_row) {
+            struct List_struct_Vertex *cached_vertices = &cached_row->vertices;
+            sprite_batch_set_vertices(sprite_batch, cached_vertices->data, cached_vertices->length);
+            renderer->are_sprite_batches_dirty[i] = false;
+            renderer->frame_stats.upload_byte_count += cached_vertices->length * sizeof(struct Vertex);
+
+            struct List_uint32_t *glyph_keys = &renderer->sprite_batch_glyph_keys[i];
+            list_reset_uint32_t(glyph_keys);
+
+            for (size_t key_i = 0; key_i < cached_row->glyph_keys.length; key_i++) {
+                list_push_uint32_t(glyph_keys, cached_row->glyph_keys.data[key_i]);
+            }
 
-    if (x >= grid->width) {
-        x = grid->width - 1;
+            return;
+        }
+
+        struct ScrollbackLine *scrollback_line = &grid->scrollback_lines.data[line];
+
+        row_build.has_row = true;
+        row_build.row = (struct RendererRow){
+            .data = scrollback_line->data,
+            .background_colors = scrollback_line->background_colors,
+            .foreground_colors = scrollback_line->foreground_colors,
+            .length = scrollback_line->length,
+        };
+    } else if (line >= 0 && grid_y < grid->height) {
+        size_t row_start_i = grid_y * grid->width;
+
+        row_build.has_row = true;
+        row_build.row = (struct RendererRow){
+            .data = grid->data + row_start_i,
+            .background_colors = grid->background_colors + row_start_i,
+            .foreground_colors = grid->foreground_colors + row_start_i,
+            .length = grid->width,
+        };
     }
 
-    switch (grid->cursor_style) {
-        case GRID_CURSOR_STYLE_BLOCK: {
-            renderer_draw_box(sprite_batch, x, z, scale, 1.0f, 1.0f, 1.0f);
+    list_push_struct_RendererRowBuild(&renderer->row_builds, row_build);
+}
 
-            uint32_t character = grid->data[x + y * grid->width];
-            renderer_draw_character(character, sprite_batch, x, z + 1, scale, 0.0f, 0.0f, 0.0f);
-            break;
+// Rebuilds dirty rows, starting with the cursor's row and moving outwards from it, so the rows that input echoes to
+// are always up to date. Rows are built in slices that are spread across the thread pool, then uploaded in order on
+// the calling thread since it's the only one with the GL context. Once a slice takes the frame over its budget the
+// remaining rows are left dirty, they keep showing their previous contents until a later frame gets to them.
+static void renderer_update_rows(struct Renderer *renderer, struct Grid *grid) {
+    double start_time = glfwGetTime();
+
+    struct List_struct_RendererRowBuild *row_builds = &renderer->row_builds;
+    list_reset_struct_RendererRowBuild(row_builds);
+
+    TRACE_BEGIN("queue rows");
+
+    int32_t sprite_batch_count = (int32_t)renderer->sprite_batch_count;
+    int32_t cursor_i = grid->cursor_y + renderer->scrollback_distance + RENDERER_OVERSCAN_ROW_COUNT;
+    cursor_i = int32_clamp(cursor_i, 0, sprite_batch_count - 1);
+
+    for (int32_t distance = 0; distance < sprite_batch_count; distance++) {
+        int32_t above_i = cursor_i - distance;
+        int32_t below_i = cursor_i + distance;
+
+        if (above_i >= 0) {
+            renderer_queue_row(renderer, grid, above_i);
+        }
+
+        if (distance > 0 && below_i < sprite_batch_count) {
+            renderer_queue_row(renderer, grid, below_i);
         }
-        case GRID_CURSOR_STYLE_UNDERLINE: {
-            renderer_draw_underline(sprite_batch, x, z, scale, 1.0f, 1.0f, 1.0f);
+
+        if (above_i < 0 && below_i >= sprite_batch_count) {
             break;
         }
-        case GRID_CURSOR_STYLE_BAR: {
-            renderer_draw_bar(sprite_batch, x, z, scale, 1.0f, 1.0f, 1.0f);
+    }
+
+    TRACE_END();
+
+    // Slices are large enough to give every thread a couple of rows.
+    size_t slice_length = thread_pool_get_worker_count(&renderer->thread_pool) * 2;
+    if (slice_length < RENDERER_MIN_PARALLEL_ROW_COUNT) {
+        slice_length = RENDERER_MIN_PARALLEL_ROW_COUNT;
+    }
+
+    size_t built_row_count = 0;
+
+    while (built_row_count < row_builds->length) {
+        struct RendererRowBuildSlice slice = {
+            .renderer = renderer,
+            .row_builds = row_builds->data + built_row_count,
+        };
+        size_t slice_row_count = row_builds->length - built_row_count;
+        if (slice_row_count > slice_length) {
+            slice_row_count = slice_length;
+        }
+
+        double slice_start_time = glfwGetTime();
+        TRACE_BEGIN("build rows");
+
+        if (slice_row_count < RENDERER_MIN_PARALLEL_ROW_COUNT) {
+            for (size_t i = 0; i < slice_row_count; i++) {
+                renderer_build_row_task(&slice, i, 0);
+            }
+        } else {
+            thread_pool_run(&renderer->thread_pool, slice_row_count, renderer_build_row_task, &slice);
+        }
+
+        renderer->frame_stats.build_time += glfwGetTime() - slice_start_time;
+        TRACE_END();
+
+        TRACE_BEGIN("upload rows");
+
+        for (size_t i = 0; i < slice_row_count; i++) {
+            struct RendererRowBuild *row_build = &slice.row_builds[i];
+            struct SpriteBatch *sprite_batch = &renderer->sprite_batches[row_build->sprite_batch_i];
+            struct List_struct_Vertex *vertices = &sprite_batch->vertices;
+
+            sprite_batch_set_vertices(sprite_batch, vertices->data, vertices->length);
+            renderer->are_sprite_batches_dirty[row_build->sprite_batch_i] = false;
+            renderer->frame_stats.upload_byte_count += vertices->length * sizeof(struct Vertex);
+
+            if (row_build->is_scrollback_line) {
+                struct List_uint32_t *glyph_keys = &renderer->sprite_batch_glyph_keys[row_build->sprite_batch_i];
+
+                row_cache_put(
+                    &renderer->row_cache,
+                    row_build->line,
+                    vertices->data,
+                    vertices->length,
+                    glyph_keys->data,
+                    glyph_keys->length
+                );
+            }
+        }
+
+        TRACE_END();
+
+        built_row_count += slice_row_count;
+
+        if (glfwGetTime() - start_time > renderer->row_build_budget) {
             break;
         }
     }
+
+    renderer->has_pending_rows = built_row_count < row_builds->length;
+    renderer->frame_stats.built_row_count = built_row_count;
 }
 
-static void renderer_apply_selection_colors(
-    struct Renderer *renderer,
-    struct Selection *sorted_selection,
-    int32_t x,
-    int32_t y,
-    struct Color *foreground_color,
-    struct Color *background_color
-) {
+static void renderer_prefetch_start(void *data) {
+    struct RowPrefetchShared *shared = data;
+    struct List_struct_Sprite sprites = list_create_struct_Sprite(256);
+    struct List_uint32_t glyph_keys = list_create_uint32_t(16);
 
-    if (renderer->selection_state != SELECTION_STATE_FINISHED || !selection_contains_point(sorted_selection, x, y)) {
-        return;
+    TRACE_SET_THREAD_NAME("row prefetcher");
+
+    mutex_lock(&shared->mutex);
+
+    while (true) {
+        while (shared->requests.length == 0 && !shared->should_stop) {
+            condition_variable_wait(&shared->has_requests, &shared->mutex);
+        }
+
+        if (shared->should_stop) {
+            break;
+        }
+
+        struct RowPrefetchRequest request = list_pop_struct_RowPrefetchRequest(&shared->requests);
+        struct GlyphCache *glyph_cache = shared->glyph_cache;
+        size_t width = shared->width;
+        uint32_t generation = shared->generation;
+        uint32_t glyph_generation = shared->glyph_generation;
+
+        mutex_unlock(&shared->mutex);
+        TRACE_BEGIN("prefetch row");
+
+        struct RendererRow row = {
+            .data = request.scrollback_line.data,
+            .background_colors = request.scrollback_line.background_colors,
+            .foreground_colors = request.scrollback_line.foreground_colors,
+            .length = request.scrollback_line.length,
+        };
+
+        list_reset_struct_Sprite(&sprites);
+        list_reset_uint32_t(&glyph_keys);
+        renderer_build_row(glyph_cache, width, &row, &sprites, &glyph_keys);
+
+        // Lists can't grow from a capacity of zero, which an empty row would otherwise have.
+        struct RowPrefetchResult result = {
+            .line = request.line,
+            .generation = generation,
+            .glyph_generation = glyph_generation,
+            .vertices = list_create_struct_Vertex(sprites.length * 4 + 1),
+            .glyph_keys = list_create_uint32_t(glyph_keys.length + 1),
+        };
+        sprite_batch_build_vertices(&sprites, &result.vertices);
+
+        for (size_t i = 0; i < glyph_keys.length; i++) {
+            list_push_uint32_t(&result.glyph_keys, glyph_keys.data[i]);
+        }
+
+        TRACE_END();
+        mutex_lock(&shared->mutex);
+
+        list_push_struct_RowPrefetchResult(&shared->results, result);
     }
 
-    struct Color old_background_color = *background_color;
-    *background_color = *foreground_color;
-    *foreground_color = old_background_color;
+    mutex_unlock(&shared->mutex);
+
+    list_destroy_struct_Sprite(&sprites);
+    list_destroy_uint32_t(&glyph_keys);
 }
 
-static void renderer_draw_scrollback(
-    struct Renderer *renderer, struct Grid *grid, int32_t visible_scrollback_line_count
-) {
+// Moves prefetched rows into the row cache, rows built before the cache was last cleared, or built with glyphs that
+// have changed since, are thrown away. Glyphs that kept rows are requested now so they're ready once they're visible.
+static void renderer_collect_prefetched_rows(struct Renderer *renderer) {
+    struct RowPrefetchShared *shared = renderer->prefetch_shared;
 
-    struct Selection sorted_selection = selection_sorted(&renderer->selection);
+    mutex_lock(&shared->mutex);
 
-    for (size_t y = 0; y < visible_scrollback_line_count; y++) {
-        if (!renderer->are_sprite_batches_dirty[y]) {
-            continue;
+    for (size_t i = 0; i < shared->results.length; i++) {
+        struct RowPrefetchResult *result = &shared->results.data[i];
+        struct List_uint32_t *glyph_keys = &result->glyph_keys;
+
+        bool is_current = result->generation == shared->generation &&
+                          (result->glyph_generation == shared->glyph_generation || glyph_keys->length == 0);
+
+        if (is_current) {
+            row_cache_put(
+                &renderer->row_cache,
+                result->line,
+                result->vertices.data,
+                result->vertices.length,
+                glyph_keys->data,
+                glyph_keys->length
+            );
+            glyph_cache_use(&renderer->glyph_cache, glyph_keys->data, glyph_keys->length);
         }
-        renderer->are_sprite_batches_dirty[y] = false;
 
-        struct SpriteBatch *sprite_batch = &renderer->sprite_batches[y];
+        list_destroy_struct_Vertex(&result->vertices);
+        list_destroy_uint32_t(glyph_keys);
+    }
+
+    list_reset_struct_RowPrefetchResult(&shared->results);
 
-        sprite_batch_begin(sprite_batch);
+    mutex_unlock(&shared->mutex);
+}
 
-        size_t scrollback_y = grid->scrollback_lines.length - renderer->scrollback_distance + y;
-        size_t scrollback_line_length = grid->scrollback_lines.data[scrollback_y].length;
-        if (scrollback_line_length > grid->width) {
-            scrollback_line_length = grid->width;
-        }
+// Requests the scrollback lines just past the screen in the direction of the last scroll, replacing any requests
+// that haven't been started yet since they're for an older scroll position.
+static void renderer_prefetch_rows(struct Renderer *renderer, struct Grid *grid) {
+    struct RowPrefetchShared *shared = renderer->prefetch_shared;
+
+    mutex_lock(&shared->mutex);
+
+    list_reset_struct_RowPrefetchRequest(&shared->requests);
+
+    if (renderer->scroll_direction != 0) {
+        int32_t first_line = renderer_get_absolute_line(renderer, grid, -RENDERER_OVERSCAN_ROW_COUNT);
 
-        for (size_t x = 0; x < grid->width; x++) {
-            uint32_t character = ' ';
-            uint32_t background_hex_color = GRID_COLOR_BACKGROUND_DEFAULT;
-            uint32_t foreground_hex_color = GRID_COLOR_FOREGROUND_DEFAULT;
+        shared->glyph_cache = &renderer->glyph_cache;
+        shared->width = grid->width;
 
-            if (x < scrollback_line_length) {
-                character = grid->scrollback_lines.data[scrollback_y].data[x];
-                background_hex_color = grid->scrollback_lines.data[scrollback_y].background_colors[x];
-                foreground_hex_color = grid->scrollback_lines.data[scrollback_y].foreground_colors[x];
+        // Push the furthest lines first so that the closest ones are built first.
+        for (int32_t i = RENDERER_PREFETCH_ROW_COUNT; i > 0; i--) {
+            int32_t line = first_line - i;
+            if (renderer->scroll_direction > 0) {
+                line = first_line + renderer->sprite_batch_count - 1 + i;
             }
 
-            struct Color background_color = color_from_hex(background_hex_color);
-            struct Color foreground_color = color_from_hex(foreground_hex_color);
+            if (line < 0 || line >= grid->scrollback_lines.length || row_cache_contains(&renderer->row_cache, line)) {
+                continue;
+            }
 
-            renderer_apply_selection_colors(
-                renderer,
-                &sorted_selection,
-                x,
-                -renderer->scrollback_distance + y,
-                &foreground_color,
-                &background_color
+            list_push_struct_RowPrefetchRequest(
+                &shared->requests,
+                (struct RowPrefetchRequest){
+                    .line = line,
+                    .scrollback_line = grid->scrollback_lines.data[line],
+                }
             );
-            renderer_draw_tile(character, foreground_color, background_color, sprite_batch, x, 0, renderer->scale);
         }
 
-        sprite_batch_end(sprite_batch, renderer->texture_atlas.width, renderer->texture_atlas.height);
+        if (shared->requests.length > 0) {
+            condition_variable_signal(&shared->has_requests);
+        }
+    }
+
+    mutex_unlock(&shared->mutex);
+}
+
+// The cursor is drawn on top of the rows as a single quad generated in the vertex shader, so moving it or changing
+// its style only changes uniforms and never touches row data.
+static void renderer_draw_cursor(struct Renderer *renderer, struct Grid *grid, int32_t origin_y) {
+    int32_t cursor_row = grid->cursor_y + renderer->scrollback_distance;
+    int32_t row_count = renderer->sprite_batch_count - RENDERER_OVERSCAN_ROW_COUNT * 2;
+
+    if (!grid->should_show_cursor || cursor_row < -RENDERER_OVERSCAN_ROW_COUNT || cursor_row >= row_count) {
+        return;
+    }
+
+    int32_t cursor_x = int32_min(grid->cursor_x, grid->width - 1);
+    uint32_t character = grid->data[cursor_x + grid->cursor_y * grid->width];
+
+    // Block cursors show the character underneath them, inverted.
+    uint16_t glyph_texture_x = 0;
+    uint16_t glyph_texture_y = 0;
+    bool has_glyph = grid->cursor_style == GRID_CURSOR_STYLE_BLOCK && character != ' ';
+    if (has_glyph) {
+        struct List_uint32_t *glyph_keys = &renderer->glyph_keys;
+        list_reset_uint32_t(glyph_keys);
+
+        glyph_cache_get(
+            &renderer->glyph_cache,
+            character,
+            GLYPH_STYLE_REGULAR,
+            &glyph_texture_x,
+            &glyph_texture_y,
+            glyph_keys
+        );
+        glyph_cache_use(&renderer->glyph_cache, glyph_keys->data, glyph_keys->length);
     }
+
+    float cell_width = FONT_GLYPH_WIDTH;
+    float cell_height = FONT_GLYPH_HEIGHT;
+
+    glUseProgram(renderer->cursor_program);
+    glUniformMatrix4fv(
+        renderer->cursor_projection_matrix_location,
+        1,
+        GL_FALSE,
+        (const float *)&renderer->projection_matrix
+    );
+    glUniform2f(
+        renderer->cursor_position_location,
+        cursor_x * cell_width,
+        origin_y / renderer->scale - (cursor_row + 1) * cell_height - renderer->scroll_offset
+    );
+    glUniform2f(renderer->cursor_cell_size_location, cell_width, cell_height);
+    glUniform1f(renderer->cursor_line_width_location, FONT_LINE_WIDTH);
+    glUniform1i(renderer->cursor_style_location, grid->cursor_style);
+    glUniform1i(renderer->cursor_has_glyph_location, has_glyph);
+    glUniform2f(renderer->cursor_glyph_position_location, glyph_texture_x, glyph_texture_y);
+
+    glBindVertexArray(renderer->cursor_vao);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glBindVertexArray(0);
 }
 
-static void renderer_draw_grid(
-    struct Renderer *renderer, struct Grid *grid, int32_t visible_scrollback_line_count, bool do_draw_cursor
+static void renderer_add_selection_lines(
+    struct Renderer *renderer, int32_t first_line, int32_t start_line, int32_t end_line, int32_t start_x, int32_t end_x
 ) {
 
-    struct Selection sorted_selection = selection_sorted(&renderer->selection);
+    int32_t last_line = first_line + (int32_t)renderer->sprite_batch_count - 1;
+    start_line = int32_max(start_line, first_line);
+    end_line = int32_min(end_line, last_line);
+    start_x = int32_max(start_x, 0);
+    end_x = int32_min(end_x, (int32_t)renderer->width);
 
-    for (size_t y = visible_scrollback_line_count; y < renderer->sprite_batch_count; y++) {
-        if (!renderer->are_sprite_batches_dirty[y]) {
-            continue;
+    if (start_line > end_line || start_x >= end_x) {
+        return;
+    }
+
+    // Sprites are positioned from the bottom of the lowest row.
+    sprite_batch_add(
+        &renderer->selection_sprite_batch,
+        (struct Sprite){
+            .x = start_x * FONT_GLYPH_WIDTH,
+            .y = (last_line - end_line) * FONT_GLYPH_HEIGHT,
+            .width = (end_x - start_x) * FONT_GLYPH_WIDTH,
+            .height = (end_line - start_line + 1) * FONT_GLYPH_HEIGHT,
+
+            .texture_x = 0,
+            .texture_width = FONT_GLYPH_WIDTH,
+            .texture_height = FONT_GLYPH_HEIGHT,
+
+            .color = RENDERER_SELECTION_COLOR,
+            .alternate_color = RENDERER_SELECTION_COLOR,
         }
-        renderer->are_sprite_batches_dirty[y] = false;
+    );
+}
 
-        struct SpriteBatch *sprite_batch = &renderer->sprite_batches[y];
-        size_t grid_y = y - renderer->scrollback_distance;
+// The selection is drawn before the rows, so it ends up underneath their backgrounds and characters.
+static void renderer_draw_selection(
+    struct Renderer *renderer, struct Grid *grid, int32_t origin_y, struct Selection *sorted_selection
+) {
 
-        sprite_batch_begin(sprite_batch);
+    if (sorted_selection->end_y < sorted_selection->start_y) {
+        return;
+    }
 
-        for (size_t x = 0; x < grid->width; x++) {
-            size_t i = x + grid_y * grid->width;
-            uint32_t character = grid->data[i];
+    int32_t first_line = renderer_get_absolute_line(renderer, grid, -RENDERER_OVERSCAN_ROW_COUNT);
+    int32_t start_line = sorted_selection->start_y;
+    int32_t end_line = sorted_selection->end_y;
+    int32_t width = (int32_t)renderer->width;
+
+    sprite_batch_begin(&renderer->selection_sprite_batch);
+
+    if (start_line == end_line) {
+        renderer_add_selection_lines(
+            renderer,
+            first_line,
+            start_line,
+            end_line,
+            sorted_selection->start_x,
+            sorted_selection->end_x + 1
+        );
+    } else {
+        renderer_add_selection_lines(renderer, first_line, start_line, start_line, sorted_selection->start_x, width);
+        renderer_add_selection_lines(renderer, first_line, start_line + 1, end_line - 1, 0, width);
+        renderer_add_selection_lines(renderer, first_line, end_line, end_line, 0, sorted_selection->end_x + 1);
+    }
 
-            struct Color background_color = color_from_hex(grid->background_colors[i]);
-            struct Color foreground_color = color_from_hex(grid->foreground_colors[i]);
+    sprite_batch_end(&renderer->selection_sprite_batch);
 
-            renderer_apply_selection_colors(
-                renderer,
-                &sorted_selection,
-                x,
-                grid_y,
-                &foreground_color,
-                &background_color
-            );
-            renderer_draw_tile(character, foreground_color, background_color, sprite_batch, x, 0, renderer->scale);
-        }
+    int32_t bottom_y = (int32_t)renderer->sprite_batch_count - RENDERER_OVERSCAN_ROW_COUNT;
+    glUniform1f(renderer->offset_y_location, origin_y / renderer->scale - bottom_y * FONT_GLYPH_HEIGHT);
+    sprite_batch_draw(&renderer->selection_sprite_batch);
+}
 
-        if (do_draw_cursor && grid->should_show_cursor && grid_y == grid->cursor_y) {
-            renderer_draw_cursor(grid, sprite_batch, grid->cursor_x, grid->cursor_y, 2, renderer->scale);
-        }
+static void renderer_draw_hud(struct Renderer *renderer, int32_t origin_y) {
+    if (renderer->hud_line_count == 0) {
+        return;
+    }
+
+    // The HUD doesn't move while scrolling, and line -1 is never selected.
+    glUseProgram(renderer->program);
+    glUniform1f(renderer->scroll_offset_location, 0.0f);
+    glUniform1f(renderer->offset_y_location, origin_y / renderer->scale - renderer->hud_line_count * FONT_GLYPH_HEIGHT);
+    glUniform1i(renderer->row_line_location, -1);
 
-        sprite_batch_end(sprite_batch, renderer->texture_atlas.width, renderer->texture_atlas.height);
+    sprite_batch_draw(&renderer->hud_sprite_batch);
+}
+
+// Palette changes only need the palette texture to be updated, rows store palette indices so they don't change.
+static void renderer_update_palette(struct Renderer *renderer, struct Grid *grid) {
+    uint8_t palette_pixels[GRID_PALETTE_LENGTH * 4];
+
+    for (size_t i = 0; i < GRID_PALETTE_LENGTH; i++) {
+        uint32_t hex = grid->palette[i];
+
+        palette_pixels[i * 4] = hex >> 16;
+        palette_pixels[i * 4 + 1] = hex >> 8;
+        palette_pixels[i * 4 + 2] = hex;
+        palette_pixels[i * 4 + 3] = 0xff;
     }
+
+    texture_update_region(&renderer->palette_texture, 0, 0, GRID_PALETTE_LENGTH, 1, palette_pixels);
+
+    grid->is_palette_dirty = false;
 }
 
 void renderer_draw(struct Renderer *renderer, struct Grid *grid, int32_t origin_y, struct Window *window) {
-    glClearColor(renderer->background_color.r, renderer->background_color.g, renderer->background_color.b, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    renderer->frame_stats = (struct RendererFrameStats){0};
+
+    TRACE_BEGIN("draw");
+
+    glyph_cache_begin_frame(&renderer->glyph_cache);
+    renderer_collect_prefetched_rows(renderer);
+
+    if (grid->is_palette_dirty) {
+        renderer_update_palette(renderer, grid);
+    }
+
+    struct Color background_color = color_from_hex(grid_color_to_hex(grid, GRID_COLOR_BACKGROUND_DEFAULT));
+    glClearColor(background_color.r, background_color.g, background_color.b, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
 
     glUseProgram(renderer->program);
     glUniformMatrix4fv(renderer->projection_matrix_location, 1, GL_FALSE, (const float *)&renderer->projection_matrix);
-    glBindTexture(GL_TEXTURE_2D, renderer->texture_atlas.id);
+    glUniform1f(renderer->cell_width_location, FONT_GLYPH_WIDTH);
+    glUniform1f(renderer->scroll_offset_location, renderer->scroll_offset);
 
-    int32_t visible_scrollback_line_count = renderer_get_visible_scrollback_line_count(renderer);
+    // An empty range (the end line is before the start line) selects nothing.
+    struct Selection sorted_selection = {.start_y = 1, .end_y = 0};
+    if (renderer->selection_state == SELECTION_STATE_FINISHED) {
+        sorted_selection = selection_sorted(&renderer->selection);
+    }
+
+    glUniform2i(renderer->selection_start_location, sorted_selection.start_x, sorted_selection.start_y);
+    glUniform2i(renderer->selection_end_location, sorted_selection.end_x, sorted_selection.end_y);
+
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, renderer->palette_texture.id);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, renderer->glyph_cache.texture.id);
 
-    renderer_draw_scrollback(renderer, grid, visible_scrollback_line_count);
-    renderer_draw_grid(renderer, grid, visible_scrollback_line_count, window->is_focused);
+    renderer_update_rows(renderer, grid);
+    renderer_draw_selection(renderer, grid, origin_y, &sorted_selection);
+
+    TRACE_BEGIN("draw rows");
+
+    for (size_t i = 0; i < renderer->sprite_batch_count; i++) {
+        struct SpriteBatch *sprite_batch = &renderer->sprite_batches[i];
+        int32_t y = (int32_t)i - RENDERER_OVERSCAN_ROW_COUNT;
 
-    for (size_t y = 0; y < renderer->sprite_batch_count; y++) {
-        struct SpriteBatch *sprite_batch = &renderer->sprite_batches[y];
+        // Glyphs on screen can't be evicted, glyphs that aren't rasterized yet get requested.
+        struct List_uint32_t *glyph_keys = &renderer->sprite_batch_glyph_keys[i];
+        glyph_cache_use(&renderer->glyph_cache, glyph_keys->data, glyph_keys->length);
 
-        float offset_y = origin_y - (y + 1) * FONT_GLYPH_HEIGHT * renderer->scale;
+        float offset_y = origin_y / renderer->scale - (y + 1) * FONT_GLYPH_HEIGHT;
         glUniform1f(renderer->offset_y_location, offset_y);
+        glUniform1i(renderer->row_line_location, renderer_get_absolute_line(renderer, grid, y));
         sprite_batch_draw(sprite_batch);
     }
 
+    TRACE_END();
+
+    if (window->is_focused) {
+        renderer_draw_cursor(renderer, grid, origin_y);
+    }
+
+    renderer_draw_hud(renderer, origin_y);
+
+    TRACE_BEGIN("swap buffers");
     window_swap_buffers(window);
+    TRACE_END();
+
+    renderer_prefetch_rows(renderer, grid);
+
+    TRACE_END();
+}
+
+// Rows are built in unscaled pixels, zooming only changes how many of them the projection fits in the viewport.
+static void renderer_update_projection(struct Renderer *renderer) {
+    float width = renderer->viewport_width / renderer->scale;
+    float height = renderer->viewport_height / renderer->scale;
+
+    renderer->projection_matrix = matrix4_orthographic(0.0f, width, 0.0f, height, -100.0, 100.0);
 }
 
 void renderer_resize_viewport(struct Renderer *renderer, int32_t width, int32_t height) {
     glViewport(0, 0, width, height);
-    renderer->projection_matrix = matrix4_orthographic(0.0f, (float)width, 0.0f, (float)height, -100.0, 100.0);
+
+    renderer->viewport_width = width;
+    renderer->viewport_height = height;
+    renderer_update_projection(renderer);
 }
 
 static void renderer_mark_all_sprite_batches_dirty(struct Renderer *renderer) {
@@ -494,109 +993,391 @@ static void renderer_mark_all_sprite_batches_dirty(struct Renderer *renderer) {
     renderer->needs_redraw = true;
 }
 
-void renderer_resize(struct Renderer *renderer, size_t width, size_t height, float scale) {
-    renderer->scale = scale;
+// Cached rows need to be cleared whenever something they were built with changes.
+static void renderer_clear_row_cache(struct Renderer *renderer) {
+    struct RowPrefetchShared *shared = renderer->prefetch_shared;
 
-    for (size_t i = 0; i < renderer->sprite_batch_count; i++) {
-        sprite_batch_destroy(&renderer->sprite_batches[i]);
+    row_cache_clear(&renderer->row_cache);
+
+    mutex_lock(&shared->mutex);
+    list_reset_struct_RowPrefetchRequest(&shared->requests);
+    shared->generation++;
+    mutex_unlock(&shared->mutex);
+}
+
+static bool renderer_uses_glyph(struct List_uint32_t *glyph_keys, struct List_uint32_t *changed_glyph_keys) {
+    for (size_t i = 0; i < glyph_keys->length; i++) {
+        for (size_t j = 0; j < changed_glyph_keys->length; j++) {
+            if (glyph_keys->data[i] == changed_glyph_keys->data[j]) {
+                return true;
+            }
+        }
     }
 
-    renderer->sprite_batch_count = height;
-    free(renderer->sprite_batches);
-    renderer->sprite_batches = malloc(renderer->sprite_batch_count * sizeof(struct SpriteBatch));
-    assert(renderer->sprite_batches);
-    free(renderer->are_sprite_batches_dirty);
-    renderer->are_sprite_batches_dirty = malloc(renderer->sprite_batch_count * sizeof(bool));
-    assert(renderer->are_sprite_batches_dirty);
-    // Every row is dirty when the screen gets resized.
-    renderer_mark_all_sprite_batches_dirty(renderer);
+    return false;
+}
+
+// Uploads glyphs that finished rasterizing. Only rows that were drawn with one of the changed glyphs, either with the
+// fallback glyph while it was rasterizing or from a slot that was evicted, get rebuilt or removed from the row cache.
+void renderer_update_glyph_cache(struct Renderer *renderer) {
+    struct List_uint32_t *changed_glyph_keys = &renderer->changed_glyph_keys;
+    list_reset_uint32_t(changed_glyph_keys);
+
+    glyph_cache_update(&renderer->glyph_cache, changed_glyph_keys);
+
+    if (changed_glyph_keys->length == 0) {
+        return;
+    }
 
     for (size_t i = 0; i < renderer->sprite_batch_count; i++) {
-        // 2 sprites per tile (foreground background), plus a potential cursor which also has a foreground and
-        // background.
-        renderer->sprite_batches[i] = sprite_batch_create(width * 2 + 2);
+        if (renderer_uses_glyph(&renderer->sprite_batch_glyph_keys[i], changed_glyph_keys)) {
+            renderer->are_sprite_batches_dirty[i] = true;
+        }
+    }
+
+    row_cache_remove_glyph_users(&renderer->row_cache, changed_glyph_keys->data, changed_glyph_keys->length);
+
+    struct RowPrefetchShared *shared = renderer->prefetch_shared;
+
+    mutex_lock(&shared->mutex);
+    shared->glyph_generation++;
+    mutex_unlock(&shared->mutex);
+
+    // The cursor looks its glyph up every frame, so it only needs a redraw.
+    renderer->needs_redraw = true;
+}
+
+// The HUD is only rebuilt when its text changes. Printable ASCII is always in the glyph cache, so unlike rows it never
+// needs to be rebuilt when glyphs finish rasterizing.
+void renderer_set_hud_text(struct Renderer *renderer, const char *text) {
+    struct SpriteBatch *sprite_batch = &renderer->hud_sprite_batch;
+
+    size_t line_count = 0;
+    size_t max_line_length = 0;
+    size_t line_length = 0;
+
+    for (const char *c = text; *c != '\0'; c++) {
+        if (*c == '\n') {
+            line_count++;
+            line_length = 0;
+            continue;
+        }
+
+        line_length++;
+        if (line_length > max_line_length) {
+            max_line_length = line_length;
+        }
+    }
+
+    if (*text != '\0') {
+        line_count++;
+    }
+
+    sprite_batch_begin(sprite_batch);
+
+    // Rows are built from the bottom up, so the first line is at the top of the batch.
+    sprite_batch_add(
+        sprite_batch,
+        (struct Sprite){
+            .width = max_line_length * FONT_GLYPH_WIDTH,
+            .height = line_count * FONT_GLYPH_HEIGHT,
+
+            .texture_x = 0,
+            .texture_width = FONT_GLYPH_WIDTH,
+            .texture_height = FONT_GLYPH_HEIGHT,
+
+            .color = RENDERER_HUD_BACKGROUND_COLOR,
+            .alternate_color = RENDERER_HUD_BACKGROUND_COLOR,
+        }
+    );
+
+    size_t line_i = 0;
+    int32_t x = 0;
+    list_reset_uint32_t(&renderer->glyph_keys);
+
+    for (const char *c = text; *c != '\0'; c++) {
+        if (*c == '\n') {
+            line_i++;
+            x = 0;
+            continue;
+        }
+
+        // Box drawing characters can take 2 sprites.
+        if (sprite_batch->sprites.length + 2 > RENDERER_HUD_SPRITE_CAPACITY) {
+            break;
+        }
+
+        size_t first_sprite_i = sprite_batch->sprites.length;
+
+        renderer_draw_character(
+            (uint8_t)*c,
+            &renderer->glyph_cache,
+            &renderer->glyph_keys,
+            &sprite_batch->sprites,
+            x,
+            RENDERER_HUD_FOREGROUND_COLOR,
+            RENDERER_HUD_FOREGROUND_COLOR
+        );
+
+        for (size_t i = first_sprite_i; i < sprite_batch->sprites.length; i++) {
+            sprite_batch->sprites.data[i].y += (line_count - 1 - line_i) * FONT_GLYPH_HEIGHT;
+        }
+
+        x++;
     }
+
+    sprite_batch_end(sprite_batch);
+
+    renderer->hud_line_count = line_count;
+    renderer->needs_redraw = true;
+}
+
+void renderer_set_scale(struct Renderer *renderer, float scale) {
+    if (scale == renderer->scale) {
+        return;
+    }
+
+    renderer->scale = scale;
+    renderer_update_projection(renderer);
+    renderer->needs_redraw = true;
+}
+
+// Row batches are reused across resizes. Extra batches are kept around when the height shrinks, and meshes are only
+// recreated when rows need room for more sprites than they have.
+void renderer_resize(struct Renderer *renderer, size_t width, size_t height) {
+    size_t sprite_batch_count = height + RENDERER_OVERSCAN_ROW_COUNT * 2;
+    if (width == renderer->width && sprite_batch_count == renderer->sprite_batch_count) {
+        return;
+    }
+
+    // Rows don't depend on the scale or height, so cached rows are only outdated if the width changed.
+    if (width != renderer->width) {
+        renderer->width = width;
+        renderer_clear_row_cache(renderer);
+    }
+
+    // At most 1 background and 2 foreground sprites per tile (box drawing corners use 2 lines).
+    uint32_t sprite_capacity = width * 3;
+
+    if (sprite_capacity > renderer->sprite_capacity) {
+        // Grow by at least double so that dragging the window wider doesn't recreate the meshes every time.
+        renderer->sprite_capacity = int32_max(sprite_capacity, renderer->sprite_capacity * 2);
+
+        // Every row shares the same indices, they only need to be regenerated if the rows have grown.
+        if (renderer->quad_index_buffer.max_quad_count > 0) {
+            index_buffer_destroy(&renderer->quad_index_buffer);
+        }
+
+        renderer->quad_index_buffer = index_buffer_create_quads(renderer->sprite_capacity);
+
+        for (size_t i = 0; i < renderer->allocated_sprite_batch_count; i++) {
+            sprite_batch_destroy(&renderer->sprite_batches[i]);
+            renderer->sprite_batches[i] = sprite_batch_create(renderer->sprite_capacity, &renderer->quad_index_buffer);
+        }
+    }
+
+    if (sprite_batch_count > renderer->allocated_sprite_batch_count) {
+        renderer->sprite_batches = realloc(renderer->sprite_batches, sprite_batch_count * sizeof(struct SpriteBatch));
+        assert(renderer->sprite_batches);
+        renderer->are_sprite_batches_dirty =
+            realloc(renderer->are_sprite_batches_dirty, sprite_batch_count * sizeof(bool));
+        assert(renderer->are_sprite_batches_dirty);
+        renderer->sprite_batch_glyph_keys =
+            realloc(renderer->sprite_batch_glyph_keys, sprite_batch_count * sizeof(struct List_uint32_t));
+        assert(renderer->sprite_batch_glyph_keys);
+
+        for (size_t i = renderer->allocated_sprite_batch_count; i < sprite_batch_count; i++) {
+            renderer->sprite_batches[i] = sprite_batch_create(renderer->sprite_capacity, &renderer->quad_index_buffer);
+            renderer->sprite_batch_glyph_keys[i] = list_create_uint32_t(16);
+        }
+
+        renderer->allocated_sprite_batch_count = sprite_batch_count;
+    }
+
+    renderer->sprite_batch_count = sprite_batch_count;
+
+    // Every row is dirty when the screen gets resized.
+    renderer_mark_all_sprite_batches_dirty(renderer);
 }
 
 void renderer_scroll_reset(struct Renderer *renderer) {
+    renderer->scroll_direction = 0;
+    renderer->pending_scroll = 0.0f;
+    renderer->is_scrolling = false;
+
+    if (renderer->scroll_offset != 0.0f) {
+        renderer->scroll_offset = 0.0f;
+        renderer->needs_redraw = true;
+    }
+
     if (renderer->scrollback_distance == 0) {
         return;
     }
 
-    renderer_on_scroll(renderer);
-
     renderer->scrollback_distance = 0;
     renderer_mark_all_sprite_batches_dirty(renderer);
 }
 
-void renderer_scroll_down(struct Renderer *renderer, bool is_scrolling_with_grid) {
-    renderer_on_scroll(renderer);
+static void renderer_reverse_rows(struct Renderer *renderer, size_t start, size_t end) {
+    while (end - start > 1) {
+        end--;
+
+        struct SpriteBatch sprite_batch = renderer->sprite_batches[start];
+        renderer->sprite_batches[start] = renderer->sprite_batches[end];
+        renderer->sprite_batches[end] = sprite_batch;
+
+        bool is_dirty = renderer->are_sprite_batches_dirty[start];
+        renderer->are_sprite_batches_dirty[start] = renderer->are_sprite_batches_dirty[end];
+        renderer->are_sprite_batches_dirty[end] = is_dirty;
+
+        struct List_uint32_t glyph_keys = renderer->sprite_batch_glyph_keys[start];
+        renderer->sprite_batch_glyph_keys[start] = renderer->sprite_batch_glyph_keys[end];
+        renderer->sprite_batch_glyph_keys[end] = glyph_keys;
+
+        start++;
+    }
+}
+
+// Rotates the sprite batches to allow scrolling without updating every batch. Positive distances move rows up, only
+// the rows that get exposed at the other end are marked dirty. Any distance is applied as a single rotation.
+static void renderer_rotate_rows(struct Renderer *renderer, int32_t distance) {
+    if (distance == 0) {
+        return;
+    }
+
+    int32_t count = renderer->sprite_batch_count;
 
+    if (abs(distance) >= count) {
+        renderer_mark_all_sprite_batches_dirty(renderer);
+        return;
+    }
+
+    // Rotating left by n is the same as reversing the first n rows, then the rest, then everything.
+    int32_t left_distance = distance > 0 ? distance : count + distance;
+    renderer_reverse_rows(renderer, 0, left_distance);
+    renderer_reverse_rows(renderer, left_distance, count);
+    renderer_reverse_rows(renderer, 0, count);
+
+    int32_t exposed_start = distance > 0 ? count - distance : 0;
+    for (int32_t i = 0; i < abs(distance); i++) {
+        renderer->are_sprite_batches_dirty[exposed_start + i] = true;
+    }
+
+    renderer->needs_redraw = true;
+}
+
+void renderer_scroll_down(struct Renderer *renderer, int32_t distance, bool is_scrolling_with_grid) {
     if (!is_scrolling_with_grid) {
-        renderer->scrollback_distance -= 1;
-        if (renderer->scrollback_distance < 0) {
-            renderer->scrollback_distance = 0;
-            return;
-        }
+        distance = int32_min(distance, renderer->scrollback_distance);
+        renderer->scrollback_distance -= distance;
+        renderer->scroll_direction = 1;
     }
 
-    // Rotate the sprite batchs to allow scrolling without updating every batch.
-    struct SpriteBatch first_sprite_batch = renderer->sprite_batches[0];
-    memmove(
-        &renderer->sprite_batches[0],
-        &renderer->sprite_batches[1],
-        (renderer->sprite_batch_count - 1) * sizeof(struct SpriteBatch)
-    );
-    renderer->sprite_batches[renderer->sprite_batch_count - 1] = first_sprite_batch;
+    renderer_rotate_rows(renderer, distance);
+}
 
-    memmove(
-        renderer->are_sprite_batches_dirty,
-        renderer->are_sprite_batches_dirty + 1,
-        (renderer->sprite_batch_count - 1) * sizeof(bool)
-    );
-    // Now the bottom sprite batch is the only one with newly outdated content.
-    renderer->are_sprite_batches_dirty[renderer->sprite_batch_count - 1] = true;
+void renderer_scroll_up(struct Renderer *renderer, struct Grid *grid, int32_t distance) {
+    distance = int32_min(distance, grid->scrollback_lines.length - renderer->scrollback_distance);
+    renderer->scrollback_distance += distance;
+    renderer->scroll_direction = -1;
 
+    renderer_rotate_rows(renderer, -distance);
+}
+
+// Positive distances scroll towards older lines, in unscaled pixels. The distance is applied gradually by
+// renderer_update_scroll.
+void renderer_scroll_by(struct Renderer *renderer, float pixels) {
+    renderer->pending_scroll += pixels;
     renderer->needs_redraw = true;
 }
 
-void renderer_scroll_up(struct Renderer *renderer, struct Grid *grid) {
-    renderer_on_scroll(renderer);
+// Applies part of the pending scroll distance, easing out so that scrolling glides to a stop. Whole rows are scrolled
+// by rotating the rows and the rest is a pixel offset applied in the shader, so rows that are already built never
+// need to be touched. Returns true while there's still scrolling left to animate.
+bool renderer_update_scroll(struct Renderer *renderer, struct Grid *grid, float delta_time) {
+    renderer->is_scrolling = renderer->pending_scroll != 0.0f;
 
-    renderer->scrollback_distance += 1;
-    if (renderer->scrollback_distance > grid->scrollback_lines.length) {
-        renderer->scrollback_distance = grid->scrollback_lines.length;
-        return;
+    if (!renderer->is_scrolling) {
+        return false;
     }
 
-    // Rotate the sprite batchs to allow scrolling without updating every batch.
-    struct SpriteBatch last_sprite_batch = renderer->sprite_batches[renderer->sprite_batch_count - 1];
-    memmove(
-        &renderer->sprite_batches[1],
-        &renderer->sprite_batches[0],
-        (renderer->sprite_batch_count - 1) * sizeof(struct SpriteBatch)
-    );
-    renderer->sprite_batches[0] = last_sprite_batch;
+    delta_time = fminf(delta_time, RENDERER_SCROLL_MAX_DELTA_TIME);
 
-    memmove(
-        renderer->are_sprite_batches_dirty + 1,
-        renderer->are_sprite_batches_dirty,
-        (renderer->sprite_batch_count - 1) * sizeof(bool)
-    );
-    // Now the top sprite batch is the only one with newly outdated content.
-    renderer->are_sprite_batches_dirty[0] = true;
+    float step = renderer->pending_scroll * (1.0f - expf(-RENDERER_SCROLL_EASING_RATE * delta_time));
+    // Finish once there's less than half a pixel left to scroll.
+    if (fabsf(renderer->pending_scroll - step) < 0.5f) {
+        step = renderer->pending_scroll;
+    }
+    renderer->pending_scroll -= step;
+
+    float cell_height = FONT_GLYPH_HEIGHT;
+    float max_position = grid->scrollback_lines.length * cell_height;
+    float position = renderer->scrollback_distance * cell_height + renderer->scroll_offset + step;
+
+    if (position <= 0.0f || position >= max_position) {
+        position = fmaxf(fminf(position, max_position), 0.0f);
+        renderer->pending_scroll = 0.0f;
+    }
+
+    int32_t scrollback_distance = (int32_t)floorf(position / cell_height);
+    renderer->scroll_offset = position - scrollback_distance * cell_height;
+
+    int32_t distance = scrollback_distance - renderer->scrollback_distance;
+    if (distance > 0) {
+        renderer_scroll_up(renderer, grid, distance);
+    } else if (distance < 0) {
+        renderer_scroll_down(renderer, -distance, false);
+    }
 
     renderer->needs_redraw = true;
+
+    return renderer->pending_scroll != 0.0f;
 }
 
 void renderer_destroy(struct Renderer *renderer) {
-    for (size_t i = 0; i < renderer->sprite_batch_count; i++) {
+    for (size_t i = 0; i < renderer->allocated_sprite_batch_count; i++) {
         sprite_batch_destroy(&renderer->sprite_batches[i]);
+        list_destroy_uint32_t(&renderer->sprite_batch_glyph_keys[i]);
     }
 
     free(renderer->sprite_batches);
     free(renderer->are_sprite_batches_dirty);
+    free(renderer->sprite_batch_glyph_keys);
+
+    struct RowPrefetchShared *shared = renderer->prefetch_shared;
+
+    mutex_lock(&shared->mutex);
+    shared->should_stop = true;
+    condition_variable_broadcast(&shared->has_requests);
+    mutex_unlock(&shared->mutex);
+
+    thread_join(&renderer->prefetch_thread);
+
+    for (size_t i = 0; i < shared->results.length; i++) {
+        list_destroy_struct_Vertex(&shared->results.data[i].vertices);
+        list_destroy_uint32_t(&shared->results.data[i].glyph_keys);
+    }
 
-    texture_destroy(&renderer->texture_atlas);
+    list_destroy_struct_RowPrefetchRequest(&shared->requests);
+    list_destroy_struct_RowPrefetchResult(&shared->results);
+    condition_variable_destroy(&shared->has_requests);
+    mutex_destroy(&shared->mutex);
+    free(shared);
+
+    row_cache_destroy(&renderer->row_cache);
+    thread_pool_destroy(&renderer->thread_pool);
+    list_destroy_struct_RendererRowBuild(&renderer->row_builds);
+
+    sprite_batch_destroy(&renderer->selection_sprite_batch);
+    index_buffer_destroy(&renderer->selection_index_buffer);
+    sprite_batch_destroy(&renderer->hud_sprite_batch);
+    index_buffer_destroy(&renderer->hud_index_buffer);
+    index_buffer_destroy(&renderer->quad_index_buffer);
+    glyph_cache_destroy(&renderer->glyph_cache);
+    list_destroy_uint32_t(&renderer->glyph_keys);
+    list_destroy_uint32_t(&renderer->changed_glyph_keys);
+    texture_destroy(&renderer->palette_texture);
     program_destroy(renderer->program);
+    program_destroy(renderer->cursor_program);
+    glDeleteVertexArrays(1, &renderer->cursor_vao);
 }
\ No newline at end of file
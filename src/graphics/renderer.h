@@ -8,44 +8,184 @@
 #include "../color.h"
 #include "../geometry.h"
 #include "../window.h"
+#include "../thread_pool.h"
 #include "resources.h"
 #include "sprite_batch.h"
+#include "glyph_cache.h"
+#include "row_cache.h"
+
+// The contents of a row, tiles past the row's length are blank.
+struct RendererRow {
+    const uint32_t *data;
+    const uint32_t *background_colors;
+    const uint32_t *foreground_colors;
+    size_t length;
+};
+
+// A dirty row waiting to be built by the thread pool, into its sprite batch's sprites and vertices.
+struct RendererRowBuild {
+    size_t sprite_batch_i;
+    int32_t line;
+    bool is_scrollback_line;
+    // Rows past either end of the scrollback and grid have no contents and are left empty.
+    bool has_row;
+    struct RendererRow row;
+};
+
+typedef struct RendererRowBuild struct_RendererRowBuild;
+LIST_DEFINE(struct_RendererRowBuild)
+
+struct RowPrefetchRequest {
+    uint32_t line;
+    // Scrollback lines never change after they're pushed, so the prefetch thread can read them without a lock.
+    struct ScrollbackLine scrollback_line;
+};
+
+typedef struct RowPrefetchRequest struct_RowPrefetchRequest;
+LIST_DEFINE(struct_RowPrefetchRequest)
+
+struct RowPrefetchResult {
+    uint32_t line;
+    uint32_t generation;
+    uint32_t glyph_generation;
+    struct List_struct_Vertex vertices;
+    struct List_uint32_t glyph_keys;
+};
+
+typedef struct RowPrefetchResult struct_RowPrefetchResult;
+LIST_DEFINE(struct_RowPrefetchResult)
+
+// State shared with the prefetch thread, allocated separately so that it doesn't move when the renderer is copied.
+struct RowPrefetchShared {
+    struct Mutex mutex;
+    struct ConditionVariable has_requests;
+
+    // Requests are taken from the end, so the most important ones are pushed last.
+    struct List_struct_RowPrefetchRequest requests;
+    struct List_struct_RowPrefetchResult results;
+
+    // What rows are currently built with. The generation changes whenever the row cache is cleared, results from
+    // older generations are discarded.
+    struct GlyphCache *glyph_cache;
+    size_t width;
+    uint32_t generation;
+    // Changes whenever glyphs change, results from older glyph generations are discarded if they used any glyphs
+    // since they might have been built with glyphs that changed.
+    uint32_t glyph_generation;
+
+    bool should_stop;
+};
+
+// Costs of the last draw, reported by the render benchmark.
+struct RendererFrameStats {
+    // Time spent building rows on the CPU, not including uploads.
+    double build_time;
+    size_t built_row_count;
+    size_t upload_byte_count;
+};
 
 struct Renderer {
     struct SpriteBatch *sprite_batches;
     bool *are_sprite_batches_dirty;
+    // The glyph cache keys each batch's row was built with, so only the rows using a glyph get rebuilt when it changes.
+    struct List_uint32_t *sprite_batch_glyph_keys;
     size_t sprite_batch_count;
+    // Batches past the count are unused, they're kept to be reused if the screen grows again.
+    size_t allocated_sprite_batch_count;
+    uint32_t sprite_capacity;
+    struct IndexBuffer quad_index_buffer;
 
+    // The grid width that rows are built for.
+    size_t width;
+    // Zoom is applied by the projection, rows are built in unscaled pixels.
     float scale;
-    struct Color background_color;
+    int32_t viewport_width;
+    int32_t viewport_height;
 
-    struct Texture texture_atlas;
+    struct GlyphCache glyph_cache;
+    // Glyph keys used by the cursor and HUD, and the keys that changed in the last glyph cache update.
+    struct List_uint32_t glyph_keys;
+    struct List_uint32_t changed_glyph_keys;
+    struct Texture palette_texture;
     struct Matrix4 projection_matrix;
     uint32_t program;
     int32_t projection_matrix_location;
     int32_t offset_y_location;
+    int32_t row_line_location;
+    int32_t cell_width_location;
+    int32_t selection_start_location;
+    int32_t selection_end_location;
+    int32_t scroll_offset_location;
+
+    uint32_t cursor_program;
+    uint32_t cursor_vao;
+    int32_t cursor_projection_matrix_location;
+    int32_t cursor_position_location;
+    int32_t cursor_cell_size_location;
+    int32_t cursor_line_width_location;
+    int32_t cursor_style_location;
+    int32_t cursor_has_glyph_location;
+    int32_t cursor_glyph_position_location;
 
     int32_t scrollback_distance;
+    // The direction of the last scroll through the scrollback, rows past the screen in that direction get prefetched.
+    // Negative when scrolling towards older lines, and zero when not looking at the scrollback.
+    int32_t scroll_direction;
+    // How far the rows are shifted down in unscaled pixels, less than a row. Together with the scrollback distance
+    // this is the scroll position.
+    float scroll_offset;
+    // Distance in unscaled pixels that still needs to be scrolled.
+    float pending_scroll;
+    bool is_scrolling;
+    struct RendererFrameStats frame_stats;
+
+    struct ThreadPool thread_pool;
+    struct List_struct_RendererRowBuild row_builds;
+    // Seconds per frame that can be spent building rows, rows that don't fit are built over the next frames.
+    double row_build_budget;
+    // Set when the last draw ran out of time before building every dirty row.
+    bool has_pending_rows;
+
+    struct RowCache row_cache;
+    struct RowPrefetchShared *prefetch_shared;
+    struct Thread prefetch_thread;
 
     struct Selection selection;
     enum SelectionState selection_state;
 
+    // Drawn underneath the rows, with a quad for each range of selected lines.
+    struct SpriteBatch selection_sprite_batch;
+    struct IndexBuffer selection_index_buffer;
+
+    // Drawn over the rows in the top left corner while it has text.
+    struct SpriteBatch hud_sprite_batch;
+    struct IndexBuffer hud_index_buffer;
+    size_t hud_line_count;
+
     bool needs_redraw;
 };
 
-struct Renderer renderer_create(size_t width, size_t height);
+// Rows are built by thread_count threads, including the one that draws.
+struct Renderer renderer_create(size_t width, size_t height, size_t thread_count);
 void renderer_on_row_changed_callback(void *context, int32_t y);
 void renderer_on_row_changed(struct Renderer *renderer, int32_t y);
+void renderer_on_cursor_changed_callback(void *context);
 void renderer_on_push_scrollback_line(void *context);
 void renderer_clear_selection(struct Renderer *renderer);
-void renderer_set_selection_start(struct Renderer *renderer, uint32_t x, uint32_t y);
-void renderer_set_selection_end(struct Renderer *renderer, uint32_t x, uint32_t y);
+void renderer_set_selection_start(struct Renderer *renderer, struct Grid *grid, uint32_t x, int32_t y);
+void renderer_set_selection_end(struct Renderer *renderer, struct Grid *grid, uint32_t x, int32_t y);
+void renderer_update_glyph_cache(struct Renderer *renderer);
+// Shows lines of ASCII text over the terminal, an empty string hides it.
+void renderer_set_hud_text(struct Renderer *renderer, const char *text);
 void renderer_draw(struct Renderer *renderer, struct Grid *grid, int32_t origin_y, struct Window *window);
 void renderer_resize_viewport(struct Renderer *renderer, int32_t width, int32_t height);
-void renderer_resize(struct Renderer *renderer, size_t width, size_t height, float scale);
+void renderer_set_scale(struct Renderer *renderer, float scale);
+void renderer_resize(struct Renderer *renderer, size_t width, size_t height);
 void renderer_scroll_reset(struct Renderer *renderer);
-void renderer_scroll_down(struct Renderer *renderer, bool is_scrolling_with_grid);
-void renderer_scroll_up(struct Renderer *renderer, struct Grid *grid);
+void renderer_scroll_down(struct Renderer *renderer, int32_t distance, bool is_scrolling_with_grid);
+void renderer_scroll_up(struct Renderer *renderer, struct Grid *grid, int32_t distance);
+void renderer_scroll_by(struct Renderer *renderer, float pixels);
+bool renderer_update_scroll(struct Renderer *renderer, struct Grid *grid, float delta_time);
 void renderer_destroy(struct Renderer *renderer);
 
 #endif
\ No newline at end of file
@@ -1,17 +1,12 @@
 #include "resources.h"
 
-#include "../file.h"
-
 #include <stdio.h>
 #include <stdlib.h>
 
-#include <stb_image/stb_image.h>
-
-uint32_t shader_create(char *file_path, GLenum shader_type) {
+uint32_t shader_create(const char *source, GLenum shader_type) {
     uint32_t shader = glCreateShader(shader_type);
 
-    char *shader_source = get_file_string(file_path);
-    glShaderSource(shader, 1, (const char *const *)&shader_source, NULL);
+    glShaderSource(shader, 1, &source, NULL);
     glCompileShader(shader);
 
     int32_t success;
@@ -20,17 +15,16 @@ uint32_t shader_create(char *file_path, GLenum shader_type) {
     if (!success) {
         char info_log[512];
         glGetShaderInfoLog(shader, 512, NULL, info_log);
-        printf("Failed to compile shader (%s):\n%s\n", file_path, info_log);
+        const char *shader_type_name = shader_type == GL_VERTEX_SHADER ? "vertex" : "fragment";
+        printf("Failed to compile %s shader:\n%s\n", shader_type_name, info_log);
     }
 
-    free(shader_source);
-
     return shader;
 }
 
-uint32_t program_create(char *vertex_path, char *fragment_path) {
-    uint32_t vertex_shader = shader_create(vertex_path, GL_VERTEX_SHADER);
-    uint32_t fragment_shader = shader_create(fragment_path, GL_FRAGMENT_SHADER);
+uint32_t program_create(const char *vertex_source, const char *fragment_source) {
+    uint32_t vertex_shader = shader_create(vertex_source, GL_VERTEX_SHADER);
+    uint32_t fragment_shader = shader_create(fragment_source, GL_FRAGMENT_SHADER);
 
     uint32_t program = glCreateProgram();
     glAttachShader(program, vertex_shader);
@@ -43,7 +37,7 @@ uint32_t program_create(char *vertex_path, char *fragment_path) {
     if (!success) {
         char info_log[512];
         glGetProgramInfoLog(program, 512, NULL, info_log);
-        printf("Failed to link program of (%s) and (%s):\n%s\n", vertex_path, fragment_path, info_log);
+        printf("Failed to link program:\n%s\n", info_log);
     }
 
     glDeleteShader(vertex_shader);
@@ -56,27 +50,18 @@ void program_destroy(uint32_t program) {
     glDeleteProgram(program);
 }
 
-struct Texture texture_create(char *file_path) {
+struct Texture texture_create(const uint8_t *data, int32_t width, int32_t height) {
     uint32_t texture;
     glGenTextures(1, &texture);
     glBindTexture(GL_TEXTURE_2D, texture);
 
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    // Glyphs are drawn at integer scales, so there's no need for mipmaps or filtering.
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
-    int width, height, channel_count;
-    uint8_t *data = stbi_load(file_path, &width, &height, &channel_count, 0);
-    if (!data) {
-        printf("Failed to load texture: %s\n", file_path);
-        exit(-1);
-    }
-
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-    glGenerateMipmap(GL_TEXTURE_2D);
-
-    stbi_image_free(data);
 
     return (struct Texture){
         .id = texture,
@@ -85,6 +70,23 @@ struct Texture texture_create(char *file_path) {
     };
 }
 
+void texture_resize(struct Texture *texture, const uint8_t *data, int32_t width, int32_t height) {
+    glBindTexture(GL_TEXTURE_2D, texture->id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+
+    texture->width = width;
+    texture->height = height;
+}
+
+// Data is tightly packed RGBA covering only the updated region.
+void texture_update_region(
+    struct Texture *texture, int32_t x, int32_t y, int32_t width, int32_t height, const uint8_t *data
+) {
+
+    glBindTexture(GL_TEXTURE_2D, texture->id);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, data);
+}
+
 void texture_destroy(struct Texture *texture) {
     glDeleteTextures(1, &texture->id);
 }
\ No newline at end of file
@@ -19,12 +19,17 @@ struct TextureArray {
     size_t layer_count;
 };
 
-uint32_t shader_create(char *file_path, GLenum shader_type);
+// Shader sources are embedded into the executable at build time, see tools/embed_assets.c.
+uint32_t shader_create(const char *source, GLenum shader_type);
 
-uint32_t program_create(char *vertex_path, char *fragment_path);
+uint32_t program_create(const char *vertex_source, const char *fragment_source);
 void program_destroy(uint32_t program);
 
-struct Texture texture_create(char *file_path);
+struct Texture texture_create(const uint8_t *data, int32_t width, int32_t height);
+void texture_resize(struct Texture *texture, const uint8_t *data, int32_t width, int32_t height);
+void texture_update_region(
+    struct Texture *texture, int32_t x, int32_t y, int32_t width, int32_t height, const uint8_t *data
+);
 void texture_destroy(struct Texture *texture);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,244 @@
+#include "row_cache.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define ROW_CACHE_NONE UINT32_MAX
+// Enough for a typical row, entries grow if a row needs more.
+#define ROW_CACHE_INITIAL_VERTEX_CAPACITY 256
+#define ROW_CACHE_INITIAL_GLYPH_KEY_CAPACITY 16
+
+struct RowCache row_cache_create(size_t capacity) {
+    size_t table_capacity = 1;
+    while (table_capacity < capacity * 2) {
+        table_capacity *= 2;
+    }
+
+    struct RowCache row_cache = (struct RowCache){
+        .entries = malloc(capacity * sizeof(struct RowCacheEntry)),
+        .entry_capacity = capacity,
+        .table = malloc(table_capacity * sizeof(uint32_t)),
+        .table_capacity = table_capacity,
+    };
+
+    assert(row_cache.entries);
+    assert(row_cache.table);
+
+    for (size_t i = 0; i < capacity; i++) {
+        row_cache.entries[i].vertices = list_create_struct_Vertex(ROW_CACHE_INITIAL_VERTEX_CAPACITY);
+        row_cache.entries[i].glyph_keys = list_create_uint32_t(ROW_CACHE_INITIAL_GLYPH_KEY_CAPACITY);
+    }
+
+    row_cache_clear(&row_cache);
+
+    return row_cache;
+}
+
+static uint32_t row_cache_hash(uint32_t line) {
+    return line * 0x9e3779b1;
+}
+
+// Returns the table slot holding the line, or the empty slot where it would be inserted.
+static size_t row_cache_find_slot(struct RowCache *row_cache, uint32_t line) {
+    size_t mask = row_cache->table_capacity - 1;
+    size_t i = row_cache_hash(line) & mask;
+
+    while (row_cache->table[i] != ROW_CACHE_NONE && row_cache->entries[row_cache->table[i]].line != line) {
+        i = (i + 1) & mask;
+    }
+
+    return i;
+}
+
+// Removes a slot without leaving a tombstone, by shifting back any later slots that would no longer be reachable
+// from their home position.
+static void row_cache_remove_slot(struct RowCache *row_cache, size_t hole_i) {
+    size_t mask = row_cache->table_capacity - 1;
+    size_t i = hole_i;
+
+    while (true) {
+        i = (i + 1) & mask;
+
+        if (row_cache->table[i] == ROW_CACHE_NONE) {
+            break;
+        }
+
+        size_t home_i = row_cache_hash(row_cache->entries[row_cache->table[i]].line) & mask;
+
+        // The slot can fill the hole if the hole is between its home and its current position.
+        if (((i - home_i) & mask) >= ((i - hole_i) & mask)) {
+            row_cache->table[hole_i] = row_cache->table[i];
+            hole_i = i;
+        }
+    }
+
+    row_cache->table[hole_i] = ROW_CACHE_NONE;
+}
+
+static void row_cache_unlink(struct RowCache *row_cache, uint32_t entry_i) {
+    struct RowCacheEntry *entry = &row_cache->entries[entry_i];
+
+    if (entry->newer_i != ROW_CACHE_NONE) {
+        row_cache->entries[entry->newer_i].older_i = entry->older_i;
+    } else {
+        row_cache->newest_i = entry->older_i;
+    }
+
+    if (entry->older_i != ROW_CACHE_NONE) {
+        row_cache->entries[entry->older_i].newer_i = entry->newer_i;
+    } else {
+        row_cache->oldest_i = entry->newer_i;
+    }
+}
+
+static void row_cache_link_newest(struct RowCache *row_cache, uint32_t entry_i) {
+    struct RowCacheEntry *entry = &row_cache->entries[entry_i];
+
+    entry->newer_i = ROW_CACHE_NONE;
+    entry->older_i = row_cache->newest_i;
+
+    if (row_cache->newest_i != ROW_CACHE_NONE) {
+        row_cache->entries[row_cache->newest_i].newer_i = entry_i;
+    } else {
+        row_cache->oldest_i = entry_i;
+    }
+
+    row_cache->newest_i = entry_i;
+}
+
+static void row_cache_link_oldest(struct RowCache *row_cache, uint32_t entry_i) {
+    struct RowCacheEntry *entry = &row_cache->entries[entry_i];
+
+    entry->newer_i = row_cache->oldest_i;
+    entry->older_i = ROW_CACHE_NONE;
+
+    if (row_cache->oldest_i != ROW_CACHE_NONE) {
+        row_cache->entries[row_cache->oldest_i].older_i = entry_i;
+    } else {
+        row_cache->newest_i = entry_i;
+    }
+
+    row_cache->oldest_i = entry_i;
+}
+
+struct RowCacheEntry *row_cache_get(struct RowCache *row_cache, uint32_t line) {
+    uint32_t entry_i = row_cache->table[row_cache_find_slot(row_cache, line)];
+    if (entry_i == ROW_CACHE_NONE) {
+        return NULL;
+    }
+
+    row_cache_unlink(row_cache, entry_i);
+    row_cache_link_newest(row_cache, entry_i);
+
+    return &row_cache->entries[entry_i];
+}
+
+bool row_cache_contains(struct RowCache *row_cache, uint32_t line) {
+    return row_cache->table[row_cache_find_slot(row_cache, line)] != ROW_CACHE_NONE;
+}
+
+void row_cache_put(
+    struct RowCache *row_cache,
+    uint32_t line,
+    const struct Vertex *vertices,
+    size_t vertex_count,
+    const uint32_t *glyph_keys,
+    size_t glyph_key_count
+) {
+
+    size_t slot_i = row_cache_find_slot(row_cache, line);
+    uint32_t entry_i = row_cache->table[slot_i];
+
+    if (entry_i != ROW_CACHE_NONE) {
+        row_cache_unlink(row_cache, entry_i);
+    } else if (row_cache->entry_count < row_cache->entry_capacity) {
+        entry_i = row_cache->entry_count;
+        row_cache->entry_count++;
+    } else {
+        // Reuse the least recently used entry, entries that were removed are already out of the table.
+        entry_i = row_cache->oldest_i;
+        row_cache_unlink(row_cache, entry_i);
+
+        if (row_cache->entries[entry_i].line != ROW_CACHE_NONE) {
+            row_cache_remove_slot(row_cache, row_cache_find_slot(row_cache, row_cache->entries[entry_i].line));
+
+            // Removing a slot can shift the empty slot that was found for the new line.
+            slot_i = row_cache_find_slot(row_cache, line);
+        }
+    }
+
+    struct RowCacheEntry *entry = &row_cache->entries[entry_i];
+    entry->line = line;
+    row_cache->table[slot_i] = entry_i;
+    row_cache_link_newest(row_cache, entry_i);
+
+    struct List_struct_Vertex *entry_vertices = &entry->vertices;
+    if (vertex_count > entry_vertices->capacity) {
+        entry_vertices->capacity = vertex_count;
+        entry_vertices->data = realloc(entry_vertices->data, entry_vertices->capacity * sizeof(struct Vertex));
+        assert(entry_vertices->data);
+    }
+
+    memcpy(entry_vertices->data, vertices, vertex_count * sizeof(struct Vertex));
+    entry_vertices->length = vertex_count;
+
+    struct List_uint32_t *entry_glyph_keys = &entry->glyph_keys;
+    list_reset_uint32_t(entry_glyph_keys);
+
+    for (size_t i = 0; i < glyph_key_count; i++) {
+        list_push_uint32_t(entry_glyph_keys, glyph_keys[i]);
+    }
+}
+
+static bool row_cache_entry_uses_glyph(
+    struct RowCacheEntry *entry, const uint32_t *glyph_keys, size_t glyph_key_count
+) {
+
+    for (size_t i = 0; i < entry->glyph_keys.length; i++) {
+        for (size_t j = 0; j < glyph_key_count; j++) {
+            if (entry->glyph_keys.data[i] == glyph_keys[j]) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+// Removed entries are moved to the old end of the recency list so they get reused first.
+void row_cache_remove_glyph_users(struct RowCache *row_cache, const uint32_t *glyph_keys, size_t glyph_key_count) {
+    for (uint32_t entry_i = 0; entry_i < row_cache->entry_count; entry_i++) {
+        struct RowCacheEntry *entry = &row_cache->entries[entry_i];
+
+        if (entry->line == ROW_CACHE_NONE || !row_cache_entry_uses_glyph(entry, glyph_keys, glyph_key_count)) {
+            continue;
+        }
+
+        row_cache_remove_slot(row_cache, row_cache_find_slot(row_cache, entry->line));
+        entry->line = ROW_CACHE_NONE;
+
+        row_cache_unlink(row_cache, entry_i);
+        row_cache_link_oldest(row_cache, entry_i);
+    }
+}
+
+void row_cache_clear(struct RowCache *row_cache) {
+    for (size_t i = 0; i < row_cache->table_capacity; i++) {
+        row_cache->table[i] = ROW_CACHE_NONE;
+    }
+
+    row_cache->entry_count = 0;
+    row_cache->newest_i = ROW_CACHE_NONE;
+    row_cache->oldest_i = ROW_CACHE_NONE;
+}
+
+void row_cache_destroy(struct RowCache *row_cache) {
+    for (size_t i = 0; i < row_cache->entry_capacity; i++) {
+        list_destroy_struct_Vertex(&row_cache->entries[i].vertices);
+        list_destroy_uint32_t(&row_cache->entries[i].glyph_keys);
+    }
+
+    free(row_cache->entries);
+    free(row_cache->table);
+}
\ No newline at end of file
@@ -0,0 +1,58 @@
+#ifndef ROW_CACHE_H
+#define ROW_CACHE_H
+
+#include "../detect_leak.h"
+
+#include "../list.h"
+#include "sprite_batch.h"
+
+#include <stdbool.h>
+#include <inttypes.h>
+
+struct RowCacheEntry {
+    // ROW_CACHE_NONE once the entry is removed, it stays in the recency list until it's reused.
+    uint32_t line;
+    struct List_struct_Vertex vertices;
+    // The glyph cache keys the row was built with.
+    struct List_uint32_t glyph_keys;
+
+    // Neighbors in the recency list, or ROW_CACHE_NONE.
+    uint32_t newer_i;
+    uint32_t older_i;
+};
+
+// Built geometry of scrollback lines, keyed by the line's index in the scrollback. Scrollback lines never change
+// once they're pushed, so entries stay valid until whatever they were built with changes. The cache is cleared when
+// the width changes, and only the entries that used a glyph are removed when that glyph changes. The least recently
+// used entry is replaced when the cache is full.
+struct RowCache {
+    struct RowCacheEntry *entries;
+    size_t entry_capacity;
+    size_t entry_count;
+
+    // Open addressed table of entry indices, twice as large as the entry capacity so probes stay short.
+    uint32_t *table;
+    size_t table_capacity;
+
+    uint32_t newest_i;
+    uint32_t oldest_i;
+};
+
+struct RowCache row_cache_create(size_t capacity);
+// Returns NULL if the line isn't cached, otherwise the line becomes the most recently used.
+struct RowCacheEntry *row_cache_get(struct RowCache *row_cache, uint32_t line);
+bool row_cache_contains(struct RowCache *row_cache, uint32_t line);
+void row_cache_put(
+    struct RowCache *row_cache,
+    uint32_t line,
+    const struct Vertex *vertices,
+    size_t vertex_count,
+    const uint32_t *glyph_keys,
+    size_t glyph_key_count
+);
+// Removes every entry that was built with any of the glyphs.
+void row_cache_remove_glyph_users(struct RowCache *row_cache, const uint32_t *glyph_keys, size_t glyph_key_count);
+void row_cache_clear(struct RowCache *row_cache);
+void row_cache_destroy(struct RowCache *row_cache);
+
+#endif
\ No newline at end of file
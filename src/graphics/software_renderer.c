@@ -0,0 +1,484 @@
+#include "software_renderer.h"
+
+#include "../font.h"
+#include "../geometry.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SOFTWARE_RENDERER_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+// Matches the glyph cache's atlas layout, printable ASCII is in the top row followed by the fallback glyph.
+#define SOFTWARE_RENDERER_ATLAS_CELL_WIDTH (FONT_GLYPH_WIDTH + FONT_GLYPH_PADDING)
+// Pixels are RGBA in memory, so as little endian integers alpha is the top byte.
+#define SOFTWARE_RENDERER_OPAQUE 0xff000000
+#define SOFTWARE_RENDERER_CURSOR_COLOR 0xffffffff
+#define SOFTWARE_RENDERER_CURSOR_GLYPH_COLOR 0xff000000
+#define SOFTWARE_RENDERER_NO_CURSOR -1
+
+struct SoftwareRenderer software_renderer_create(
+    size_t grid_width, size_t grid_height, const uint8_t *atlas_pixels, int32_t atlas_width, int32_t atlas_height
+) {
+
+    struct SoftwareRenderer software_renderer = (struct SoftwareRenderer){
+        .atlas_pixels = atlas_pixels,
+        .atlas_width = atlas_width,
+        .atlas_height = atlas_height,
+        .drawn_cursor_y = SOFTWARE_RENDERER_NO_CURSOR,
+        .drawn_selection = {.start_y = 1, .end_y = 0},
+    };
+
+    software_renderer_resize(&software_renderer, grid_width, grid_height);
+
+    return software_renderer;
+}
+
+void software_renderer_on_row_changed_callback(void *context, int32_t y) {
+    struct SoftwareRenderer *software_renderer = context;
+
+    if (y < 0 || y >= software_renderer->grid_height) {
+        return;
+    }
+
+    software_renderer->are_rows_dirty[y] = true;
+}
+
+void software_renderer_on_cursor_changed_callback(void *context) {
+    // The cursor's old and new rows are redrawn on every draw, so there's nothing to track.
+}
+
+void software_renderer_mark_all_rows_dirty(struct SoftwareRenderer *software_renderer) {
+    for (size_t y = 0; y < software_renderer->grid_height; y++) {
+        software_renderer->are_rows_dirty[y] = true;
+    }
+}
+
+void software_renderer_resize(struct SoftwareRenderer *software_renderer, size_t grid_width, size_t grid_height) {
+    software_renderer->grid_width = grid_width;
+    software_renderer->grid_height = grid_height;
+    software_renderer->width = (int32_t)grid_width * FONT_GLYPH_WIDTH;
+    software_renderer->height = (int32_t)grid_height * FONT_GLYPH_HEIGHT;
+
+    size_t pixel_count = (size_t)software_renderer->width * software_renderer->height;
+
+    software_renderer->pixels = realloc(software_renderer->pixels, pixel_count * 4);
+    assert(pixel_count == 0 || software_renderer->pixels);
+    software_renderer->are_rows_dirty = realloc(software_renderer->are_rows_dirty, grid_height * sizeof(bool));
+    assert(grid_height == 0 || software_renderer->are_rows_dirty);
+
+    software_renderer->drawn_cursor_y = SOFTWARE_RENDERER_NO_CURSOR;
+    software_renderer_mark_all_rows_dirty(software_renderer);
+}
+
+void software_renderer_scroll_down(struct SoftwareRenderer *software_renderer) {
+    if (software_renderer->grid_height == 0) {
+        return;
+    }
+
+    size_t row_size = (size_t)software_renderer->width * FONT_GLYPH_HEIGHT * 4;
+    size_t preserved_size = row_size * (software_renderer->grid_height - 1);
+    memmove(software_renderer->pixels, software_renderer->pixels + row_size, preserved_size);
+
+    memmove(
+        software_renderer->are_rows_dirty,
+        software_renderer->are_rows_dirty + 1,
+        (software_renderer->grid_height - 1) * sizeof(bool)
+    );
+    software_renderer->are_rows_dirty[software_renderer->grid_height - 1] = true;
+
+    if (software_renderer->drawn_cursor_y != SOFTWARE_RENDERER_NO_CURSOR) {
+        software_renderer->drawn_cursor_y--;
+    }
+}
+
+static uint32_t software_renderer_resolve_color(struct Grid *grid, uint32_t color) {
+    uint32_t hex = grid_color_to_hex(grid, color);
+
+    return ((hex >> 16) & 0xff) | (hex & 0xff00) | ((hex & 0xff) << 16) | SOFTWARE_RENDERER_OPAQUE;
+}
+
+static uint32_t *software_renderer_get_cell_pixels(struct SoftwareRenderer *software_renderer, int32_t x, int32_t y) {
+    uint32_t *pixels = (uint32_t *)software_renderer->pixels;
+
+    return pixels + (size_t)y * FONT_GLYPH_HEIGHT * software_renderer->width + x * FONT_GLYPH_WIDTH;
+}
+
+// Fills part of a cell, the offset is from the cell's bottom left corner to match the GL renderer's sprites.
+static void software_renderer_fill(
+    struct SoftwareRenderer *software_renderer,
+    int32_t x,
+    int32_t y,
+    int32_t offset_x,
+    int32_t offset_y,
+    int32_t width,
+    int32_t height,
+    uint32_t color
+) {
+
+    uint32_t *pixels = software_renderer_get_cell_pixels(software_renderer, x, y);
+    int32_t start_y = FONT_GLYPH_HEIGHT - offset_y - height;
+
+    for (int32_t pixel_y = start_y; pixel_y < start_y + height; pixel_y++) {
+        uint32_t *row_pixels = pixels + (size_t)pixel_y * software_renderer->width + offset_x;
+
+        for (int32_t pixel_x = 0; pixel_x < width; pixel_x++) {
+            row_pixels[pixel_x] = color;
+        }
+    }
+}
+
+// Finds a glyph in the atlas. Only printable ASCII is available without the glyph cache, everything else uses the
+// fallback glyph, the same as the GL renderer does while a glyph is still being rasterized.
+static void software_renderer_get_glyph_position(uint32_t character, int32_t *texture_x, int32_t *texture_y) {
+    *texture_x = FONT_LENGTH * SOFTWARE_RENDERER_ATLAS_CELL_WIDTH;
+    *texture_y = 0;
+
+    if (character >= 32 && character < 32 + FONT_LENGTH) {
+        *texture_x = (character - 32) * SOFTWARE_RENDERER_ATLAS_CELL_WIDTH;
+    }
+}
+
+// Draws a whole cell, pixels where the glyph is opaque get the foreground color and the rest get the background.
+static void software_renderer_blit_glyph(
+    struct SoftwareRenderer *software_renderer,
+    int32_t x,
+    int32_t y,
+    uint32_t character,
+    uint32_t foreground_color,
+    uint32_t background_color
+) {
+
+    int32_t texture_x;
+    int32_t texture_y;
+    software_renderer_get_glyph_position(character, &texture_x, &texture_y);
+
+    const uint32_t *source = (const uint32_t *)software_renderer->atlas_pixels +
+                             (size_t)texture_y * software_renderer->atlas_width + texture_x;
+    uint32_t *destination = software_renderer_get_cell_pixels(software_renderer, x, y);
+
+#ifdef SOFTWARE_RENDERER_USE_SSE2
+    const __m128i opaque = _mm_set1_epi32((int32_t)SOFTWARE_RENDERER_OPAQUE);
+    const __m128i foreground = _mm_set1_epi32((int32_t)foreground_color);
+    const __m128i background = _mm_set1_epi32((int32_t)background_color);
+#endif
+
+    for (int32_t pixel_y = 0; pixel_y < FONT_GLYPH_HEIGHT; pixel_y++) {
+        int32_t pixel_x = 0;
+
+#ifdef SOFTWARE_RENDERER_USE_SSE2
+        // Each opaque texel becomes a mask of all ones that selects the foreground color.
+        for (; pixel_x + 4 <= FONT_GLYPH_WIDTH; pixel_x += 4) {
+            __m128i texels = _mm_loadu_si128((const __m128i *)(source + pixel_x));
+            __m128i mask = _mm_cmpeq_epi32(_mm_and_si128(texels, opaque), opaque);
+            __m128i colors = _mm_or_si128(_mm_and_si128(mask, foreground), _mm_andnot_si128(mask, background));
+            _mm_storeu_si128((__m128i *)(destination + pixel_x), colors);
+        }
+
+        for (; pixel_x + 2 <= FONT_GLYPH_WIDTH; pixel_x += 2) {
+            __m128i texels = _mm_loadl_epi64((const __m128i *)(source + pixel_x));
+            __m128i mask = _mm_cmpeq_epi32(_mm_and_si128(texels, opaque), opaque);
+            __m128i colors = _mm_or_si128(_mm_and_si128(mask, foreground), _mm_andnot_si128(mask, background));
+            _mm_storel_epi64((__m128i *)(destination + pixel_x), colors);
+        }
+#endif
+
+        for (; pixel_x < FONT_GLYPH_WIDTH; pixel_x++) {
+            bool is_opaque = (source[pixel_x] & SOFTWARE_RENDERER_OPAQUE) == SOFTWARE_RENDERER_OPAQUE;
+            destination[pixel_x] = is_opaque ? foreground_color : background_color;
+        }
+
+        source += software_renderer->atlas_width;
+        destination += software_renderer->width;
+    }
+}
+
+static void software_renderer_draw_horizontal_line(
+    struct SoftwareRenderer *software_renderer, int32_t x, int32_t y, int32_t offset_x, int32_t width, uint32_t color
+) {
+
+    int32_t offset_y = (FONT_GLYPH_HEIGHT - FONT_LINE_WIDTH) / 2;
+    software_renderer_fill(software_renderer, x, y, offset_x, offset_y, width, FONT_LINE_WIDTH, color);
+}
+
+static void software_renderer_draw_vertical_line(
+    struct SoftwareRenderer *software_renderer, int32_t x, int32_t y, int32_t offset_y, int32_t height, uint32_t color
+) {
+
+    int32_t offset_x = (FONT_GLYPH_WIDTH - FONT_LINE_WIDTH) / 2;
+    software_renderer_fill(software_renderer, x, y, offset_x, offset_y, FONT_LINE_WIDTH, height, color);
+}
+
+// Box drawing characters are drawn as lines like the GL renderer does, returns false for any other character.
+static bool software_renderer_draw_box_character(
+    struct SoftwareRenderer *software_renderer,
+    int32_t x,
+    int32_t y,
+    uint32_t character,
+    uint32_t foreground_color,
+    uint32_t background_color
+) {
+
+    const int32_t corner_top = (FONT_GLYPH_HEIGHT + FONT_LINE_WIDTH) / 2;
+    const int32_t corner_bottom = (FONT_GLYPH_HEIGHT - FONT_LINE_WIDTH) / 2;
+    const int32_t corner_left = (FONT_GLYPH_WIDTH - FONT_LINE_WIDTH) / 2;
+    const int32_t corner_right = (FONT_GLYPH_WIDTH + FONT_LINE_WIDTH) / 2;
+
+    switch (character) {
+        case 0x2500:
+        case 0x2502:
+        case 0x250C:
+        case 0x2510:
+        case 0x2514:
+        case 0x2518:
+            break;
+        default:
+            return false;
+    }
+
+    software_renderer_fill(software_renderer, x, y, 0, 0, FONT_GLYPH_WIDTH, FONT_GLYPH_HEIGHT, background_color);
+
+    switch (character) {
+        case 0x2500: {
+            // Thin horizontal line:
+            software_renderer_draw_horizontal_line(software_renderer, x, y, 0, FONT_GLYPH_WIDTH, foreground_color);
+            break;
+        }
+        case 0x2502: {
+            // Thin vertical line:
+            software_renderer_draw_vertical_line(software_renderer, x, y, 0, FONT_GLYPH_HEIGHT, foreground_color);
+            break;
+        }
+        case 0x250C: {
+            // Thin top left corner:
+            software_renderer_draw_horizontal_line(
+                software_renderer,
+                x,
+                y,
+                corner_left,
+                corner_right,
+                foreground_color
+            );
+            software_renderer_draw_vertical_line(software_renderer, x, y, 0, corner_top, foreground_color);
+            break;
+        }
+        case 0x2510: {
+            // Thin top right corner:
+            software_renderer_draw_horizontal_line(software_renderer, x, y, 0, corner_right, foreground_color);
+            software_renderer_draw_vertical_line(software_renderer, x, y, 0, corner_top, foreground_color);
+            break;
+        }
+        case 0x2514: {
+            // Thin bottom left corner:
+            software_renderer_draw_horizontal_line(
+                software_renderer,
+                x,
+                y,
+                corner_left,
+                corner_right,
+                foreground_color
+            );
+            software_renderer_draw_vertical_line(software_renderer, x, y, corner_bottom, corner_top, foreground_color);
+            break;
+        }
+        case 0x2518: {
+            // Thin bottom right corner:
+            software_renderer_draw_horizontal_line(software_renderer, x, y, 0, corner_right, foreground_color);
+            software_renderer_draw_vertical_line(software_renderer, x, y, corner_bottom, corner_top, foreground_color);
+            break;
+        }
+    }
+
+    return true;
+}
+
+// Selected cells swap their foreground and background colors, the same as the GL renderer's shader.
+static void software_renderer_draw_row(
+    struct SoftwareRenderer *software_renderer, struct Grid *grid, int32_t y, struct Selection *selection
+) {
+
+    int32_t line = (int32_t)grid->scrollback_lines.length + y;
+
+    for (int32_t x = 0; x < software_renderer->grid_width; x++) {
+        size_t i = x + y * grid->width;
+        uint32_t character = grid->data[i];
+        uint32_t foreground_color = software_renderer_resolve_color(grid, grid->foreground_colors[i]);
+        uint32_t background_color = software_renderer_resolve_color(grid, grid->background_colors[i]);
+
+        if (selection_contains_point(selection, x, line)) {
+            uint32_t swapped_color = foreground_color;
+            foreground_color = background_color;
+            background_color = swapped_color;
+        }
+
+        if (character == ' ') {
+            software_renderer_fill(
+                software_renderer,
+                x,
+                y,
+                0,
+                0,
+                FONT_GLYPH_WIDTH,
+                FONT_GLYPH_HEIGHT,
+                background_color
+            );
+            continue;
+        }
+
+        if (software_renderer_draw_box_character(
+                software_renderer,
+                x,
+                y,
+                character,
+                foreground_color,
+                background_color
+            )) {
+            continue;
+        }
+
+        software_renderer_blit_glyph(software_renderer, x, y, character, foreground_color, background_color);
+    }
+}
+
+static void software_renderer_draw_cursor(struct SoftwareRenderer *software_renderer, struct Grid *grid) {
+    int32_t cursor_x = int32_min(grid->cursor_x, (int32_t)software_renderer->grid_width - 1);
+    int32_t cursor_y = grid->cursor_y;
+    uint32_t character = grid->data[cursor_x + cursor_y * grid->width];
+
+    switch (grid->cursor_style) {
+        case GRID_CURSOR_STYLE_BLOCK: {
+            // Block cursors show the character underneath them, inverted.
+            software_renderer_blit_glyph(
+                software_renderer,
+                cursor_x,
+                cursor_y,
+                character,
+                SOFTWARE_RENDERER_CURSOR_GLYPH_COLOR,
+                SOFTWARE_RENDERER_CURSOR_COLOR
+            );
+
+            if (character == ' ') {
+                software_renderer_fill(
+                    software_renderer,
+                    cursor_x,
+                    cursor_y,
+                    0,
+                    0,
+                    FONT_GLYPH_WIDTH,
+                    FONT_GLYPH_HEIGHT,
+                    SOFTWARE_RENDERER_CURSOR_COLOR
+                );
+            }
+            break;
+        }
+        case GRID_CURSOR_STYLE_UNDERLINE: {
+            software_renderer_fill(
+                software_renderer,
+                cursor_x,
+                cursor_y,
+                0,
+                0,
+                FONT_GLYPH_WIDTH,
+                FONT_LINE_WIDTH,
+                SOFTWARE_RENDERER_CURSOR_COLOR
+            );
+            break;
+        }
+        case GRID_CURSOR_STYLE_BAR: {
+            software_renderer_fill(
+                software_renderer,
+                cursor_x,
+                cursor_y,
+                0,
+                0,
+                FONT_LINE_WIDTH,
+                FONT_GLYPH_HEIGHT,
+                SOFTWARE_RENDERER_CURSOR_COLOR
+            );
+            break;
+        }
+    }
+
+    software_renderer->drawn_cursor_y = cursor_y;
+}
+
+void software_renderer_draw(
+    struct SoftwareRenderer *software_renderer, struct Grid *grid, const struct Selection *selection
+) {
+
+    // An empty range (the end line is before the start line) selects nothing.
+    struct Selection sorted_selection = {.start_y = 1, .end_y = 0};
+    if (selection) {
+        sorted_selection = *selection;
+        sorted_selection = selection_sorted(&sorted_selection);
+    }
+
+    // Colors are resolved while drawing, so palette changes need every row to be redrawn. Selection changes are
+    // rare enough that redrawing everything for them is fine too.
+    bool did_palette_change = memcmp(software_renderer->drawn_palette, grid->palette, sizeof(grid->palette)) != 0;
+    bool did_selection_change =
+        memcmp(&software_renderer->drawn_selection, &sorted_selection, sizeof(struct Selection)) != 0;
+
+    if (did_palette_change || did_selection_change) {
+        memcpy(software_renderer->drawn_palette, grid->palette, sizeof(grid->palette));
+        software_renderer->drawn_selection = sorted_selection;
+        software_renderer_mark_all_rows_dirty(software_renderer);
+    }
+
+    // Erase the cursor wherever it was last drawn.
+    if (software_renderer->drawn_cursor_y >= 0 && software_renderer->drawn_cursor_y < software_renderer->grid_height) {
+        software_renderer->are_rows_dirty[software_renderer->drawn_cursor_y] = true;
+    }
+    software_renderer->drawn_cursor_y = SOFTWARE_RENDERER_NO_CURSOR;
+
+    bool should_show_cursor = grid->should_show_cursor && grid->cursor_y >= 0 &&
+                              grid->cursor_y < software_renderer->grid_height && software_renderer->grid_width > 0;
+    if (should_show_cursor) {
+        software_renderer->are_rows_dirty[grid->cursor_y] = true;
+    }
+
+    for (int32_t y = 0; y < software_renderer->grid_height; y++) {
+        if (!software_renderer->are_rows_dirty[y]) {
+            continue;
+        }
+        software_renderer->are_rows_dirty[y] = false;
+
+        software_renderer_draw_row(software_renderer, grid, y, &sorted_selection);
+    }
+
+    if (should_show_cursor) {
+        software_renderer_draw_cursor(software_renderer, grid);
+    }
+}
+
+uint8_t *software_renderer_render_to_image(
+    struct Grid *grid,
+    const struct Selection *selection,
+    const uint8_t *atlas_pixels,
+    int32_t atlas_width,
+    int32_t atlas_height,
+    int32_t *width,
+    int32_t *height
+) {
+
+    struct SoftwareRenderer software_renderer =
+        software_renderer_create(grid->width, grid->height, atlas_pixels, atlas_width, atlas_height);
+    software_renderer_draw(&software_renderer, grid, selection);
+
+    uint8_t *pixels = software_renderer.pixels;
+    *width = software_renderer.width;
+    *height = software_renderer.height;
+
+    software_renderer.pixels = NULL;
+    software_renderer_destroy(&software_renderer);
+
+    return pixels;
+}
+
+void software_renderer_destroy(struct SoftwareRenderer *software_renderer) {
+    free(software_renderer->pixels);
+    free(software_renderer->are_rows_dirty);
+}
\ No newline at end of file
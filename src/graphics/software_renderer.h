@@ -0,0 +1,61 @@
+#ifndef SOFTWARE_RENDERER_H
+#define SOFTWARE_RENDERER_H
+
+#include "../detect_leak.h"
+
+#include "../grid.h"
+#include "../selection.h"
+
+#include <stdbool.h>
+#include <inttypes.h>
+
+// Draws the grid into an RGBA framebuffer on the CPU, so rendering doesn't need a GL context. It's used for headless
+// rendering and pixel tests, and as a fallback where there's no GPU acceleration. Only rows that the grid reports as
+// changed are redrawn, the same as the GL renderer, but it always shows the bottom of the scrollback.
+struct SoftwareRenderer {
+    // RGBA, with the top row first.
+    uint8_t *pixels;
+    int32_t width;
+    int32_t height;
+
+    size_t grid_width;
+    size_t grid_height;
+    bool *are_rows_dirty;
+
+    // The atlas glyphs are copied from, in the same RGBA layout the glyph cache starts from.
+    const uint8_t *atlas_pixels;
+    int32_t atlas_width;
+    int32_t atlas_height;
+
+    // What the framebuffer was last drawn with, rows they touched get redrawn when they change.
+    int32_t drawn_cursor_y;
+    struct Selection drawn_selection;
+    uint32_t drawn_palette[GRID_PALETTE_LENGTH];
+};
+
+struct SoftwareRenderer software_renderer_create(
+    size_t grid_width, size_t grid_height, const uint8_t *atlas_pixels, int32_t atlas_width, int32_t atlas_height
+);
+void software_renderer_on_row_changed_callback(void *context, int32_t y);
+void software_renderer_on_cursor_changed_callback(void *context);
+void software_renderer_mark_all_rows_dirty(struct SoftwareRenderer *software_renderer);
+void software_renderer_resize(struct SoftwareRenderer *software_renderer, size_t grid_width, size_t grid_height);
+// Moves the framebuffer up by a row to match the grid scrolling down, only the exposed row needs to be redrawn.
+void software_renderer_scroll_down(struct SoftwareRenderer *software_renderer);
+// The selection uses absolute lines like the GL renderer's, and can be NULL when nothing is selected.
+void software_renderer_draw(
+    struct SoftwareRenderer *software_renderer, struct Grid *grid, const struct Selection *selection
+);
+// Draws a whole grid into a new framebuffer that the caller frees, for comparing against golden images.
+uint8_t *software_renderer_render_to_image(
+    struct Grid *grid,
+    const struct Selection *selection,
+    const uint8_t *atlas_pixels,
+    int32_t atlas_width,
+    int32_t atlas_height,
+    int32_t *width,
+    int32_t *height
+);
+void software_renderer_destroy(struct SoftwareRenderer *software_renderer);
+
+#endif
\ No newline at end of file
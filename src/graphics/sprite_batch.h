@@ -6,38 +6,43 @@
 #include "../list.h"
 #include "mesh.h"
 
+// Sprites are drawn in the order they are added, later sprites are drawn on top of earlier ones.
 struct Sprite {
-    float x;
-    float y;
-    float z;
-    float width;
-    float height;
-
-    float texture_x;
-    float texture_y;
-    float texture_width;
-    float texture_height;
-
-    float r;
-    float g;
-    float b;
+    uint16_t x;
+    uint16_t y;
+    uint16_t width;
+    uint16_t height;
+
+    uint16_t texture_x;
+    uint16_t texture_y;
+    uint16_t texture_width;
+    uint16_t texture_height;
+
+    // Grid color, either a palette index or a color tagged with GRID_COLOR_TRUECOLOR.
+    uint32_t color;
+    // Used instead of the color when the sprite is selected.
+    uint32_t alternate_color;
 };
 
 // Define a list of sprites, type names passed to LIST_DEFINE can't have spaces.
 typedef struct Sprite struct_Sprite;
 LIST_DEFINE(struct_Sprite)
 
+typedef struct Vertex struct_Vertex;
+LIST_DEFINE(struct_Vertex)
+
 struct SpriteBatch {
     struct List_struct_Sprite sprites;
-    struct List_float vertices;
-    struct List_uint32_t indices;
+    struct List_struct_Vertex vertices;
     struct Mesh mesh;
 };
 
-struct SpriteBatch sprite_batch_create(int capacity);
+struct SpriteBatch sprite_batch_create(int capacity, struct IndexBuffer *quad_index_buffer);
 void sprite_batch_begin(struct SpriteBatch *sprite_batch);
 void sprite_batch_add(struct SpriteBatch *sprite_batch, struct Sprite sprite);
-void sprite_batch_end(struct SpriteBatch *sprite_batch, int32_t texture_atlas_width, int32_t texture_atlas_height);
+void sprite_batch_build_vertices(const struct List_struct_Sprite *sprites, struct List_struct_Vertex *vertices);
+void sprite_batch_end(struct SpriteBatch *sprite_batch);
+void sprite_batch_set_vertices(struct SpriteBatch *sprite_batch, const struct Vertex *vertices, size_t vertex_count);
 void sprite_batch_draw(struct SpriteBatch *sprite_batch);
 void sprite_batch_destroy(struct SpriteBatch *sprite_batch);
 
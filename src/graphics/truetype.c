@@ -0,0 +1,659 @@
+#include "truetype.h"
+
+#include "../list.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define TRUETYPE_MAX_COMPOSITE_DEPTH 8
+// Each pixel is sampled on a grid of TRUETYPE_SAMPLES * TRUETYPE_SAMPLES points.
+#define TRUETYPE_SAMPLES 4
+// Pixels are set when at least this many of their samples are inside the glyph, it's less than half the samples
+// so that thin strokes don't disappear at small sizes.
+#define TRUETYPE_COVERAGE_THRESHOLD 6
+#define TRUETYPE_CURVE_SEGMENTS 4
+
+#define TRUETYPE_FLAG_ON_CURVE 0x01
+#define TRUETYPE_FLAG_X_SHORT 0x02
+#define TRUETYPE_FLAG_Y_SHORT 0x04
+#define TRUETYPE_FLAG_REPEAT 0x08
+#define TRUETYPE_FLAG_X_SAME_OR_POSITIVE 0x10
+#define TRUETYPE_FLAG_Y_SAME_OR_POSITIVE 0x20
+
+#define TRUETYPE_COMPONENT_ARGS_ARE_WORDS 0x0001
+#define TRUETYPE_COMPONENT_ARGS_ARE_XY_VALUES 0x0002
+#define TRUETYPE_COMPONENT_HAS_SCALE 0x0008
+#define TRUETYPE_COMPONENT_HAS_MORE 0x0020
+#define TRUETYPE_COMPONENT_HAS_XY_SCALE 0x0040
+#define TRUETYPE_COMPONENT_HAS_2X2 0x0080
+
+struct TrueTypeEdge {
+    float x0;
+    float y0;
+    float x1;
+    float y1;
+};
+
+typedef struct TrueTypeEdge struct_TrueTypeEdge;
+LIST_DEFINE(struct_TrueTypeEdge)
+
+// Where an edge crosses a row of samples, the direction is used for the non-zero winding rule.
+struct TrueTypeCrossing {
+    float x;
+    int8_t direction;
+};
+
+struct TrueTypePoint {
+    float x;
+    float y;
+    bool is_on_curve;
+};
+
+// Maps font units to pixels, including the transform of any composite glyphs the outline is part of.
+struct TrueTypeTransform {
+    float xx;
+    float xy;
+    float yx;
+    float yy;
+    float dx;
+    float dy;
+};
+
+static uint16_t truetype_read_u16(struct TrueTypeFont *font, size_t offset) {
+    if (offset + 2 > font->length) {
+        return 0;
+    }
+
+    return (font->data[offset] << 8) | font->data[offset + 1];
+}
+
+static int16_t truetype_read_i16(struct TrueTypeFont *font, size_t offset) {
+    return (int16_t)truetype_read_u16(font, offset);
+}
+
+static uint32_t truetype_read_u32(struct TrueTypeFont *font, size_t offset) {
+    return ((uint32_t)truetype_read_u16(font, offset) << 16) | truetype_read_u16(font, offset + 2);
+}
+
+static uint32_t truetype_find_table(struct TrueTypeFont *font, const char *tag) {
+    uint16_t table_count = truetype_read_u16(font, 4);
+
+    for (size_t i = 0; i < table_count; i++) {
+        size_t record_offset = 12 + i * 16;
+
+        if (record_offset + 16 > font->length) {
+            break;
+        }
+
+        if (memcmp(font->data + record_offset, tag, 4) == 0) {
+            return truetype_read_u32(font, record_offset + 8);
+        }
+    }
+
+    return 0;
+}
+
+static void truetype_find_cmap_subtable(struct TrueTypeFont *font, uint32_t cmap_offset) {
+    uint16_t encoding_count = truetype_read_u16(font, cmap_offset + 2);
+
+    for (size_t i = 0; i < encoding_count; i++) {
+        size_t record_offset = cmap_offset + 4 + i * 8;
+        uint16_t platform_id = truetype_read_u16(font, record_offset);
+        uint16_t encoding_id = truetype_read_u16(font, record_offset + 2);
+        uint32_t subtable_offset = cmap_offset + truetype_read_u32(font, record_offset + 4);
+        uint16_t format = truetype_read_u16(font, subtable_offset);
+
+        bool is_unicode = platform_id == 0 || (platform_id == 3 && (encoding_id == 1 || encoding_id == 10));
+        if (!is_unicode || (format != 4 && format != 12)) {
+            continue;
+        }
+
+        // Prefer format 12, it covers codepoints outside of the basic multilingual plane.
+        if (font->cmap_format == 12) {
+            continue;
+        }
+
+        font->cmap_subtable_offset = subtable_offset;
+        font->cmap_format = format;
+    }
+}
+
+bool truetype_font_init(struct TrueTypeFont *font, const uint8_t *data, size_t length) {
+    *font = (struct TrueTypeFont){
+        .data = data,
+        .length = length,
+    };
+
+    uint32_t head_offset = truetype_find_table(font, "head");
+    uint32_t hhea_offset = truetype_find_table(font, "hhea");
+    uint32_t maxp_offset = truetype_find_table(font, "maxp");
+    uint32_t cmap_offset = truetype_find_table(font, "cmap");
+    font->loca_offset = truetype_find_table(font, "loca");
+    font->glyf_offset = truetype_find_table(font, "glyf");
+    font->hmtx_offset = truetype_find_table(font, "hmtx");
+
+    if (!head_offset || !hhea_offset || !maxp_offset || !cmap_offset || !font->loca_offset || !font->glyf_offset ||
+        !font->hmtx_offset) {
+        return false;
+    }
+
+    font->units_per_em = truetype_read_u16(font, head_offset + 18);
+    font->is_loca_long = truetype_read_i16(font, head_offset + 50) != 0;
+    font->glyph_count = truetype_read_u16(font, maxp_offset + 4);
+    font->ascender = truetype_read_i16(font, hhea_offset + 4);
+    font->descender = truetype_read_i16(font, hhea_offset + 6);
+    font->horizontal_metric_count = truetype_read_u16(font, hhea_offset + 34);
+
+    truetype_find_cmap_subtable(font, cmap_offset);
+
+    return font->cmap_format != 0 && font->units_per_em != 0 && font->ascender > font->descender;
+}
+
+uint32_t truetype_get_glyph_index(struct TrueTypeFont *font, uint32_t codepoint) {
+    uint32_t subtable = font->cmap_subtable_offset;
+
+    if (font->cmap_format == 12) {
+        uint32_t group_count = truetype_read_u32(font, subtable + 12);
+
+        // Groups are sorted by codepoint.
+        uint32_t low = 0;
+        uint32_t high = group_count;
+        while (low < high) {
+            uint32_t middle = low + (high - low) / 2;
+            size_t group_offset = subtable + 16 + middle * 12;
+            uint32_t start_codepoint = truetype_read_u32(font, group_offset);
+            uint32_t end_codepoint = truetype_read_u32(font, group_offset + 4);
+
+            if (codepoint < start_codepoint) {
+                high = middle;
+            } else if (codepoint > end_codepoint) {
+                low = middle + 1;
+            } else {
+                return truetype_read_u32(font, group_offset + 8) + codepoint - start_codepoint;
+            }
+        }
+
+        return 0;
+    }
+
+    if (codepoint > 0xffff) {
+        return 0;
+    }
+
+    uint16_t segment_count = truetype_read_u16(font, subtable + 6) / 2;
+    size_t end_codes_offset = subtable + 14;
+    size_t start_codes_offset = end_codes_offset + segment_count * 2 + 2;
+    size_t deltas_offset = start_codes_offset + segment_count * 2;
+    size_t range_offsets_offset = deltas_offset + segment_count * 2;
+
+    for (size_t segment_i = 0; segment_i < segment_count; segment_i++) {
+        if (codepoint > truetype_read_u16(font, end_codes_offset + segment_i * 2)) {
+            continue;
+        }
+
+        uint16_t start_code = truetype_read_u16(font, start_codes_offset + segment_i * 2);
+        if (codepoint < start_code) {
+            return 0;
+        }
+
+        uint16_t delta = truetype_read_u16(font, deltas_offset + segment_i * 2);
+        size_t range_offset_offset = range_offsets_offset + segment_i * 2;
+        uint16_t range_offset = truetype_read_u16(font, range_offset_offset);
+
+        if (range_offset == 0) {
+            return (codepoint + delta) & 0xffff;
+        }
+
+        uint16_t glyph_index =
+            truetype_read_u16(font, range_offset_offset + range_offset + (codepoint - start_code) * 2);
+        if (glyph_index == 0) {
+            return 0;
+        }
+
+        return (glyph_index + delta) & 0xffff;
+    }
+
+    return 0;
+}
+
+static uint16_t truetype_get_advance_width(struct TrueTypeFont *font, uint32_t glyph_index) {
+    if (font->horizontal_metric_count == 0) {
+        return font->units_per_em;
+    }
+
+    if (glyph_index >= font->horizontal_metric_count) {
+        glyph_index = font->horizontal_metric_count - 1;
+    }
+
+    return truetype_read_u16(font, font->hmtx_offset + glyph_index * 4);
+}
+
+// Returns the offset of the glyph's outline, or 0 if the glyph has no outline.
+static uint32_t truetype_get_glyph_offset(struct TrueTypeFont *font, uint32_t glyph_index) {
+    if (glyph_index >= font->glyph_count) {
+        return 0;
+    }
+
+    uint32_t start;
+    uint32_t end;
+
+    if (font->is_loca_long) {
+        start = truetype_read_u32(font, font->loca_offset + glyph_index * 4);
+        end = truetype_read_u32(font, font->loca_offset + glyph_index * 4 + 4);
+    } else {
+        start = truetype_read_u16(font, font->loca_offset + glyph_index * 2) * 2;
+        end = truetype_read_u16(font, font->loca_offset + glyph_index * 2 + 2) * 2;
+    }
+
+    if (start == end) {
+        return 0;
+    }
+
+    return font->glyf_offset + start;
+}
+
+static void truetype_add_line(struct List_struct_TrueTypeEdge *edges, float x0, float y0, float x1, float y1) {
+    // Horizontal edges never cross a sample row.
+    if (y0 == y1) {
+        return;
+    }
+
+    list_push_struct_TrueTypeEdge(
+        edges,
+        (struct TrueTypeEdge){
+            .x0 = x0,
+            .y0 = y0,
+            .x1 = x1,
+            .y1 = y1,
+        }
+    );
+}
+
+static void truetype_add_curve(
+    struct List_struct_TrueTypeEdge *edges,
+    struct TrueTypePoint start,
+    struct TrueTypePoint control,
+    struct TrueTypePoint end
+) {
+
+    float last_x = start.x;
+    float last_y = start.y;
+
+    for (size_t i = 1; i <= TRUETYPE_CURVE_SEGMENTS; i++) {
+        float t = i / (float)TRUETYPE_CURVE_SEGMENTS;
+        float inverse_t = 1.0f - t;
+
+        float x = inverse_t * inverse_t * start.x + 2.0f * inverse_t * t * control.x + t * t * end.x;
+        float y = inverse_t * inverse_t * start.y + 2.0f * inverse_t * t * control.y + t * t * end.y;
+
+        truetype_add_line(edges, last_x, last_y, x, y);
+
+        last_x = x;
+        last_y = y;
+    }
+}
+
+static struct TrueTypePoint truetype_midpoint(struct TrueTypePoint a, struct TrueTypePoint b) {
+    return (struct TrueTypePoint){
+        .x = (a.x + b.x) * 0.5f,
+        .y = (a.y + b.y) * 0.5f,
+        .is_on_curve = true,
+    };
+}
+
+static void truetype_add_contour(
+    struct List_struct_TrueTypeEdge *edges, struct TrueTypePoint *points, size_t point_count
+) {
+
+    if (point_count < 2) {
+        return;
+    }
+
+    // Find a point on the curve to start from, if there isn't one then the midpoint of the first and last
+    // points is implicitly on the curve.
+    struct TrueTypePoint start = truetype_midpoint(points[point_count - 1], points[0]);
+    size_t start_i = 0;
+    size_t remaining_count = point_count;
+
+    for (size_t i = 0; i < point_count; i++) {
+        if (points[i].is_on_curve) {
+            start = points[i];
+            start_i = i + 1;
+            remaining_count = point_count - 1;
+            break;
+        }
+    }
+
+    struct TrueTypePoint current = start;
+    struct TrueTypePoint control = {0};
+    bool has_control = false;
+
+    // Visit every remaining point, then return to the start to close the contour.
+    for (size_t i = 0; i <= remaining_count; i++) {
+        struct TrueTypePoint point = i < remaining_count ? points[(start_i + i) % point_count] : start;
+
+        if (point.is_on_curve) {
+            if (has_control) {
+                truetype_add_curve(edges, current, control, point);
+            } else {
+                truetype_add_line(edges, current.x, current.y, point.x, point.y);
+            }
+
+            current = point;
+            has_control = false;
+            continue;
+        }
+
+        // Two off curve points in a row have an implied on curve point between them.
+        if (has_control) {
+            struct TrueTypePoint midpoint = truetype_midpoint(control, point);
+            truetype_add_curve(edges, current, control, midpoint);
+            current = midpoint;
+        }
+
+        control = point;
+        has_control = true;
+    }
+}
+
+static void truetype_add_simple_glyph(
+    struct TrueTypeFont *font,
+    uint32_t offset,
+    int16_t contour_count,
+    struct TrueTypeTransform *transform,
+    struct List_struct_TrueTypeEdge *edges
+) {
+
+    size_t end_points_offset = offset + 10;
+    uint16_t point_count = truetype_read_u16(font, end_points_offset + (contour_count - 1) * 2) + 1;
+    uint16_t instruction_length = truetype_read_u16(font, end_points_offset + contour_count * 2);
+    size_t flags_offset = end_points_offset + contour_count * 2 + 2 + instruction_length;
+
+    struct TrueTypePoint *points = malloc(point_count * sizeof(struct TrueTypePoint));
+    uint8_t *flags = malloc(point_count);
+    assert(points);
+    assert(flags);
+
+    // Flags can be repeated to save space.
+    size_t read_offset = flags_offset;
+    for (size_t i = 0; i < point_count;) {
+        uint8_t flag = read_offset < font->length ? font->data[read_offset] : 0;
+        read_offset++;
+        flags[i++] = flag;
+
+        if (flag & TRUETYPE_FLAG_REPEAT) {
+            uint8_t repeat_count = read_offset < font->length ? font->data[read_offset] : 0;
+            read_offset++;
+
+            for (size_t repeat_i = 0; repeat_i < repeat_count && i < point_count; repeat_i++) {
+                flags[i++] = flag;
+            }
+        }
+    }
+
+    // Coordinates are stored as deltas from the previous point, all x coordinates come before all y coordinates.
+    int32_t x = 0;
+    for (size_t i = 0; i < point_count; i++) {
+        if (flags[i] & TRUETYPE_FLAG_X_SHORT) {
+            uint8_t delta = read_offset < font->length ? font->data[read_offset] : 0;
+            read_offset++;
+            x += flags[i] & TRUETYPE_FLAG_X_SAME_OR_POSITIVE ? delta : -delta;
+        } else if (!(flags[i] & TRUETYPE_FLAG_X_SAME_OR_POSITIVE)) {
+            x += truetype_read_i16(font, read_offset);
+            read_offset += 2;
+        }
+
+        points[i].x = x;
+        points[i].is_on_curve = flags[i] & TRUETYPE_FLAG_ON_CURVE;
+    }
+
+    int32_t y = 0;
+    for (size_t i = 0; i < point_count; i++) {
+        if (flags[i] & TRUETYPE_FLAG_Y_SHORT) {
+            uint8_t delta = read_offset < font->length ? font->data[read_offset] : 0;
+            read_offset++;
+            y += flags[i] & TRUETYPE_FLAG_Y_SAME_OR_POSITIVE ? delta : -delta;
+        } else if (!(flags[i] & TRUETYPE_FLAG_Y_SAME_OR_POSITIVE)) {
+            y += truetype_read_i16(font, read_offset);
+            read_offset += 2;
+        }
+
+        points[i].y = y;
+    }
+
+    for (size_t i = 0; i < point_count; i++) {
+        float font_x = points[i].x;
+        float font_y = points[i].y;
+
+        points[i].x = transform->xx * font_x + transform->yx * font_y + transform->dx;
+        points[i].y = transform->xy * font_x + transform->yy * font_y + transform->dy;
+    }
+
+    size_t contour_start = 0;
+    for (size_t contour_i = 0; contour_i < contour_count; contour_i++) {
+        size_t contour_end = truetype_read_u16(font, end_points_offset + contour_i * 2) + 1;
+
+        if (contour_end > point_count || contour_end <= contour_start) {
+            break;
+        }
+
+        truetype_add_contour(edges, points + contour_start, contour_end - contour_start);
+        contour_start = contour_end;
+    }
+
+    free(points);
+    free(flags);
+}
+
+static float truetype_read_f2dot14(struct TrueTypeFont *font, size_t offset) {
+    return truetype_read_i16(font, offset) / 16384.0f;
+}
+
+static void truetype_add_glyph(
+    struct TrueTypeFont *font,
+    uint32_t glyph_index,
+    struct TrueTypeTransform *transform,
+    size_t depth,
+    struct List_struct_TrueTypeEdge *edges
+);
+
+static void truetype_add_composite_glyph(
+    struct TrueTypeFont *font,
+    uint32_t offset,
+    struct TrueTypeTransform *transform,
+    size_t depth,
+    struct List_struct_TrueTypeEdge *edges
+) {
+
+    size_t read_offset = offset + 10;
+    uint16_t flags;
+
+    do {
+        flags = truetype_read_u16(font, read_offset);
+        uint16_t component_glyph_index = truetype_read_u16(font, read_offset + 2);
+        read_offset += 4;
+
+        float dx = 0.0f;
+        float dy = 0.0f;
+
+        if (flags & TRUETYPE_COMPONENT_ARGS_ARE_WORDS) {
+            dx = truetype_read_i16(font, read_offset);
+            dy = truetype_read_i16(font, read_offset + 2);
+            read_offset += 4;
+        } else {
+            dx = (int8_t)(read_offset < font->length ? font->data[read_offset] : 0);
+            dy = (int8_t)(read_offset + 1 < font->length ? font->data[read_offset + 1] : 0);
+            read_offset += 2;
+        }
+
+        // Components positioned by matching points are rare, place them without an offset.
+        if (!(flags & TRUETYPE_COMPONENT_ARGS_ARE_XY_VALUES)) {
+            dx = 0.0f;
+            dy = 0.0f;
+        }
+
+        float xx = 1.0f;
+        float xy = 0.0f;
+        float yx = 0.0f;
+        float yy = 1.0f;
+
+        if (flags & TRUETYPE_COMPONENT_HAS_SCALE) {
+            xx = truetype_read_f2dot14(font, read_offset);
+            yy = xx;
+            read_offset += 2;
+        } else if (flags & TRUETYPE_COMPONENT_HAS_XY_SCALE) {
+            xx = truetype_read_f2dot14(font, read_offset);
+            yy = truetype_read_f2dot14(font, read_offset + 2);
+            read_offset += 4;
+        } else if (flags & TRUETYPE_COMPONENT_HAS_2X2) {
+            xx = truetype_read_f2dot14(font, read_offset);
+            xy = truetype_read_f2dot14(font, read_offset + 2);
+            yx = truetype_read_f2dot14(font, read_offset + 4);
+            yy = truetype_read_f2dot14(font, read_offset + 6);
+            read_offset += 8;
+        }
+
+        // Apply the component's transform first, then the parent's.
+        struct TrueTypeTransform component_transform = {
+            .xx = transform->xx * xx + transform->yx * xy,
+            .xy = transform->xy * xx + transform->yy * xy,
+            .yx = transform->xx * yx + transform->yx * yy,
+            .yy = transform->xy * yx + transform->yy * yy,
+            .dx = transform->xx * dx + transform->yx * dy + transform->dx,
+            .dy = transform->xy * dx + transform->yy * dy + transform->dy,
+        };
+
+        truetype_add_glyph(font, component_glyph_index, &component_transform, depth + 1, edges);
+    } while (flags & TRUETYPE_COMPONENT_HAS_MORE && read_offset < font->length);
+}
+
+static void truetype_add_glyph(
+    struct TrueTypeFont *font,
+    uint32_t glyph_index,
+    struct TrueTypeTransform *transform,
+    size_t depth,
+    struct List_struct_TrueTypeEdge *edges
+) {
+
+    if (depth > TRUETYPE_MAX_COMPOSITE_DEPTH) {
+        return;
+    }
+
+    uint32_t offset = truetype_get_glyph_offset(font, glyph_index);
+    if (offset == 0) {
+        return;
+    }
+
+    int16_t contour_count = truetype_read_i16(font, offset);
+
+    if (contour_count > 0) {
+        truetype_add_simple_glyph(font, offset, contour_count, transform, edges);
+    } else if (contour_count < 0) {
+        truetype_add_composite_glyph(font, offset, transform, depth, edges);
+    }
+}
+
+static int truetype_compare_crossings(const void *a, const void *b) {
+    float crossing_a = ((const struct TrueTypeCrossing *)a)->x;
+    float crossing_b = ((const struct TrueTypeCrossing *)b)->x;
+
+    return (crossing_a > crossing_b) - (crossing_a < crossing_b);
+}
+
+void truetype_rasterize_glyph(
+    struct TrueTypeFont *font, uint32_t glyph_index, int32_t width, int32_t height, uint8_t *bitmap
+) {
+
+    memset(bitmap, 0, width * height);
+
+    // Fit the font's full line height into the cell, unless that would make the glyph too wide.
+    float scale = height / (float)(font->ascender - font->descender);
+    float advance_width = truetype_get_advance_width(font, glyph_index);
+    if (advance_width * scale > width) {
+        scale = width / advance_width;
+    }
+
+    struct TrueTypeTransform transform = {
+        .xx = scale,
+        .yy = scale,
+        .dx = (width - advance_width * scale) * 0.5f,
+        .dy = -font->descender * scale,
+    };
+
+    struct List_struct_TrueTypeEdge edges = list_create_struct_TrueTypeEdge(64);
+    truetype_add_glyph(font, glyph_index, &transform, 0, &edges);
+
+    uint8_t *coverage = calloc(width * height, sizeof(uint8_t));
+    struct TrueTypeCrossing *crossings = malloc((edges.length + 1) * sizeof(struct TrueTypeCrossing));
+    assert(coverage);
+    assert(crossings);
+
+    for (int32_t sample_y_i = 0; sample_y_i < height * TRUETYPE_SAMPLES; sample_y_i++) {
+        // Sample rows go from the top of the cell to the bottom, while outlines have y pointing up.
+        float sample_y = height - (sample_y_i + 0.5f) / TRUETYPE_SAMPLES;
+        size_t crossing_count = 0;
+
+        for (size_t edge_i = 0; edge_i < edges.length; edge_i++) {
+            struct TrueTypeEdge *edge = &edges.data[edge_i];
+            bool is_upward = edge->y1 > edge->y0;
+            float min_y = is_upward ? edge->y0 : edge->y1;
+            float max_y = is_upward ? edge->y1 : edge->y0;
+
+            if (sample_y < min_y || sample_y >= max_y) {
+                continue;
+            }
+
+            float t = (sample_y - edge->y0) / (edge->y1 - edge->y0);
+            crossings[crossing_count] = (struct TrueTypeCrossing){
+                .x = edge->x0 + t * (edge->x1 - edge->x0),
+                .direction = is_upward ? 1 : -1,
+            };
+            crossing_count++;
+        }
+
+        if (crossing_count == 0) {
+            continue;
+        }
+
+        qsort(crossings, crossing_count, sizeof(struct TrueTypeCrossing), truetype_compare_crossings);
+
+        int32_t pixel_y = sample_y_i / TRUETYPE_SAMPLES;
+        int32_t winding = 0;
+
+        for (size_t crossing_i = 0; crossing_i + 1 < crossing_count; crossing_i++) {
+            winding += crossings[crossing_i].direction;
+
+            if (winding == 0) {
+                continue;
+            }
+
+            // Count the samples in this row that fall inside the span between the two crossings.
+            float span_start = crossings[crossing_i].x;
+            float span_end = crossings[crossing_i + 1].x;
+
+            int32_t first_sample_x = (int32_t)(span_start * TRUETYPE_SAMPLES + 0.5f);
+            int32_t last_sample_x = (int32_t)(span_end * TRUETYPE_SAMPLES - 0.5f);
+
+            if (first_sample_x < 0) {
+                first_sample_x = 0;
+            }
+
+            if (last_sample_x >= width * TRUETYPE_SAMPLES) {
+                last_sample_x = width * TRUETYPE_SAMPLES - 1;
+            }
+
+            for (int32_t sample_x_i = first_sample_x; sample_x_i <= last_sample_x; sample_x_i++) {
+                coverage[pixel_y * width + sample_x_i / TRUETYPE_SAMPLES]++;
+            }
+        }
+    }
+
+    for (int32_t i = 0; i < width * height; i++) {
+        bitmap[i] = coverage[i] >= TRUETYPE_COVERAGE_THRESHOLD;
+    }
+
+    free(coverage);
+    free(crossings);
+    list_destroy_struct_TrueTypeEdge(&edges);
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#ifndef TRUETYPE_H
+#define TRUETYPE_H
+
+#include "../detect_leak.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <inttypes.h>
+
+// A minimal TrueType reader, it supports the subset of the format needed to rasterize monochrome glyphs for
+// the terminal: cmap formats 4 and 12 and simple or composite outlines from the glyf table. Hinting is ignored.
+struct TrueTypeFont {
+    const uint8_t *data;
+    size_t length;
+
+    uint32_t cmap_subtable_offset;
+    uint16_t cmap_format;
+    uint32_t loca_offset;
+    uint32_t glyf_offset;
+    uint32_t hmtx_offset;
+
+    bool is_loca_long;
+    uint16_t glyph_count;
+    uint16_t horizontal_metric_count;
+    uint16_t units_per_em;
+    int16_t ascender;
+    int16_t descender;
+};
+
+bool truetype_font_init(struct TrueTypeFont *font, const uint8_t *data, size_t length);
+// Returns 0 (the missing glyph) if the font doesn't contain the codepoint.
+uint32_t truetype_get_glyph_index(struct TrueTypeFont *font, uint32_t codepoint);
+// Rasterizes a glyph to fit a width * height cell, the bitmap has one byte per pixel (0 or 1) with the top row
+// first.
+void truetype_rasterize_glyph(
+    struct TrueTypeFont *font, uint32_t glyph_index, int32_t width, int32_t height, uint8_t *bitmap
+);
+
+#endif
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "font.h"
 #include "geometry.h"
 
+#include <stdio.h>
 #include <math.h>
 
 const uint32_t color_table[256] = {
@@ -33,8 +34,34 @@ const uint32_t color_table[256] = {
     0xdadada, 0xe4e4e4, 0xeeeeee,
 };
 
+const uint32_t named_colors[GRID_PALETTE_NAMED_LENGTH] = {
+    0x0c0c0c, 0xc50f1f, 0x13a10e, 0xc19c00, 0x0037da, 0x881798, 0x3a96dd, 0xcccccc, 0x767676, 0xe74856, 0x16c60c,
+    0xf9f1a5, 0x3b78ff, 0xb4009e, 0x61d6d6, 0xf2f2f2,
+};
+
+#define GRID_HEX_FOREGROUND_DEFAULT 0xcccccc
+#define GRID_HEX_BACKGROUND_DEFAULT 0x0c0c0c
+
+static void grid_reset_palette_color(struct Grid *grid, uint32_t palette_i) {
+    if (palette_i < GRID_PALETTE_TABLE_LENGTH) {
+        grid->palette[palette_i] = color_table[palette_i];
+    } else if (palette_i < GRID_PALETTE_NAMED_START + GRID_PALETTE_NAMED_LENGTH) {
+        grid->palette[palette_i] = named_colors[palette_i - GRID_PALETTE_NAMED_START];
+    } else if (palette_i == GRID_COLOR_FOREGROUND_DEFAULT) {
+        grid->palette[palette_i] = GRID_HEX_FOREGROUND_DEFAULT;
+    } else if (palette_i == GRID_COLOR_BACKGROUND_DEFAULT) {
+        grid->palette[palette_i] = GRID_HEX_BACKGROUND_DEFAULT;
+    }
+
+    grid->is_palette_dirty = true;
+}
+
 struct Grid grid_create(
-    size_t width, size_t height, void *callback_context, void (*on_row_changed)(void *context, int32_t y)
+    size_t width,
+    size_t height,
+    void *callback_context,
+    void (*on_row_changed)(void *context, int32_t y),
+    void (*on_cursor_changed)(void *context)
 ) {
 
     size_t size = width * height;
@@ -43,7 +70,9 @@ struct Grid grid_create(
         .width = width,
         .height = height,
         .size = size,
+        .capacity = size,
 
+        .wrapped_rows = calloc(height, sizeof(bool)),
         .scrollback_lines = list_create_struct_ScrollbackLine(64),
 
         .background_colors = malloc(size * sizeof(uint32_t)),
@@ -52,15 +81,23 @@ struct Grid grid_create(
         .current_background_color = GRID_COLOR_BACKGROUND_DEFAULT,
         .current_foreground_color = GRID_COLOR_FOREGROUND_DEFAULT,
 
+        .replies = list_create_uint8_t(64),
+
         .callback_context = callback_context,
         .on_row_changed = on_row_changed,
+        .on_cursor_changed = on_cursor_changed,
     };
     assert(grid.data);
+    assert(grid.wrapped_rows);
 
     for (size_t i = 0; i < size; i++) {
         grid_set_char_i(&grid, i, ' ');
     }
 
+    for (uint32_t i = 0; i < GRID_PALETTE_LENGTH; i++) {
+        grid_reset_palette_color(&grid, i);
+    }
+
     return grid;
 }
 
@@ -92,9 +129,10 @@ size_t grid_get_occupied_height(struct Grid *grid) {
     return occupied_grid_height;
 }
 
-void grid_push_partial_line_to_scrollback(struct Grid *grid, size_t y, size_t length) {
+void grid_push_partial_line_to_scrollback(struct Grid *grid, size_t y, size_t length, bool is_wrapped) {
     struct ScrollbackLine scrollback_line = {
         .length = length,
+        .is_wrapped = is_wrapped,
     };
 
     size_t start_offset = y * grid->width;
@@ -112,11 +150,12 @@ void grid_push_partial_line_to_scrollback(struct Grid *grid, size_t y, size_t le
     memcpy(scrollback_line.foreground_colors, grid->foreground_colors + start_offset, length * sizeof(uint32_t));
 
     list_push_struct_ScrollbackLine(&grid->scrollback_lines, scrollback_line);
+    grid->scrollback_byte_count += length * sizeof(uint32_t) * 3;
 }
 
 void grid_push_line_to_scrollback(struct Grid *grid, size_t y) {
     size_t length = grid_get_occupied_line_length(grid, y);
-    grid_push_partial_line_to_scrollback(grid, y, length);
+    grid_push_partial_line_to_scrollback(grid, y, length, grid->wrapped_rows[y]);
 }
 
 // When resizing the grid, the pseudo console will wrap lines, overwriting
@@ -143,57 +182,71 @@ void grid_resize_update_scrollback(struct Grid *grid, size_t width, size_t heigh
         }
 
         // Only part of the line is excess (which means this is also the last of the excess lines).
-        grid_push_partial_line_to_scrollback(grid, y, excess_line_count * width);
+        grid_push_partial_line_to_scrollback(grid, y, excess_line_count * width, true);
         break;
     }
 }
 
+// Moves rows from the old width to the new width in place, rows that are new or widened are filled with the blank
+// value. Rows move towards the end of the array when the grid gets wider, so they're moved starting with the last row
+// to avoid overwriting rows that haven't been moved yet.
+static void grid_relayout_cells(
+    uint32_t *cells, size_t old_width, size_t old_height, size_t width, size_t height, uint32_t blank
+) {
+
+    size_t preserved_width = old_width < width ? old_width : width;
+    size_t preserved_height = old_height < height ? old_height : height;
+
+    for (size_t i = 0; i < preserved_height; i++) {
+        size_t y = width > old_width ? preserved_height - 1 - i : i;
+
+        memmove(cells + y * width, cells + y * old_width, preserved_width * sizeof(uint32_t));
+
+        for (size_t x = preserved_width; x < width; x++) {
+            cells[x + y * width] = blank;
+        }
+    }
+
+    for (size_t i = preserved_height * width; i < width * height; i++) {
+        cells[i] = blank;
+    }
+}
+
+// Resizes in place, the cell arrays only get reallocated if they need to grow past their capacity.
 void grid_resize(struct Grid *grid, size_t width, size_t height) {
     grid_resize_update_scrollback(grid, width, height);
 
-    grid->size = width * height;
-
     size_t old_width = grid->width;
-    grid->width = width;
     size_t old_height = grid->height;
+
+    grid->size = width * height;
+    grid->width = width;
     grid->height = height;
 
-    uint32_t *old_data = grid->data;
-    grid->data = malloc(grid->size * sizeof(uint32_t));
-    assert(grid->data);
+    if (grid->size > grid->capacity) {
+        grid->capacity = grid->size;
+
+        grid->data = realloc(grid->data, grid->capacity * sizeof(uint32_t));
+        assert(grid->data);
+        grid->background_colors = realloc(grid->background_colors, grid->capacity * sizeof(uint32_t));
+        assert(grid->background_colors);
+        grid->foreground_colors = realloc(grid->foreground_colors, grid->capacity * sizeof(uint32_t));
+        assert(grid->foreground_colors);
+    }
 
-    uint32_t *old_background_colors = grid->background_colors;
-    grid->background_colors = malloc(grid->size * sizeof(uint32_t));
-    assert(grid->background_colors);
+    grid_relayout_cells(grid->data, old_width, old_height, width, height, ' ');
+    grid_relayout_cells(grid->background_colors, old_width, old_height, width, height, GRID_COLOR_BACKGROUND_DEFAULT);
+    grid_relayout_cells(grid->foreground_colors, old_width, old_height, width, height, GRID_COLOR_FOREGROUND_DEFAULT);
 
-    uint32_t *old_foreground_colors = grid->foreground_colors;
-    grid->foreground_colors = malloc(grid->size * sizeof(uint32_t));
-    assert(grid->foreground_colors);
+    // The pseudo console rewraps and redraws the screen after a resize, so rows only count as wrapped again once
+    // they're rewritten.
+    free(grid->wrapped_rows);
+    grid->wrapped_rows = calloc(height, sizeof(bool));
+    assert(grid->wrapped_rows);
 
     for (size_t y = 0; y < grid->height; y++) {
         grid->on_row_changed(grid->callback_context, y);
-
-        for (size_t x = 0; x < grid->width; x++) {
-            size_t i = x + y * grid->width;
-
-            if (x < old_width && y < old_height) {
-                size_t old_i = x + y * old_width;
-                grid->data[i] = old_data[old_i];
-                grid->background_colors[i] = old_background_colors[old_i];
-                grid->foreground_colors[i] = old_foreground_colors[old_i];
-
-                continue;
-            }
-
-            grid->data[i] = ' ';
-            grid->background_colors[i] = GRID_COLOR_BACKGROUND_DEFAULT;
-            grid->foreground_colors[i] = GRID_COLOR_FOREGROUND_DEFAULT;
-        }
     }
-
-    free(old_data);
-    free(old_background_colors);
-    free(old_foreground_colors);
 }
 
 void grid_set_char(struct Grid *grid, int32_t x, int32_t y, uint32_t character) {
@@ -207,7 +260,7 @@ void grid_set_char(struct Grid *grid, int32_t x, int32_t y, uint32_t character)
 
 void grid_set_cursor_style(struct Grid *grid, enum GridCursorStyle cursor_style) {
     grid->cursor_style = cursor_style;
-    grid->on_row_changed(grid->callback_context, grid->cursor_y);
+    grid->on_cursor_changed(grid->callback_context);
 }
 
 void grid_scroll_down(struct Grid *grid) {
@@ -219,12 +272,8 @@ void grid_scroll_down(struct Grid *grid) {
     memmove(grid->data, grid->data + grid->width, preserved_tile_count * sizeof(uint32_t));
     memmove(grid->background_colors, grid->background_colors + grid->width, preserved_tile_count * sizeof(uint32_t));
     memmove(grid->foreground_colors, grid->foreground_colors + grid->width, preserved_tile_count * sizeof(uint32_t));
-
-    // The cursor didn't move with the rows, so the row the cursor used to be on
-    // needs to be updated. The cursor isn't on it anymore.
-    if (grid->cursor_y - 1 > 0) {
-        grid->on_row_changed(grid->callback_context, grid->cursor_y - 1);
-    }
+    memmove(grid->wrapped_rows, grid->wrapped_rows + 1, (grid->height - 1) * sizeof(bool));
+    grid->wrapped_rows[grid->height - 1] = false;
 
     for (size_t i = 0; i < grid->width; i++) {
         grid_set_char(grid, i, grid->height - 1, ' ');
@@ -241,8 +290,6 @@ void grid_cursor_restore(struct Grid *grid) {
 }
 
 void grid_cursor_move_to(struct Grid *grid, int32_t x, int32_t y) {
-    grid->on_row_changed(grid->callback_context, grid->cursor_y);
-
     grid->cursor_x = x;
     grid->cursor_y = y;
 
@@ -258,7 +305,7 @@ void grid_cursor_move_to(struct Grid *grid, int32_t x, int32_t y) {
         grid->cursor_y = grid->height - 1;
     }
 
-    grid->on_row_changed(grid->callback_context, grid->cursor_y);
+    grid->on_cursor_changed(grid->callback_context);
 }
 
 void grid_cursor_move(struct Grid *grid, int32_t delta_x, int32_t delta_y) {
@@ -286,6 +333,7 @@ void grid_update_mode(struct Grid *grid, int mode, bool enabled) {
     switch (mode) {
         case 25: {
             grid->should_show_cursor = enabled;
+            grid->on_cursor_changed(grid->callback_context);
             break;
         }
         case 1000: {
@@ -304,6 +352,53 @@ void grid_update_mode(struct Grid *grid, int mode, bool enabled) {
             grid->should_use_sgr_format = enabled;
             break;
         }
+        case 2004: {
+            grid->has_bracketed_paste = enabled;
+            break;
+        }
+    }
+}
+
+// Used to answer mode queries: 0 means the mode isn't recognized, 1 that it's set and 2 that it's reset.
+static uint32_t grid_get_mode_status(struct Grid *grid, uint32_t mode) {
+    bool is_enabled = false;
+
+    switch (mode) {
+        case 25: {
+            is_enabled = grid->should_show_cursor;
+            break;
+        }
+        case 1000: {
+            is_enabled = grid->has_mouse_mode_button;
+            break;
+        }
+        case 1002: {
+            is_enabled = grid->has_mouse_mode_drag;
+            break;
+        }
+        case 1003: {
+            is_enabled = grid->has_mouse_mode_any;
+            break;
+        }
+        case 1006: {
+            is_enabled = grid->should_use_sgr_format;
+            break;
+        }
+        case 2004: {
+            is_enabled = grid->has_bracketed_paste;
+            break;
+        }
+        default: {
+            return 0;
+        }
+    }
+
+    return is_enabled ? 1 : 2;
+}
+
+static void grid_reply(struct Grid *grid, const char *reply) {
+    for (size_t i = 0; reply[i] != '\0'; i++) {
+        list_push_uint8_t(&grid->replies, reply[i]);
     }
 }
 
@@ -323,6 +418,260 @@ enum GridMouseMode grid_get_mouse_mode(struct Grid *grid) {
     return GRID_MOUSE_MODE_NONE;
 }
 
+static int32_t grid_parse_hex_digit(char character) {
+    if (character >= '0' && character <= '9') {
+        return character - '0';
+    }
+
+    if (character >= 'a' && character <= 'f') {
+        return character - 'a' + 10;
+    }
+
+    if (character >= 'A' && character <= 'F') {
+        return character - 'A' + 10;
+    }
+
+    return -1;
+}
+
+// Parses colors in the X11 formats used by OSC sequences: "rgb:r/g/b" with 1 to 4 hex digits per channel, or "#rgb"
+// with the same number of hex digits for every channel.
+static bool grid_parse_color_spec(const char *spec, size_t length, uint32_t *hex) {
+    uint32_t channels[3] = {0};
+    uint32_t channel_maxes[3] = {0};
+
+    if (length > 4 && memcmp(spec, "rgb:", 4) == 0) {
+        size_t channel_i = 0;
+
+        for (size_t i = 4; i < length; i++) {
+            if (spec[i] == '/') {
+                channel_i++;
+
+                if (channel_i >= 3) {
+                    return false;
+                }
+
+                continue;
+            }
+
+            int32_t digit = grid_parse_hex_digit(spec[i]);
+            if (digit < 0 || channel_maxes[channel_i] > 0xfff) {
+                return false;
+            }
+
+            channels[channel_i] = channels[channel_i] * 16 + digit;
+            channel_maxes[channel_i] = channel_maxes[channel_i] * 16 + 0xf;
+        }
+
+        if (channel_i != 2) {
+            return false;
+        }
+    } else if (length > 1 && spec[0] == '#' && (length - 1) % 3 == 0 && length - 1 <= 12) {
+        size_t digits_per_channel = (length - 1) / 3;
+
+        for (size_t channel_i = 0; channel_i < 3; channel_i++) {
+            for (size_t digit_i = 0; digit_i < digits_per_channel; digit_i++) {
+                int32_t digit = grid_parse_hex_digit(spec[1 + channel_i * digits_per_channel + digit_i]);
+                if (digit < 0) {
+                    return false;
+                }
+
+                channels[channel_i] = channels[channel_i] * 16 + digit;
+                channel_maxes[channel_i] = channel_maxes[channel_i] * 16 + 0xf;
+            }
+        }
+    } else {
+        return false;
+    }
+
+    *hex = 0;
+
+    for (size_t channel_i = 0; channel_i < 3; channel_i++) {
+        if (channel_maxes[channel_i] == 0) {
+            return false;
+        }
+
+        // Scale each channel to 8 bits, eg: "f" becomes 0xff and "ffff" also becomes 0xff.
+        *hex = (*hex << 8) | (channels[channel_i] * 0xff / channel_maxes[channel_i]);
+    }
+
+    return true;
+}
+
+// Answers a color query with the color in the "rgb:rrrr/gggg/bbbb" format, after the same parameters as the query and
+// ending with the same terminator. Channels are scaled from 8 to 16 bits, eg: 0xff becomes 0xffff.
+static void grid_reply_palette_color(
+    struct Grid *grid, const char *parameters, uint32_t palette_i, const char *terminator
+) {
+
+    uint32_t hex = grid->palette[palette_i];
+
+    char reply[64];
+    snprintf(
+        reply,
+        sizeof(reply),
+        "\x1b]%s;rgb:%04" PRIx32 "/%04" PRIx32 "/%04" PRIx32 "%s",
+        parameters,
+        ((hex >> 16) & 0xff) * 0x101,
+        ((hex >> 8) & 0xff) * 0x101,
+        (hex & 0xff) * 0x101,
+        terminator
+    );
+    grid_reply(grid, reply);
+}
+
+static bool grid_is_color_query(const char *spec, size_t length) {
+    return length == 1 && spec[0] == '?';
+}
+
+static void grid_set_palette_color(struct Grid *grid, uint32_t palette_i, const char *spec, size_t length) {
+    uint32_t hex;
+
+    if (!grid_parse_color_spec(spec, length, &hex)) {
+        return;
+    }
+
+    grid->palette[palette_i] = hex;
+
+    // The first 16 entries of the color table are the named colors.
+    if (palette_i < GRID_PALETTE_NAMED_LENGTH) {
+        grid->palette[GRID_PALETTE_NAMED_START + palette_i] = hex;
+    }
+
+    grid->is_palette_dirty = true;
+}
+
+static void grid_reset_table_color(struct Grid *grid, uint32_t palette_i) {
+    grid_reset_palette_color(grid, palette_i);
+
+    if (palette_i < GRID_PALETTE_NAMED_LENGTH) {
+        grid_reset_palette_color(grid, GRID_PALETTE_NAMED_START + palette_i);
+    }
+}
+
+// Gets the next ';' separated parameter of an OSC command, returns false if there are none left.
+static bool grid_next_command_parameter(
+    const char *command, size_t command_length, size_t *i, const char **parameter, size_t *parameter_length
+) {
+
+    if (*i >= command_length) {
+        return false;
+    }
+
+    *parameter = command + *i;
+    *parameter_length = 0;
+
+    while (*i < command_length && command[*i] != ';') {
+        *parameter_length += 1;
+        *i += 1;
+    }
+
+    // Skip the separator.
+    *i += 1;
+
+    return true;
+}
+
+static uint32_t grid_parse_decimal(const char *data, size_t length, bool *is_valid) {
+    uint32_t value = 0;
+    *is_valid = length > 0;
+
+    for (size_t i = 0; i < length; i++) {
+        if (data[i] < '0' || data[i] > '9') {
+            *is_valid = false;
+            return 0;
+        }
+
+        value = value * 10 + data[i] - '0';
+    }
+
+    return value;
+}
+
+// Colors can also be queried with "?" instead of a color, the reply ends with the query's terminator.
+static void grid_run_palette_command(
+    struct Grid *grid, uint32_t command_type, const char *command, size_t length, const char *terminator
+) {
+
+    size_t i = 0;
+    const char *parameter;
+    size_t parameter_length;
+
+    switch (command_type) {
+        // Set palette colors, as pairs of indices and colors.
+        case 4: {
+            const char *index_parameter;
+            size_t index_parameter_length;
+
+            while (grid_next_command_parameter(command, length, &i, &index_parameter, &index_parameter_length) &&
+                   grid_next_command_parameter(command, length, &i, &parameter, &parameter_length)) {
+                bool is_valid;
+                uint32_t palette_i = grid_parse_decimal(index_parameter, index_parameter_length, &is_valid);
+
+                if (!is_valid || palette_i >= GRID_PALETTE_TABLE_LENGTH) {
+                    continue;
+                }
+
+                if (grid_is_color_query(parameter, parameter_length)) {
+                    char parameters[16];
+                    snprintf(parameters, sizeof(parameters), "4;%" PRIu32, palette_i);
+                    grid_reply_palette_color(grid, parameters, palette_i, terminator);
+                } else {
+                    grid_set_palette_color(grid, palette_i, parameter, parameter_length);
+                }
+            }
+
+            break;
+        }
+        // Set the default foreground or background color.
+        case 10:
+        case 11: {
+            uint32_t palette_i = command_type == 10 ? GRID_COLOR_FOREGROUND_DEFAULT : GRID_COLOR_BACKGROUND_DEFAULT;
+
+            if (!grid_next_command_parameter(command, length, &i, &parameter, &parameter_length)) {
+                break;
+            }
+
+            if (grid_is_color_query(parameter, parameter_length)) {
+                grid_reply_palette_color(grid, command_type == 10 ? "10" : "11", palette_i, terminator);
+            } else {
+                grid_set_palette_color(grid, palette_i, parameter, parameter_length);
+            }
+
+            break;
+        }
+        // Reset palette colors, or the whole color table if no indices are given.
+        case 104: {
+            if (length == 0) {
+                for (uint32_t palette_i = 0; palette_i < GRID_PALETTE_TABLE_LENGTH; palette_i++) {
+                    grid_reset_table_color(grid, palette_i);
+                }
+
+                break;
+            }
+
+            while (grid_next_command_parameter(command, length, &i, &parameter, &parameter_length)) {
+                bool is_valid;
+                uint32_t palette_i = grid_parse_decimal(parameter, parameter_length, &is_valid);
+
+                if (is_valid && palette_i < GRID_PALETTE_TABLE_LENGTH) {
+                    grid_reset_table_color(grid, palette_i);
+                }
+            }
+
+            break;
+        }
+        case 110: {
+            grid_reset_palette_color(grid, GRID_COLOR_FOREGROUND_DEFAULT);
+            break;
+        }
+        case 111: {
+            grid_reset_palette_color(grid, GRID_COLOR_BACKGROUND_DEFAULT);
+            break;
+        }
+    }
+}
+
 static bool grid_parse_operating_system_command(
     struct Grid *grid,
     struct TextBuffer *text_buffer,
@@ -332,17 +681,19 @@ static bool grid_parse_operating_system_command(
     size_t *furthest_i
 ) {
 
-    if (*i >= text_buffer->length) {
+    if (!text_buffer_digit(text_buffer, *i)) {
         PARSE_FAILED
     }
 
-    char command_type = text_buffer->data[*i];
-    *i += 1;
-
-    if (!text_buffer_match_char(text_buffer, ';', i)) {
-        PARSE_FAILED
+    uint32_t command_type = 0;
+    while (text_buffer_digit(text_buffer, *i)) {
+        command_type = command_type * 10 + text_buffer->data[*i] - '0';
+        *i += 1;
     }
 
+    // Some commands (ie: resetting the palette) have no parameters, so the separator is optional.
+    text_buffer_match_char(text_buffer, ';', i);
+
     // Commands (ie: window titles) can be at most 255 characters.
     for (size_t command_length = 0; command_length < 255; command_length++) {
         size_t peek_i = *i + command_length;
@@ -355,8 +706,8 @@ static bool grid_parse_operating_system_command(
 
         switch (command_type) {
             // Set window title.
-            case '0':
-            case '2': {
+            case 0:
+            case 2: {
                 if (title_buffer) {
                     memcpy(title_buffer->data, text_buffer->data + *i, command_length);
                     title_buffer->data[command_length] = '\0';
@@ -365,6 +716,11 @@ static bool grid_parse_operating_system_command(
 
                 break;
             }
+            default: {
+                const char *terminator = has_bel ? "\x7" : "\x1b\\";
+                grid_run_palette_command(grid, command_type, text_buffer->data + *i, command_length, terminator);
+                break;
+            }
         }
 
         *i = peek_i;
@@ -374,6 +730,28 @@ static bool grid_parse_operating_system_command(
     PARSE_FAILED
 }
 
+// Matches the "$p" that ends a request mode (DECRQM), only consuming it if both characters are there. A "$" at the
+// end of the buffer is consumed anyway, so that the sequence is seen as incomplete rather than invalid.
+static bool grid_match_request_mode(struct TextBuffer *text_buffer, size_t *i) {
+    size_t peek_i = *i;
+
+    if (!text_buffer_match_char(text_buffer, '$', &peek_i)) {
+        return false;
+    }
+
+    if (peek_i >= text_buffer->length) {
+        *i = peek_i;
+        return false;
+    }
+
+    if (!text_buffer_match_char(text_buffer, 'p', &peek_i)) {
+        return false;
+    }
+
+    *i = peek_i;
+    return true;
+}
+
 // Handles parsing cursor visibility and mouse mode.
 static bool grid_parse_question_mark(
     struct Grid *grid,
@@ -408,9 +786,81 @@ static bool grid_parse_question_mark(
         return true;
     }
 
+    // Request mode (DECRQM), a request without a mode has nothing to answer.
+    if (grid_match_request_mode(text_buffer, i)) {
+        if (parsed_number_count == 0) {
+            return true;
+        }
+
+        char reply[32];
+        snprintf(
+            reply,
+            sizeof(reply),
+            "\x1b[?%" PRIu32 ";%" PRIu32 "$y",
+            parsed_numbers[0],
+            grid_get_mode_status(grid, parsed_numbers[0])
+        );
+        grid_reply(grid, reply);
+
+        return true;
+    }
+
     PARSE_FAILED
 }
 
+// Queries that are answered through the grid's replies.
+static bool grid_parse_query(
+    struct Grid *grid,
+    struct TextBuffer *text_buffer,
+    uint32_t parsed_numbers[16],
+    size_t parsed_number_count,
+    size_t *i
+) {
+
+    // Primary device attributes (DA1).
+    if (text_buffer_match_char(text_buffer, 'c', i)) {
+        grid_reply(grid, GRID_PRIMARY_DEVICE_ATTRIBUTES);
+        return true;
+    }
+
+    if (text_buffer_match_char(text_buffer, 'n', i)) {
+        // Device status report (DSR).
+        if (parsed_numbers[0] == 5) {
+            grid_reply(grid, GRID_STATUS_OK);
+        }
+
+        // Cursor position report (CPR), the cursor can be one past the last column while waiting to wrap.
+        if (parsed_numbers[0] == 6) {
+            char reply[32];
+            snprintf(
+                reply,
+                sizeof(reply),
+                "\x1b[%" PRId32 ";%" PRId32 "R",
+                grid->cursor_y + 1,
+                int32_min(grid->cursor_x, (int32_t)grid->width - 1) + 1
+            );
+            grid_reply(grid, reply);
+        }
+
+        return true;
+    }
+
+    // ANSI modes aren't supported, so every request mode (DECRQM) is answered with "not recognized".
+    if (grid_match_request_mode(text_buffer, i)) {
+        if (parsed_number_count == 0) {
+            return true;
+        }
+
+        char reply[32];
+        snprintf(reply, sizeof(reply), "\x1b[%" PRIu32 ";0$y", parsed_numbers[0]);
+        grid_reply(grid, reply);
+
+        return true;
+    }
+
+    return false;
+}
+
 static bool grid_parse_text_formatting(
     struct Grid *grid,
     struct TextBuffer *text_buffer,
@@ -486,8 +936,7 @@ static bool grid_parse_text_formatting(
                 }
                 case 38: {
                     if (i + 2 < parsed_number_count && parsed_numbers[i + 1] == 5) {
-                        size_t color_table_i = parsed_numbers[i + 2] % 256;
-                        *foreground_color = color_table[color_table_i];
+                        *foreground_color = parsed_numbers[i + 2] % GRID_PALETTE_TABLE_LENGTH;
                         i += 2;
                         break;
                     }
@@ -499,7 +948,7 @@ static bool grid_parse_text_formatting(
                     uint32_t r = parsed_numbers[i + 2];
                     uint32_t g = parsed_numbers[i + 3];
                     uint32_t b = parsed_numbers[i + 4];
-                    *foreground_color = (r << 16) | (g << 8) | b;
+                    *foreground_color = GRID_COLOR_TRUECOLOR | ((r & 0xff) << 16) | ((g & 0xff) << 8) | (b & 0xff);
                     i += 4;
                     break;
                 }
@@ -541,8 +990,7 @@ static bool grid_parse_text_formatting(
                 }
                 case 48: {
                     if (i + 2 < parsed_number_count && parsed_numbers[i + 1] == 5) {
-                        size_t color_table_i = parsed_numbers[i + 2] % 256;
-                        *background_color = color_table[color_table_i];
+                        *background_color = parsed_numbers[i + 2] % GRID_PALETTE_TABLE_LENGTH;
                         i += 2;
                         break;
                     }
@@ -554,7 +1002,7 @@ static bool grid_parse_text_formatting(
                     uint32_t r = parsed_numbers[i + 2];
                     uint32_t g = parsed_numbers[i + 3];
                     uint32_t b = parsed_numbers[i + 4];
-                    *background_color = (r << 16) | (g << 8) | b;
+                    *background_color = GRID_COLOR_TRUECOLOR | ((r & 0xff) << 16) | ((g & 0xff) << 8) | (b & 0xff);
                     i += 4;
                     break;
                 }
@@ -747,6 +1195,13 @@ static bool grid_parse_cursor_positioning(
     return false;
 }
 
+// Erasing up to the end of a row means its text no longer continues onto the next row.
+static void grid_clear_wrapped_rows(struct Grid *grid, size_t start_y, size_t end_y) {
+    for (size_t y = start_y; y < end_y && y < grid->height; y++) {
+        grid->wrapped_rows[y] = false;
+    }
+}
+
 static bool grid_parse_text_modification(
     struct Grid *grid,
     struct TextBuffer *text_buffer,
@@ -782,6 +1237,8 @@ static bool grid_parse_text_modification(
                     grid_set_char_i(grid, erase_i, ' ');
                 }
 
+                grid_clear_wrapped_rows(grid, grid->cursor_y, grid->height);
+
                 return true;
             }
             // Erase line after cursor.
@@ -790,6 +1247,8 @@ static bool grid_parse_text_modification(
                     grid_set_char(grid, x, grid->cursor_y, ' ');
                 }
 
+                grid_clear_wrapped_rows(grid, grid->cursor_y, grid->cursor_y + 1);
+
                 return true;
             }
 
@@ -804,6 +1263,8 @@ static bool grid_parse_text_modification(
                     grid_set_char_i(grid, erase_i, ' ');
                 }
 
+                grid_clear_wrapped_rows(grid, 0, grid->cursor_y);
+
                 return true;
             }
             // Erase line before cursor.
@@ -826,6 +1287,8 @@ static bool grid_parse_text_modification(
                     }
                 }
 
+                grid_clear_wrapped_rows(grid, 0, grid->height);
+
                 return true;
             }
             // Erase entire line.
@@ -834,6 +1297,8 @@ static bool grid_parse_text_modification(
                     grid_set_char(grid, x, grid->cursor_y, ' ');
                 }
 
+                grid_clear_wrapped_rows(grid, grid->cursor_y, grid->cursor_y + 1);
+
                 return true;
             }
 
@@ -881,7 +1346,7 @@ bool grid_parse_escape_sequence(
         PARSE_FAILED
     }
 
-    bool is_unsupported = text_buffer_match_char(text_buffer, '>', i);
+    bool starts_with_greater_than = text_buffer_match_char(text_buffer, '>', i);
     bool starts_with_question_mark = text_buffer_match_char(text_buffer, '?', i);
 
     // The maximum amount of numbers supported is 16, for the "m" commands (text formatting).
@@ -908,8 +1373,19 @@ bool grid_parse_escape_sequence(
         }
     }
 
-    // Formats like ESC[>[numbers][character] are not supported.
-    if (is_unsupported) {
+    if (starts_with_greater_than) {
+        // Secondary device attributes (DA2).
+        if (text_buffer_match_char(text_buffer, 'c', i)) {
+            grid_reply(grid, GRID_SECONDARY_DEVICE_ATTRIBUTES);
+            return true;
+        }
+
+        // The final character may not have been read yet.
+        if (*i >= text_buffer->length) {
+            PARSE_FAILED
+        }
+
+        // Other formats like ESC[>[numbers][character] are not supported.
         *i += 1;
         return true;
     }
@@ -942,12 +1418,195 @@ bool grid_parse_escape_sequence(
         return true;
     }
 
+    if (grid_parse_query(grid, text_buffer, parsed_numbers, parsed_number_count, i)) {
+        return true;
+    }
+
     // This sequence is invalid, ignore it.
     PARSE_FAILED
 }
 
+uint32_t grid_color_to_hex(struct Grid *grid, uint32_t color) {
+    if (color & GRID_COLOR_TRUECOLOR) {
+        return color & 0xffffff;
+    }
+
+    return grid->palette[color];
+}
+
+// Trailing blanks are only part of the text when the line wraps onto the next one.
+static size_t grid_text_line_trim(const uint32_t *cells, size_t length) {
+    while (length > 0 && cells[length - 1] == ' ') {
+        length--;
+    }
+
+    return length;
+}
+
+struct GridTextSnapshot grid_text_snapshot_create(struct Grid *grid, struct Selection *sorted_selection) {
+    int32_t start_y = int32_max(sorted_selection->start_y, 0);
+    int32_t end_y = int32_min(sorted_selection->end_y, (int32_t)(grid->scrollback_lines.length + grid->height) - 1);
+    size_t line_count = end_y >= start_y ? end_y - start_y + 1 : 0;
+
+    // Only the rows of the grid that are part of the selection are copied.
+    int32_t grid_start_y = int32_max(start_y - (int32_t)grid->scrollback_lines.length, 0);
+    int32_t grid_end_y = end_y - (int32_t)grid->scrollback_lines.length;
+    size_t grid_cell_count = grid_end_y >= grid_start_y ? (grid_end_y - grid_start_y + 1) * grid->width : 0;
+
+    struct GridTextSnapshot snapshot = {
+        .lines = line_count > 0 ? malloc(line_count * sizeof(struct GridTextLine)) : NULL,
+        .line_count = line_count,
+        .grid_cells = grid_cell_count > 0 ? malloc(grid_cell_count * sizeof(uint32_t)) : NULL,
+    };
+    assert(snapshot.lines || line_count == 0);
+    assert(snapshot.grid_cells || grid_cell_count == 0);
+
+    if (grid_cell_count > 0) {
+        memcpy(snapshot.grid_cells, grid->data + grid_start_y * grid->width, grid_cell_count * sizeof(uint32_t));
+    }
+
+    for (size_t i = 0; i < line_count; i++) {
+        int32_t y = start_y + (int32_t)i;
+        int32_t grid_y = y - (int32_t)grid->scrollback_lines.length;
+        struct GridTextLine line = {0};
+
+        if (grid_y < 0) {
+            struct ScrollbackLine *scrollback_line = &grid->scrollback_lines.data[y];
+
+            line = (struct GridTextLine){
+                .cells = scrollback_line->data,
+                .length = scrollback_line->length,
+                .is_wrapped = scrollback_line->is_wrapped,
+            };
+        } else {
+            line = (struct GridTextLine){
+                .cells = snapshot.grid_cells + (grid_y - grid_start_y) * grid->width,
+                .length = grid->width,
+                .is_wrapped = grid->wrapped_rows[grid_y],
+            };
+        }
+
+        // The selection's end is inclusive.
+        if (y == sorted_selection->end_y) {
+            line.length = int32_min((int32_t)line.length, sorted_selection->end_x + 1);
+            line.is_wrapped = false;
+        }
+
+        if (y == sorted_selection->start_y) {
+            size_t start_x = int32_min(sorted_selection->start_x, (int32_t)line.length);
+
+            line.cells += start_x;
+            line.length -= start_x;
+        }
+
+        if (!line.is_wrapped) {
+            line.length = grid_text_line_trim(line.cells, line.length);
+        }
+
+        snapshot.lines[i] = line;
+        snapshot.cell_count += line.length;
+    }
+
+    return snapshot;
+}
+
+// Cells can hold values that aren't valid codepoints if the output they were parsed from wasn't valid UTF-8, they're
+// replaced so that the text stays valid.
+static uint32_t grid_get_text_codepoint(uint32_t character) {
+    if (character == 0) {
+        return ' ';
+    }
+
+    if (character > 0x10ffff || (character >= 0xd800 && character <= 0xdfff)) {
+        return 0xfffd;
+    }
+
+    return character;
+}
+
+static size_t grid_get_utf8_length(uint32_t codepoint) {
+    if (codepoint < 0x80) {
+        return 1;
+    }
+
+    if (codepoint < 0x800) {
+        return 2;
+    }
+
+    if (codepoint < 0x10000) {
+        return 3;
+    }
+
+    return 4;
+}
+
+char *grid_text_snapshot_to_utf8(struct GridTextSnapshot *snapshot, size_t *length) {
+    // The text is measured first so that it only needs to be allocated once.
+    size_t text_length = 0;
+
+    for (size_t i = 0; i < snapshot->line_count; i++) {
+        struct GridTextLine *line = &snapshot->lines[i];
+
+        for (size_t x = 0; x < line->length; x++) {
+            text_length += grid_get_utf8_length(grid_get_text_codepoint(line->cells[x]));
+        }
+
+        if (!line->is_wrapped && i + 1 < snapshot->line_count) {
+            text_length++;
+        }
+    }
+
+    char *text = malloc(text_length + 1);
+    assert(text);
+
+    size_t text_i = 0;
+
+    for (size_t i = 0; i < snapshot->line_count; i++) {
+        struct GridTextLine *line = &snapshot->lines[i];
+
+        for (size_t x = 0; x < line->length; x++) {
+            uint32_t codepoint = grid_get_text_codepoint(line->cells[x]);
+
+            if (codepoint < 0x80) {
+                text[text_i++] = (char)codepoint;
+            } else if (codepoint < 0x800) {
+                text[text_i++] = (char)(0xc0 | (codepoint >> 6));
+                text[text_i++] = (char)(0x80 | (codepoint & 0x3f));
+            } else if (codepoint < 0x10000) {
+                text[text_i++] = (char)(0xe0 | (codepoint >> 12));
+                text[text_i++] = (char)(0x80 | ((codepoint >> 6) & 0x3f));
+                text[text_i++] = (char)(0x80 | (codepoint & 0x3f));
+            } else {
+                text[text_i++] = (char)(0xf0 | (codepoint >> 18));
+                text[text_i++] = (char)(0x80 | ((codepoint >> 12) & 0x3f));
+                text[text_i++] = (char)(0x80 | ((codepoint >> 6) & 0x3f));
+                text[text_i++] = (char)(0x80 | (codepoint & 0x3f));
+            }
+        }
+
+        if (!line->is_wrapped && i + 1 < snapshot->line_count) {
+            text[text_i++] = '\n';
+        }
+    }
+
+    text[text_i] = '\0';
+
+    if (length) {
+        *length = text_length;
+    }
+
+    return text;
+}
+
+void grid_text_snapshot_destroy(struct GridTextSnapshot *snapshot) {
+    free(snapshot->lines);
+    free(snapshot->grid_cells);
+}
+
 void grid_destroy(struct Grid *grid) {
     free(grid->data);
+    free(grid->wrapped_rows);
+    list_destroy_uint8_t(&grid->replies);
 
     for (size_t i = 0; i < grid->scrollback_lines.length; i++) {
         free(grid->scrollback_lines.data[i].data);
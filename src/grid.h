@@ -9,26 +9,42 @@
 #include <stdbool.h>
 #include <inttypes.h>
 
-#define GRID_COLOR_BACKGROUND_DEFAULT 0x0c0c0c
-#define GRID_COLOR_FOREGROUND_DEFAULT 0xcccccc
-
-#define GRID_COLOR_BLACK 0x0c0c0c
-#define GRID_COLOR_RED 0xc50f1f
-#define GRID_COLOR_GREEN 0x13a10e
-#define GRID_COLOR_YELLOW 0xc19c00
-#define GRID_COLOR_BLUE 0x0037da
-#define GRID_COLOR_MAGENTA 0x881798
-#define GRID_COLOR_CYAN 0x3a96dd
-#define GRID_COLOR_WHITE 0xcccccc
-
-#define GRID_COLOR_BRIGHT_BLACK 0x767676
-#define GRID_COLOR_BRIGHT_RED 0xe74856
-#define GRID_COLOR_BRIGHT_GREEN 0x16c60c
-#define GRID_COLOR_BRIGHT_YELLOW 0xf9f1a5
-#define GRID_COLOR_BRIGHT_BLUE 0x3b78ff
-#define GRID_COLOR_BRIGHT_MAGENTA 0xb4009e
-#define GRID_COLOR_BRIGHT_CYAN 0x61d6d6
-#define GRID_COLOR_BRIGHT_WHITE 0xf2f2f2
+// Cells store colors as indices into the grid's palette, or as 24-bit colors tagged with GRID_COLOR_TRUECOLOR.
+// The renderer resolves palette indices on the GPU, so changing the palette doesn't require rebuilding any rows.
+#define GRID_COLOR_TRUECOLOR 0x1000000
+
+// The first 256 palette entries are the 256 color table, followed by the 16 named colors and the defaults.
+#define GRID_PALETTE_TABLE_LENGTH 256
+#define GRID_PALETTE_NAMED_START 256
+#define GRID_PALETTE_NAMED_LENGTH 16
+
+#define GRID_COLOR_BLACK (GRID_PALETTE_NAMED_START + 0)
+#define GRID_COLOR_RED (GRID_PALETTE_NAMED_START + 1)
+#define GRID_COLOR_GREEN (GRID_PALETTE_NAMED_START + 2)
+#define GRID_COLOR_YELLOW (GRID_PALETTE_NAMED_START + 3)
+#define GRID_COLOR_BLUE (GRID_PALETTE_NAMED_START + 4)
+#define GRID_COLOR_MAGENTA (GRID_PALETTE_NAMED_START + 5)
+#define GRID_COLOR_CYAN (GRID_PALETTE_NAMED_START + 6)
+#define GRID_COLOR_WHITE (GRID_PALETTE_NAMED_START + 7)
+
+#define GRID_COLOR_BRIGHT_BLACK (GRID_PALETTE_NAMED_START + 8)
+#define GRID_COLOR_BRIGHT_RED (GRID_PALETTE_NAMED_START + 9)
+#define GRID_COLOR_BRIGHT_GREEN (GRID_PALETTE_NAMED_START + 10)
+#define GRID_COLOR_BRIGHT_YELLOW (GRID_PALETTE_NAMED_START + 11)
+#define GRID_COLOR_BRIGHT_BLUE (GRID_PALETTE_NAMED_START + 12)
+#define GRID_COLOR_BRIGHT_MAGENTA (GRID_PALETTE_NAMED_START + 13)
+#define GRID_COLOR_BRIGHT_CYAN (GRID_PALETTE_NAMED_START + 14)
+#define GRID_COLOR_BRIGHT_WHITE (GRID_PALETTE_NAMED_START + 15)
+
+#define GRID_COLOR_FOREGROUND_DEFAULT 272
+#define GRID_COLOR_BACKGROUND_DEFAULT 273
+
+#define GRID_PALETTE_LENGTH 274
+
+// Answers to device attribute queries, identifying as a VT220 with ANSI colors the way most terminals do.
+#define GRID_PRIMARY_DEVICE_ATTRIBUTES "\x1b[?62;22c"
+#define GRID_SECONDARY_DEVICE_ATTRIBUTES "\x1b[>1;10;0c"
+#define GRID_STATUS_OK "\x1b[0n"
 
 struct TitleBuffer {
     char data[256];
@@ -53,6 +69,8 @@ struct ScrollbackLine {
     uint32_t *background_colors;
     uint32_t *foreground_colors;
     size_t length;
+    // The line was wrapped onto the next one instead of ending with a newline.
+    bool is_wrapped;
 };
 
 typedef struct ScrollbackLine struct_ScrollbackLine;
@@ -63,8 +81,15 @@ struct Grid {
     size_t width;
     size_t height;
     size_t size;
+    // How many cells the arrays have room for, resizing only reallocates them if the grid grows past it.
+    size_t capacity;
+
+    // Rows that were wrapped onto the next row instead of ending with a newline, copying joins them back together.
+    bool *wrapped_rows;
 
     struct List_struct_ScrollbackLine scrollback_lines;
+    // Memory used by the scrollback lines' cells.
+    size_t scrollback_byte_count;
 
     int32_t cursor_x;
     int32_t cursor_y;
@@ -77,6 +102,8 @@ struct Grid {
     bool has_mouse_mode_button;
     bool has_mouse_mode_drag;
     bool has_mouse_mode_any;
+    // Pastes are wrapped in escape sequences so the application can tell them apart from typing.
+    bool has_bracketed_paste;
 
     enum GridCursorStyle cursor_style;
 
@@ -88,12 +115,42 @@ struct Grid {
 
     bool are_colors_swapped;
 
+    // Hex colors for each palette index, eg: 0xff0000 is red.
+    uint32_t palette[GRID_PALETTE_LENGTH];
+    bool is_palette_dirty;
+
+    // Replies to queries from the application, like the cursor position. The main loop writes them to the pty.
+    struct List_uint8_t replies;
+
     void *callback_context;
     void (*on_row_changed)(void *context, int32_t y);
+    // Called when the cursor moves or changes how it looks, without any row's contents changing.
+    void (*on_cursor_changed)(void *context);
 };
 
 struct Grid grid_create(
-    size_t width, size_t height, void *callback_context, void (*on_row_changed)(void *context, int32_t y));
+    size_t width,
+    size_t height,
+    void *callback_context,
+    void (*on_row_changed)(void *context, int32_t y),
+    void (*on_cursor_changed)(void *context)
+);
+struct GridTextLine {
+    const uint32_t *cells;
+    size_t length;
+    bool is_wrapped;
+};
+
+// The cells of a selection, trimmed of trailing blanks. It's taken while holding the reader's lock and can be turned
+// into text on any thread afterwards: scrollback lines never change after they're pushed so they're referenced, rows
+// from the grid are copied.
+struct GridTextSnapshot {
+    struct GridTextLine *lines;
+    size_t line_count;
+    size_t cell_count;
+    uint32_t *grid_cells;
+};
+
 void grid_resize(struct Grid *grid, size_t width, size_t height);
 void grid_set_char(struct Grid *grid, int32_t x, int32_t y, uint32_t character);
 void grid_set_cursor_style(struct Grid *grid, enum GridCursorStyle cursor_style);
@@ -103,6 +160,12 @@ void grid_cursor_move(struct Grid *grid, int32_t delta_x, int32_t delta_y);
 enum GridMouseMode grid_get_mouse_mode(struct Grid *grid);
 bool grid_parse_escape_sequence(
     struct Grid *grid, struct TextBuffer *text_buffer, struct TitleBuffer *title_buffer, size_t *i, size_t *furthest_i);
+uint32_t grid_color_to_hex(struct Grid *grid, uint32_t color);
+// Selections use absolute lines, which start with the scrollback and continue into the grid.
+struct GridTextSnapshot grid_text_snapshot_create(struct Grid *grid, struct Selection *sorted_selection);
+// Encodes the snapshot as null terminated UTF-8. Wrapped lines are joined without a newline, the text has to be freed.
+char *grid_text_snapshot_to_utf8(struct GridTextSnapshot *snapshot, size_t *length);
+void grid_text_snapshot_destroy(struct GridTextSnapshot *snapshot);
 void grid_destroy(struct Grid *grid);
 
 inline void grid_set_char_i(struct Grid *grid, int32_t i, uint32_t character) {
@@ -0,0 +1,223 @@
+#include "latency.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+static const char *latency_stage_names[LATENCY_STAGE_COUNT] = {
+    "input to write",
+    "write to echo",
+    "echo to present",
+};
+
+struct LatencyTracker latency_tracker_create(void) {
+    struct LatencyShared *shared = malloc(sizeof(struct LatencyShared));
+    assert(shared);
+
+    *shared = (struct LatencyShared){0};
+    mutex_init(&shared->mutex);
+
+    return (struct LatencyTracker){
+        .shared = shared,
+    };
+}
+
+static void latency_histogram_add(struct LatencyHistogram *histogram, double time) {
+    uint64_t microseconds = time > 0.0 ? (uint64_t)(time * 1000000.0) : 0;
+    size_t bucket_i = 0;
+
+    while (microseconds > 1 && bucket_i < LATENCY_HISTOGRAM_BUCKET_COUNT - 1) {
+        microseconds >>= 1;
+        bucket_i++;
+    }
+
+    histogram->buckets[bucket_i]++;
+    histogram->sample_count++;
+    histogram->total_time += time;
+
+    if (time > histogram->max_time) {
+        histogram->max_time = time;
+    }
+}
+
+// The upper end of the bucket that contains the percentile, in seconds.
+static double latency_histogram_get_percentile(struct LatencyHistogram *histogram, double percentile) {
+    uint32_t target_count = (uint32_t)(percentile * histogram->sample_count + 0.5);
+    uint32_t count = 0;
+
+    for (size_t i = 0; i < LATENCY_HISTOGRAM_BUCKET_COUNT; i++) {
+        count += histogram->buckets[i];
+
+        if (count >= target_count && count > 0) {
+            return (double)((uint64_t)1 << (i + 1)) / 1000000.0;
+        }
+    }
+
+    return histogram->max_time;
+}
+
+void latency_tracker_on_input(struct LatencyTracker *latency_tracker, double time) {
+    struct LatencyShared *shared = latency_tracker->shared;
+
+    mutex_lock(&shared->mutex);
+
+    if (shared->state == LATENCY_STATE_IDLE) {
+        shared->state = LATENCY_STATE_INPUT;
+        shared->input_time = time;
+    }
+
+    mutex_unlock(&shared->mutex);
+}
+
+// Called before the input is written, so that a read that finishes before the write call returns still counts.
+void latency_tracker_on_write(struct LatencyTracker *latency_tracker, double time) {
+    struct LatencyShared *shared = latency_tracker->shared;
+
+    mutex_lock(&shared->mutex);
+
+    if (shared->state == LATENCY_STATE_INPUT) {
+        shared->state = LATENCY_STATE_WRITTEN;
+        shared->write_time = time;
+    }
+
+    mutex_unlock(&shared->mutex);
+}
+
+// Called once the read's output has been parsed into the grid, so that every frame presented afterwards shows it.
+// The time is when the read finished.
+void latency_tracker_on_read(struct LatencyTracker *latency_tracker, double time) {
+    struct LatencyShared *shared = latency_tracker->shared;
+
+    mutex_lock(&shared->mutex);
+
+    if (shared->state == LATENCY_STATE_WRITTEN && time >= shared->write_time) {
+        shared->state = LATENCY_STATE_ECHOED;
+        shared->echo_time = time;
+    }
+
+    mutex_unlock(&shared->mutex);
+}
+
+void latency_tracker_on_present(struct LatencyTracker *latency_tracker, double time) {
+    struct LatencyShared *shared = latency_tracker->shared;
+
+    mutex_lock(&shared->mutex);
+
+    if (shared->state == LATENCY_STATE_ECHOED) {
+        latency_histogram_add(
+            &shared->histograms[LATENCY_STAGE_INPUT_TO_WRITE],
+            shared->write_time - shared->input_time
+        );
+        latency_histogram_add(&shared->histograms[LATENCY_STAGE_WRITE_TO_ECHO], shared->echo_time - shared->write_time);
+        latency_histogram_add(&shared->histograms[LATENCY_STAGE_ECHO_TO_PRESENT], time - shared->echo_time);
+        shared->total_times[shared->total_histogram.sample_count % LATENCY_SAMPLE_CAPACITY] =
+            (float)(time - shared->input_time);
+        latency_histogram_add(&shared->total_histogram, time - shared->input_time);
+
+        shared->state = LATENCY_STATE_IDLE;
+    }
+
+    mutex_unlock(&shared->mutex);
+}
+
+bool latency_tracker_is_idle(struct LatencyTracker *latency_tracker) {
+    struct LatencyShared *shared = latency_tracker->shared;
+
+    mutex_lock(&shared->mutex);
+    bool is_idle = shared->state == LATENCY_STATE_IDLE;
+    mutex_unlock(&shared->mutex);
+
+    return is_idle;
+}
+
+uint32_t latency_tracker_get_sample_count(struct LatencyTracker *latency_tracker) {
+    struct LatencyShared *shared = latency_tracker->shared;
+
+    mutex_lock(&shared->mutex);
+    uint32_t sample_count = shared->total_histogram.sample_count;
+    mutex_unlock(&shared->mutex);
+
+    return sample_count;
+}
+
+static int32_t latency_compare_times(const void *a, const void *b) {
+    float time_a = *(const float *)a;
+    float time_b = *(const float *)b;
+
+    return (time_a > time_b) - (time_a < time_b);
+}
+
+// Nearest rank percentile of the latest samples of the whole pipeline, in seconds.
+static double latency_tracker_get_total_percentile(struct LatencyShared *shared, double percentile) {
+    size_t time_count = shared->total_histogram.sample_count;
+    if (time_count > LATENCY_SAMPLE_CAPACITY) {
+        time_count = LATENCY_SAMPLE_CAPACITY;
+    }
+
+    if (time_count == 0) {
+        return 0.0;
+    }
+
+    float *times = malloc(time_count * sizeof(float));
+    assert(times);
+
+    memcpy(times, shared->total_times, time_count * sizeof(float));
+    qsort(times, time_count, sizeof(float), latency_compare_times);
+
+    double time = times[(size_t)(percentile * (time_count - 1) + 0.5)];
+    free(times);
+
+    return time;
+}
+
+static void latency_histogram_print(struct LatencyHistogram *histogram, const char *name) {
+    if (histogram->sample_count == 0) {
+        printf("latency: %s: no samples\n", name);
+        return;
+    }
+
+    printf(
+        "latency: %s: mean %.3f ms, p50 < %.3f ms, p99 < %.3f ms, max %.3f ms\n",
+        name,
+        histogram->total_time * 1000.0 / histogram->sample_count,
+        latency_histogram_get_percentile(histogram, 0.5) * 1000.0,
+        latency_histogram_get_percentile(histogram, 0.99) * 1000.0,
+        histogram->max_time * 1000.0
+    );
+
+    for (size_t i = 0; i < LATENCY_HISTOGRAM_BUCKET_COUNT; i++) {
+        if (histogram->buckets[i] == 0) {
+            continue;
+        }
+
+        printf(
+            "latency:   < %10.3f ms: %" PRIu32 "\n",
+            (double)((uint64_t)1 << (i + 1)) / 1000.0,
+            histogram->buckets[i]
+        );
+    }
+}
+
+double latency_tracker_print_report(struct LatencyTracker *latency_tracker) {
+    struct LatencyShared *shared = latency_tracker->shared;
+
+    mutex_lock(&shared->mutex);
+
+    for (size_t i = 0; i < LATENCY_STAGE_COUNT; i++) {
+        latency_histogram_print(&shared->histograms[i], latency_stage_names[i]);
+    }
+
+    latency_histogram_print(&shared->total_histogram, "input to present");
+    double total_p99 = latency_tracker_get_total_percentile(shared, 0.99);
+    printf("latency: input to present: p99 %.3f ms\n", total_p99 * 1000.0);
+
+    mutex_unlock(&shared->mutex);
+
+    return total_p99;
+}
+
+void latency_tracker_destroy(struct LatencyTracker *latency_tracker) {
+    mutex_destroy(&latency_tracker->shared->mutex);
+    free(latency_tracker->shared);
+}
\ No newline at end of file
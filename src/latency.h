@@ -0,0 +1,78 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include "detect_leak.h"
+
+#include "thread.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <inttypes.h>
+
+// Bucket i holds latencies from 2^i to 2^(i + 1) microseconds, the last bucket also holds everything longer.
+#define LATENCY_HISTOGRAM_BUCKET_COUNT 21
+// The buckets are too coarse to check a limit against, so the latest samples of the whole pipeline are also kept as
+// they are. Samples past this many overwrite the oldest ones.
+#define LATENCY_SAMPLE_CAPACITY 4096
+
+enum LatencyStage {
+    // From the input event until its bytes are written to the pty.
+    LATENCY_STAGE_INPUT_TO_WRITE,
+    // From the write until the first read from the pty after it, usually the shell echoing the input.
+    LATENCY_STAGE_WRITE_TO_ECHO,
+    // From that read until the first frame that includes it is presented.
+    LATENCY_STAGE_ECHO_TO_PRESENT,
+    LATENCY_STAGE_COUNT,
+};
+
+enum LatencyState {
+    LATENCY_STATE_IDLE,
+    LATENCY_STATE_INPUT,
+    LATENCY_STATE_WRITTEN,
+    LATENCY_STATE_ECHOED,
+};
+
+struct LatencyHistogram {
+    uint32_t buckets[LATENCY_HISTOGRAM_BUCKET_COUNT];
+    uint32_t sample_count;
+    double total_time;
+    double max_time;
+};
+
+// State shared between the main thread and the reader, allocated separately so that it doesn't move when the tracker
+// is copied.
+struct LatencyShared {
+    struct Mutex mutex;
+
+    enum LatencyState state;
+    double input_time;
+    double write_time;
+    double echo_time;
+
+    struct LatencyHistogram histograms[LATENCY_STAGE_COUNT];
+    // Histogram of the whole pipeline, from input to present.
+    struct LatencyHistogram total_histogram;
+    float total_times[LATENCY_SAMPLE_CAPACITY];
+};
+
+// Follows one input event at a time through the pipeline: input, write to the pty, echo from the pty, and the first
+// presented frame after the echo. Input that arrives while an event is still being followed isn't measured, so that
+// every stage can be matched to the event without tagging bytes.
+struct LatencyTracker {
+    struct LatencyShared *shared;
+};
+
+struct LatencyTracker latency_tracker_create(void);
+void latency_tracker_on_input(struct LatencyTracker *latency_tracker, double time);
+void latency_tracker_on_write(struct LatencyTracker *latency_tracker, double time);
+void latency_tracker_on_read(struct LatencyTracker *latency_tracker, double time);
+void latency_tracker_on_present(struct LatencyTracker *latency_tracker, double time);
+// True once the last measured event has been presented, so a new one can be measured.
+bool latency_tracker_is_idle(struct LatencyTracker *latency_tracker);
+uint32_t latency_tracker_get_sample_count(struct LatencyTracker *latency_tracker);
+// Prints a histogram for each stage, returns the 99th percentile of the whole pipeline in seconds. The percentile is
+// taken from the latest samples rather than the histogram's buckets, so it's exact.
+double latency_tracker_print_report(struct LatencyTracker *latency_tracker);
+void latency_tracker_destroy(struct LatencyTracker *latency_tracker);
+
+#endif
\ No newline at end of file
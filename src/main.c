@@ -7,36 +7,251 @@
 #include "text_buffer.h"
 #include "font.h"
 #include "reader.h"
+#include "clock.h"
+#include "stats.h"
+#include "trace.h"
+#include "latency.h"
+#include "pty_writer.h"
 #include "graphics/renderer.h"
 
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image/stb_image.h>
-
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <wchar.h>
 #include <stdbool.h>
 #include <inttypes.h>
 
-int main(void) {
-    struct Window window = window_create("Term", 640, 480);
+// Resizing the grid makes the shell redraw, so it waits until the window stops changing size. Until then the old grid
+// is drawn clipped to the new window size.
+#define RESIZE_DEBOUNCE_TIME 0.1
+
+#define WINDOW_TITLE "Term"
+#define WINDOW_WIDTH 640
+#define WINDOW_HEIGHT 480
+#define WINDOW_TITLE_CAPACITY 300
+
+// How often the window title is updated with the progress of a paste.
+#define PASTE_PROGRESS_UPDATE_TIME 0.1
+
+// How often stats are summarized for the HUD.
+#define STATS_SAMPLE_TIME 1.0
+#define STATS_HUD_TEXT_CAPACITY 1024
+
+// The latency self-test types a key whenever the last one has been presented, at most this often.
+#define LATENCY_SELF_TEST_INTERVAL 0.01
+#define LATENCY_SELF_TEST_SAMPLE_COUNT 500
+// Fails if it takes longer than this to collect every sample.
+#define LATENCY_SELF_TEST_TIMEOUT 30.0
+// Fails if the 99th percentile from input to present is over this many milliseconds, unless another limit is given.
+#define LATENCY_SELF_TEST_DEFAULT_MAX_P99 50.0
+#define LATENCY_SELF_TEST_COMMAND_CAPACITY (MAX_PATH + 32)
+
+struct StartupTiming {
+    double start_time;
+    double pseudo_console_time;
+    double window_time;
+    double renderer_time;
+    double attach_time;
+    double first_frame_time;
+    double prompt_visible_time;
+};
+
+static void print_startup_timing(struct StartupTiming *startup_timing) {
+    printf(
+        "startup: pseudo console %f ms, window %f ms, renderer %f ms, startup output %f ms, first frame %f ms\n",
+        (startup_timing->pseudo_console_time - startup_timing->start_time) * 1000.0,
+        (startup_timing->window_time - startup_timing->pseudo_console_time) * 1000.0,
+        (startup_timing->renderer_time - startup_timing->window_time) * 1000.0,
+        (startup_timing->attach_time - startup_timing->renderer_time) * 1000.0,
+        (startup_timing->first_frame_time - startup_timing->attach_time) * 1000.0
+    );
+    printf(
+        "startup: prompt visible after %f ms\n",
+        (startup_timing->prompt_visible_time - startup_timing->start_time) * 1000.0
+    );
+}
 
-    const int32_t grid_width = window.width / FONT_GLYPH_WIDTH;
-    const int32_t grid_height = window.height / FONT_GLYPH_HEIGHT;
+// Converts a time until something is due into a timeout for waiting on events.
+static DWORD get_timeout(double remaining_time) {
+    return remaining_time > 0.0 ? (DWORD)(remaining_time * 1000.0) + 1 : 0;
+}
 
-    struct PseudoConsole pseudo_console = pseudo_console_create((COORD){grid_width, grid_height});
-    struct Renderer renderer = renderer_create(grid_width, grid_height);
-    struct Grid grid = grid_create(grid_width, grid_height, &renderer, renderer_on_row_changed_callback);
+// Writes its input straight back out. The latency self-test runs it as the child, so that what it measures doesn't
+// depend on how quickly a shell echoes.
+static int32_t run_echo_child(void) {
+    HANDLE input = GetStdHandle(STD_INPUT_HANDLE);
+    HANDLE output = GetStdHandle(STD_OUTPUT_HANDLE);
 
-    window_setup(&window, &grid, &renderer);
+    // Without line input or the console's own echo, every key is read as soon as it's typed.
+    SetConsoleMode(input, ENABLE_VIRTUAL_TERMINAL_INPUT);
+
+    // The terminal waits for this before it starts typing.
+    const char ready_message[] = "echo child ready\r\n";
+    DWORD written_length = 0;
+    WriteFile(output, ready_message, sizeof(ready_message) - 1, &written_length, NULL);
+
+    uint8_t buffer[256];
+    DWORD read_length = 0;
+
+    while (ReadFile(input, buffer, sizeof(buffer), &read_length, NULL) && read_length > 0) {
+        WriteFile(output, buffer, read_length, &written_length, NULL);
+    }
+
+    return 0;
+}
+
+// Runs this executable again as the echo child.
+static void get_echo_child_command(wchar_t *command, size_t command_capacity) {
+    wchar_t executable_path[MAX_PATH];
+    GetModuleFileNameW(NULL, executable_path, MAX_PATH);
+
+    swprintf(command, command_capacity, L"\"%ls\" --echo-child", executable_path);
+}
+
+static void update_stats_hud(struct Renderer *renderer, struct StatsReport *stats_report, bool is_visible) {
+    char text[STATS_HUD_TEXT_CAPACITY] = "";
+
+    if (is_visible) {
+        stats_report_format(stats_report, text, STATS_HUD_TEXT_CAPACITY);
+    }
+
+    renderer_set_hud_text(renderer, text);
+}
+
+// Shows the progress of the paste after the title while one is being written, a negative percentage means there isn't
+// one.
+static void update_title(struct Window *window, char *title, int32_t paste_percent) {
+    if (title[0] == '\0') {
+        title = WINDOW_TITLE;
+    }
+
+    if (paste_percent < 0) {
+        window_set_title(window, title);
+        return;
+    }
+
+    char text[WINDOW_TITLE_CAPACITY];
+    snprintf(text, WINDOW_TITLE_CAPACITY, "%s (pasting %" PRId32 "%%)", title, paste_percent);
+
+    window_set_title(window, text);
+}
+
+int main(int argc, char **argv) {
+    bool is_startup_timing_enabled = false;
+    const char *stats_dump_path = STATS_DEFAULT_DUMP_PATH;
+    const char *trace_path = NULL;
+    bool is_latency_self_test_enabled = false;
+    double latency_self_test_max_p99 = LATENCY_SELF_TEST_DEFAULT_MAX_P99;
+    bool should_normalize_paste_newlines = true;
+
+    for (int32_t i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--echo-child") == 0) {
+            return run_echo_child();
+        } else if (strcmp(argv[i], "--startup-timing") == 0) {
+            is_startup_timing_enabled = true;
+        } else if (strcmp(argv[i], "--latency-self-test") == 0) {
+            is_latency_self_test_enabled = true;
+
+            // Optionally followed by the maximum 99th percentile in milliseconds.
+            if (i + 1 < argc) {
+                char *end = NULL;
+                double max_p99 = strtod(argv[i + 1], &end);
+
+                if (end != argv[i + 1]) {
+                    latency_self_test_max_p99 = max_p99;
+                    i++;
+                }
+            }
+        } else if (strcmp(argv[i], "--raw-paste") == 0) {
+            // Pastes are sent as they are, instead of turning newlines into carriage returns.
+            should_normalize_paste_newlines = false;
+        } else if (strcmp(argv[i], "--stats-file") == 0 && i + 1 < argc) {
+            i++;
+            stats_dump_path = argv[i];
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            i++;
+            trace_path = argv[i];
+        }
+    }
+
+    // Tracing has to start before any other threads do, so that they all get recorded.
+    if (trace_path) {
+        if (trace_start()) {
+            TRACE_SET_THREAD_NAME("main");
+        } else {
+            puts("trace: tracing was disabled at build time, rebuild with TERM_TRACE to use --trace");
+            trace_path = NULL;
+        }
+    }
+
+    struct Stats stats = stats_create();
+    struct StatsReport stats_report = {0};
+    double last_stats_sample_time = clock_get_time();
 
-    struct ReadThreadData read_thread_data = read_thread_data_create(&pseudo_console, &grid, &renderer);
+    struct LatencyTracker latency_tracker = latency_tracker_create();
+    double latency_self_test_start_time = 0.0;
+    double last_latency_self_test_input_time = 0.0;
+    int32_t exit_code = 0;
+
+    struct StartupTiming startup_timing = {.start_time = clock_get_time()};
+    bool has_drawn_first_frame = false;
+    bool has_drawn_prompt = false;
+
+    const int32_t grid_width = WINDOW_WIDTH / FONT_GLYPH_WIDTH;
+    const int32_t grid_height = WINDOW_HEIGHT / FONT_GLYPH_HEIGHT;
+
+    // The shell is started first so that it can start up while the window and renderer are being created, its
+    // output is buffered by the reader until there's a grid to write it to.
+    wchar_t command[LATENCY_SELF_TEST_COMMAND_CAPACITY] = PSEUDO_CONSOLE_DEFAULT_COMMAND;
+    if (is_latency_self_test_enabled) {
+        get_echo_child_command(command, LATENCY_SELF_TEST_COMMAND_CAPACITY);
+    }
+
+    struct PseudoConsole pseudo_console = pseudo_console_create((COORD){grid_width, grid_height}, command);
+    struct ReadThreadData read_thread_data = read_thread_data_create(&pseudo_console, &stats, &latency_tracker);
     struct Reader reader = reader_create(&read_thread_data);
+    struct PtyWriter pty_writer = pty_writer_create(pseudo_console.input, &latency_tracker);
+    startup_timing.pseudo_console_time = clock_get_time();
+
+    struct Window window = window_create(WINDOW_TITLE, WINDOW_WIDTH, WINDOW_HEIGHT);
+    startup_timing.window_time = clock_get_time();
+    struct Renderer renderer = renderer_create(grid_width, grid_height, thread_get_processor_count());
+    startup_timing.renderer_time = clock_get_time();
+    struct Grid grid = grid_create(
+        grid_width,
+        grid_height,
+        &renderer,
+        renderer_on_row_changed_callback,
+        renderer_on_cursor_changed_callback
+    );
+
+    window_setup(&window, &grid, &renderer);
+
+    read_thread_data_attach(&read_thread_data, &grid, &renderer);
+    startup_timing.attach_time = clock_get_time();
 
     double last_frame_time = glfwGetTime();
-    float fps_print_timer = 0.0f;
+
+    bool is_resize_pending = false;
+    double last_resize_request_time = 0.0;
+
+    int32_t shown_paste_percent = -1;
 
     while (!glfwWindowShouldClose(window.glfw_window)) {
         if (window.did_resize) {
+            // Zooming only changes the projection, so it takes effect right away.
+            read_thread_data_lock(&read_thread_data);
+            renderer_set_scale(&renderer, window.scale);
+            read_thread_data_unlock(&read_thread_data);
+
+            is_resize_pending = true;
+            last_resize_request_time = glfwGetTime();
+            window.did_resize = false;
+        }
+
+        if (is_resize_pending && glfwGetTime() - last_resize_request_time >= RESIZE_DEBOUNCE_TIME) {
+            double resize_start_time = glfwGetTime();
+
             size_t new_grid_width = window.width / (window.scale * FONT_GLYPH_WIDTH);
             size_t new_grid_height = window.height / (window.scale * FONT_GLYPH_HEIGHT);
 
@@ -48,74 +263,290 @@ int main(void) {
                 new_grid_height = 1;
             }
 
-            read_thread_data_lock(&read_thread_data);
+            if (new_grid_width != grid.width || new_grid_height != grid.height) {
+                read_thread_data_lock(&read_thread_data);
 
-            pseudo_console_resize(&pseudo_console, new_grid_width, new_grid_height);
-            renderer_resize(&renderer, new_grid_width, new_grid_height, window.scale);
-            grid_resize(window.grid, new_grid_width, new_grid_height);
+                pseudo_console_resize(&pseudo_console, new_grid_width, new_grid_height);
+                renderer_resize(&renderer, new_grid_width, new_grid_height);
+                grid_resize(window.grid, new_grid_width, new_grid_height);
+                stats_add_resize(&stats, glfwGetTime() - resize_start_time);
 
-            read_thread_data_unlock(&read_thread_data);
+                read_thread_data_unlock(&read_thread_data);
+            }
 
-            window.did_resize = false;
+            is_resize_pending = false;
         }
 
         double current_frame_time = glfwGetTime();
         float delta_time = (float)(current_frame_time - last_frame_time);
         last_frame_time = current_frame_time;
 
-        fps_print_timer += delta_time;
+        // Exit when the process we're reading from exits.
+        if (WaitForSingleObject(pseudo_console.h_process, 0) != WAIT_TIMEOUT) {
+            break;
+        }
+
+        read_thread_data_lock(&read_thread_data);
 
-        if (fps_print_timer > 1.0f) {
-            fps_print_timer = 0.0f;
-            printf("fps: %f\n", 1.0f / delta_time);
+        // Applications often wait for replies to their queries before they start up, so they're written right after
+        // the reader parses them. They go through the same queue as typed input, so they can't split its sequences.
+        if (grid.replies.length > 0) {
+            pty_writer_push(&pty_writer, grid.replies.data, grid.replies.length);
+            list_reset_uint8_t(&grid.replies);
         }
 
-        if (window.typed_chars.length > 0) {
-            CHAR *typed_chars = (CHAR *)window.typed_chars.data;
-            WriteFile(pseudo_console.input, typed_chars, window.typed_chars.length, NULL, NULL);
+        stats_add_input(&stats, window.typed_chars.length, pty_writer_get_pending_byte_count(&pty_writer));
+        stats_add_mouse_reports(&stats, window.mouse_event_count, window.mouse_report_count);
+
+        renderer_update_glyph_cache(&renderer);
+        bool is_scroll_animating = renderer_update_scroll(&renderer, &grid, delta_time);
+
+        if (clock_get_time() - last_stats_sample_time >= STATS_SAMPLE_TIME || window.did_request_stats_dump) {
+            stats_report = stats_sample(
+                &stats,
+                grid.scrollback_lines.length,
+                grid.scrollback_byte_count + grid.scrollback_lines.capacity * sizeof(struct ScrollbackLine)
+            );
+            last_stats_sample_time = clock_get_time();
+
+            if (window.is_stats_hud_visible) {
+                update_stats_hud(&renderer, &stats_report, true);
+            }
         }
 
-        // Exit when the process we're reading from exits.
-        if (WaitForSingleObject(pseudo_console.h_process, 0) != WAIT_TIMEOUT) {
-            break;
+        if (window.did_toggle_stats_hud) {
+            update_stats_hud(&renderer, &stats_report, window.is_stats_hud_visible);
+            window.did_toggle_stats_hud = false;
         }
 
-        read_thread_data_lock(&read_thread_data);
+        if (window.did_request_stats_dump) {
+            if (stats_report_dump(&stats_report, stats_dump_path)) {
+                printf("stats: wrote %s\n", stats_dump_path);
+            } else {
+                printf("stats: failed to write %s\n", stats_dump_path);
+            }
 
-        if (renderer.needs_redraw) {
+            window.did_request_stats_dump = false;
+        }
+
+        if (renderer.needs_redraw || grid.is_palette_dirty) {
             window_show(&window);
+
+            double draw_start_time = clock_get_time();
             renderer_draw(&renderer, &grid, window.height, &window);
+            double present_time = clock_get_time();
+            stats_add_frame(
+                &stats,
+                present_time - draw_start_time,
+                renderer.frame_stats.built_row_count,
+                renderer.frame_stats.upload_byte_count
+            );
+            latency_tracker_on_present(&latency_tracker, present_time);
+
+            if (renderer.is_scrolling) {
+                stats_add_scroll_frame(&stats, present_time - draw_start_time, renderer.frame_stats.built_row_count);
+            }
 
-            renderer.needs_redraw = false;
+            // Rows that didn't fit in this frame's budget are built by the next frames.
+            renderer.needs_redraw = renderer.has_pending_rows;
+
+            if (!has_drawn_first_frame) {
+                has_drawn_first_frame = true;
+                startup_timing.first_frame_time = clock_get_time();
+            }
+
+            // The shell's prompt is the first thing that moves the cursor away from the top left corner.
+            if (!has_drawn_prompt && (grid.cursor_x > 0 || grid.cursor_y > 0)) {
+                has_drawn_prompt = true;
+                startup_timing.prompt_visible_time = clock_get_time();
+
+                if (is_startup_timing_enabled) {
+                    print_startup_timing(&startup_timing);
+                }
+
+                latency_self_test_start_time = clock_get_time();
+            }
+        } else {
+            stats.skipped_frame_count++;
         }
 
-        if (read_thread_data.title_buffer.is_dirty) {
-            window_set_title(&window, read_thread_data.title_buffer.data);
+        float paste_progress = 0.0f;
+        bool is_pasting = pty_writer_get_paste_progress(&pty_writer, &paste_progress);
+        int32_t paste_percent = is_pasting ? (int32_t)(paste_progress * 100.0f) : -1;
+
+        if (read_thread_data.title_buffer.is_dirty || paste_percent != shown_paste_percent) {
+            update_title(&window, read_thread_data.title_buffer.data, paste_percent);
 
             read_thread_data.title_buffer.is_dirty = false;
+            shown_paste_percent = paste_percent;
         }
 
         window_update(&window);
 
         read_thread_data_unlock(&read_thread_data);
 
-        // Pause until we get an update from the pseudo console, the reader, or window input.
-        HANDLE handles[2] = {pseudo_console.h_process, read_thread_data.event};
-        MsgWaitForMultipleObjects(2, handles, false, INFINITE, QS_ALLINPUT);
+        // Pause until we get an update from the pseudo console, the reader, the glyph rasterizer, the pty writer, or
+        // window input. While scrolling is animating, also wake up in time for the monitor's next refresh, and wake up
+        // when a pending resize or a HUD update is due. Rows left over from the last frame are built without waiting.
+        HANDLE handles[4] = {
+            pseudo_console.h_process,
+            read_thread_data.event,
+            renderer.glyph_cache.shared->ready_event.handle,
+            pty_writer.shared->space_event.handle,
+        };
+        DWORD timeout = is_scroll_animating ? 1000 / int32_max(window.refresh_rate, 1) : INFINITE;
+
+        if (renderer.needs_redraw) {
+            timeout = 0;
+        }
+
+        if (is_resize_pending) {
+            DWORD resize_timeout = get_timeout(RESIZE_DEBOUNCE_TIME - (glfwGetTime() - last_resize_request_time));
 
+            if (resize_timeout < timeout) {
+                timeout = resize_timeout;
+            }
+        }
+
+        if (is_latency_self_test_enabled && has_drawn_prompt) {
+            DWORD latency_self_test_timeout = get_timeout(
+                LATENCY_SELF_TEST_INTERVAL - (clock_get_time() - last_latency_self_test_input_time)
+            );
+
+            if (latency_self_test_timeout < timeout) {
+                timeout = latency_self_test_timeout;
+            }
+        }
+
+        if (shown_paste_percent >= 0) {
+            DWORD paste_timeout = get_timeout(PASTE_PROGRESS_UPDATE_TIME);
+
+            if (paste_timeout < timeout) {
+                timeout = paste_timeout;
+            }
+        }
+
+        if (window.is_stats_hud_visible) {
+            DWORD stats_timeout = get_timeout(STATS_SAMPLE_TIME - (clock_get_time() - last_stats_sample_time));
+
+            if (stats_timeout < timeout) {
+                timeout = stats_timeout;
+            }
+        }
+
+        TRACE_BEGIN("wait");
+        MsgWaitForMultipleObjects(4, handles, false, timeout, QS_ALLINPUT);
+        TRACE_END();
+
+        // GLFW doesn't say when events happened, waking up is the closest time to when input arrived.
+        double wake_time = clock_get_time();
+
+        TRACE_BEGIN("poll events");
         read_thread_data_lock(&read_thread_data);
         glfwPollEvents();
+        window_flush_mouse_reports(&window);
         read_thread_data_unlock(&read_thread_data);
+        TRACE_END();
+
+        if (window.did_type) {
+            pty_writer_cancel_paste(&pty_writer);
+        }
+
+        if (window.did_request_paste) {
+            read_thread_data_lock(&read_thread_data);
+            bool is_paste_bracketed = grid.has_bracketed_paste;
+            read_thread_data_unlock(&read_thread_data);
+
+            // The clipboard is copied by the writer, then streamed to the pty from the writer thread.
+            const char *clipboard = glfwGetClipboardString(window.glfw_window);
+
+            if (clipboard) {
+                pty_writer_paste(
+                    &pty_writer,
+                    (const uint8_t *)clipboard,
+                    strlen(clipboard),
+                    is_paste_bracketed,
+                    should_normalize_paste_newlines
+                );
+            }
+
+            window.did_request_paste = false;
+        }
+
+        // The self-test types into the same queue as the keyboard once the echo child is ready and the last key it
+        // typed has been presented.
+        if (is_latency_self_test_enabled && has_drawn_prompt) {
+            uint32_t sample_count = latency_tracker_get_sample_count(&latency_tracker);
+
+            if (sample_count >= LATENCY_SELF_TEST_SAMPLE_COUNT) {
+                double p99 = latency_tracker_print_report(&latency_tracker) * 1000.0;
+                bool did_pass = p99 <= latency_self_test_max_p99;
+
+                printf(
+                    "latency self-test: %s, p99 %.3f ms, limit %.3f ms\n",
+                    did_pass ? "passed" : "failed",
+                    p99,
+                    latency_self_test_max_p99
+                );
+                exit_code = did_pass ? 0 : 1;
+                break;
+            }
+
+            if (wake_time - latency_self_test_start_time > LATENCY_SELF_TEST_TIMEOUT) {
+                printf(
+                    "latency self-test: failed, timed out with %" PRIu32 " of %d samples\n",
+                    sample_count,
+                    LATENCY_SELF_TEST_SAMPLE_COUNT
+                );
+                exit_code = 1;
+                break;
+            }
+
+            if (latency_tracker_is_idle(&latency_tracker) &&
+                wake_time - last_latency_self_test_input_time >= LATENCY_SELF_TEST_INTERVAL) {
+                list_push_uint8_t(&window.typed_chars, 'a' + sample_count % 26);
+                last_latency_self_test_input_time = wake_time;
+            }
+        }
+
+        // Input is handed to the writer as soon as it's polled, the writer thread wakes up and writes it to the pty
+        // while this thread goes on to draw. Input that didn't fit last time is queued first to keep it in order.
+        pty_writer_flush(&pty_writer);
+
+        if (window.typed_chars.length > 0) {
+            // The latency tracker has to see the input before the writer can write it.
+            latency_tracker_on_input(&latency_tracker, wake_time);
+            pty_writer_push(&pty_writer, window.typed_chars.data, window.typed_chars.length);
+        }
     }
 
+    pty_writer_destroy(&pty_writer);
     pseudo_console_destroy(&pseudo_console);
     reader_destroy(&reader);
     read_thread_data_destroy(&read_thread_data);
     window_destroy(&window);
-    grid_destroy(&grid);
+    // The renderer's prefetch thread may still be reading scrollback lines, so it has to stop before the grid is freed.
     renderer_destroy(&renderer);
+    grid_destroy(&grid);
+
+    if (!is_latency_self_test_enabled && latency_tracker_get_sample_count(&latency_tracker) > 0) {
+        latency_tracker_print_report(&latency_tracker);
+    }
+
+    latency_tracker_destroy(&latency_tracker);
+
+    // Every thread that recorded spans has stopped by now.
+    if (trace_path) {
+        if (trace_write(trace_path)) {
+            printf("trace: wrote %s\n", trace_path);
+        } else {
+            printf("trace: failed to write %s\n", trace_path);
+        }
+
+        trace_destroy();
+    }
 
     printf("Found leaks: %s\n", _CrtDumpMemoryLeaks() ? "true" : "false");
 
-    return 0;
+    return exit_code;
 }
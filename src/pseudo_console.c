@@ -38,7 +38,7 @@ static HRESULT init_startup_information(HPCON hpc, STARTUPINFOEX *psi) {
     return S_OK;
 }
 
-struct PseudoConsole pseudo_console_create(COORD size) {
+struct PseudoConsole pseudo_console_create(COORD size, PCWSTR command_line) {
     HRESULT hr = S_OK;
 
     // Closed after creating the child process.
@@ -81,10 +81,9 @@ struct PseudoConsole pseudo_console_create(COORD size) {
     STARTUPINFOEX si_ex;
     init_startup_information(hpc, &si_ex);
 
-    PCWSTR child_application = L"C:\\Program Files\\PowerShell\\7\\pwsh.exe";
-
-    const size_t child_application_length = wcslen(child_application) + 1;
-    PWSTR command = (PWSTR)HeapAlloc(GetProcessHeap(), 0, sizeof(wchar_t) * child_application_length);
+    // CreateProcessW may modify the command line, so it needs a copy.
+    const size_t command_line_length = wcslen(command_line) + 1;
+    PWSTR command = (PWSTR)HeapAlloc(GetProcessHeap(), 0, sizeof(wchar_t) * command_line_length);
 
     if (!command) {
         return (struct PseudoConsole){
@@ -96,7 +95,7 @@ struct PseudoConsole pseudo_console_create(COORD size) {
         };
     }
 
-    wcscpy_s(command, child_application_length, child_application);
+    wcscpy_s(command, command_line_length, command_line);
 
     PROCESS_INFORMATION pi;
     ZeroMemory(&pi, sizeof(pi));
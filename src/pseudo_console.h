@@ -13,7 +13,9 @@ struct PseudoConsole {
     HANDLE output, input;
 };
 
-struct PseudoConsole pseudo_console_create(COORD size);
+#define PSEUDO_CONSOLE_DEFAULT_COMMAND L"C:\\Program Files\\PowerShell\\7\\pwsh.exe"
+
+struct PseudoConsole pseudo_console_create(COORD size, PCWSTR command_line);
 void pseudo_console_resize(struct PseudoConsole *pseudo_console, size_t width, size_t height);
 void pseudo_console_destroy(struct PseudoConsole *pseudo_console);
 
@@ -0,0 +1,386 @@
+#include "pty_writer.h"
+
+#include "atomic.h"
+#include "clock.h"
+#include "trace.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+// Writes what's in the queue up to the write index.
+static void pty_writer_write_queue(struct PtyWriterShared *shared, uint64_t write_i) {
+    uint64_t read_i = shared->read_i;
+
+    if (write_i != read_i) {
+        latency_tracker_on_write(shared->latency_tracker, clock_get_time());
+    }
+
+    while (write_i != read_i) {
+        size_t start = read_i & (PTY_WRITER_QUEUE_CAPACITY - 1);
+        size_t length = write_i - read_i;
+
+        // Bytes that wrap around to the start of the queue are written by the next call.
+        if (length > PTY_WRITER_QUEUE_CAPACITY - start) {
+            length = PTY_WRITER_QUEUE_CAPACITY - start;
+        }
+
+        TRACE_BEGIN("pty write");
+        DWORD written_length = 0;
+        bool did_write = WriteFile(shared->output, shared->queue + start, (DWORD)length, &written_length, NULL);
+        TRACE_END();
+
+        // The child has exited or the write was cancelled, there's nowhere for the rest of the input to go.
+        if (!did_write) {
+            read_i = write_i;
+        } else {
+            read_i += written_length;
+        }
+
+        atomic_store_release_uint64(&shared->read_i, read_i);
+    }
+
+    if (atomic_load_acquire_uint64(&shared->is_waiting_for_space)) {
+        atomic_store_release_uint64(&shared->is_waiting_for_space, false);
+        event_set(&shared->space_event);
+    }
+}
+
+// Returns false if the child has exited or the write was cancelled.
+static bool pty_writer_write_all(struct PtyWriterShared *shared, const uint8_t *data, size_t length) {
+    while (length > 0) {
+        DWORD written_length = 0;
+
+        if (!WriteFile(shared->output, data, (DWORD)length, &written_length, NULL)) {
+            return false;
+        }
+
+        data += written_length;
+        length -= written_length;
+    }
+
+    return true;
+}
+
+static void pty_writer_paste_destroy(struct PtyWriterPaste *paste) {
+    free(paste->data);
+    free(paste);
+}
+
+// Pastes are sent the way the enter key is, as carriage returns.
+static void pty_writer_paste_normalize_newlines(struct PtyWriterPaste *paste) {
+    size_t length = 0;
+
+    for (size_t i = 0; i < paste->length; i++) {
+        uint8_t character = paste->data[i];
+
+        if (character == '\r' && i + 1 < paste->length && paste->data[i + 1] == '\n') {
+            continue;
+        }
+
+        paste->data[length] = character == '\n' ? '\r' : character;
+        length++;
+    }
+
+    paste->length = length;
+}
+
+// Takes the next paste from the main thread, returns NULL if there isn't one.
+static struct PtyWriterPaste *pty_writer_start_paste(struct PtyWriterShared *shared) {
+    mutex_lock(&shared->paste_mutex);
+
+    struct PtyWriterPaste *paste = shared->pending_paste;
+    shared->pending_paste = NULL;
+
+    if (paste) {
+        shared->is_pasting = true;
+        shared->should_cancel_paste = false;
+        shared->paste_length = 0;
+        shared->paste_written_length = 0;
+    }
+
+    mutex_unlock(&shared->paste_mutex);
+
+    if (!paste) {
+        return NULL;
+    }
+
+    if (paste->should_normalize_newlines) {
+        pty_writer_paste_normalize_newlines(paste);
+    }
+
+    mutex_lock(&shared->paste_mutex);
+    shared->paste_length = paste->length;
+    mutex_unlock(&shared->paste_mutex);
+
+    // Input pushed before the paste was handed over has to be written before it.
+    pty_writer_write_queue(shared, paste->queue_write_i);
+
+    if (paste->is_bracketed) {
+        pty_writer_write_all(shared, (const uint8_t *)PTY_WRITER_PASTE_START, sizeof(PTY_WRITER_PASTE_START) - 1);
+    }
+
+    return paste;
+}
+
+// Writes the next chunk of the paste, returns NULL once the paste is done or has been cancelled.
+static struct PtyWriterPaste *pty_writer_continue_paste(struct PtyWriterShared *shared, struct PtyWriterPaste *paste) {
+    mutex_lock(&shared->paste_mutex);
+    bool is_done = shared->should_cancel_paste;
+    size_t written_length = shared->paste_written_length;
+    mutex_unlock(&shared->paste_mutex);
+
+    if (!is_done) {
+        size_t chunk_length = paste->length - written_length;
+
+        if (chunk_length > PTY_WRITER_PASTE_CHUNK_SIZE) {
+            chunk_length = PTY_WRITER_PASTE_CHUNK_SIZE;
+        }
+
+        TRACE_BEGIN("pty paste write");
+        bool did_write = pty_writer_write_all(shared, paste->data + written_length, chunk_length);
+        TRACE_END();
+
+        written_length = did_write ? written_length + chunk_length : paste->length;
+        is_done = written_length == paste->length;
+
+        mutex_lock(&shared->paste_mutex);
+        shared->paste_written_length = written_length;
+        mutex_unlock(&shared->paste_mutex);
+    }
+
+    if (!is_done) {
+        return paste;
+    }
+
+    if (paste->is_bracketed) {
+        pty_writer_write_all(shared, (const uint8_t *)PTY_WRITER_PASTE_END, sizeof(PTY_WRITER_PASTE_END) - 1);
+    }
+
+    mutex_lock(&shared->paste_mutex);
+    shared->is_pasting = false;
+    shared->should_cancel_paste = false;
+    mutex_unlock(&shared->paste_mutex);
+
+    pty_writer_paste_destroy(paste);
+
+    return NULL;
+}
+
+static void pty_writer_thread_start(void *data) {
+    struct PtyWriterShared *shared = data;
+    struct PtyWriterPaste *paste = NULL;
+
+    TRACE_SET_THREAD_NAME("pty writer");
+
+    while (true) {
+        // Pastes are written without waiting between chunks.
+        if (!paste) {
+            event_wait(&shared->has_data_event);
+        }
+
+        if (atomic_load_acquire_uint64(&shared->should_stop)) {
+            break;
+        }
+
+        if (paste) {
+            paste = pty_writer_continue_paste(shared, paste);
+        }
+
+        if (!paste) {
+            pty_writer_write_queue(shared, atomic_load_acquire_uint64(&shared->write_i));
+            paste = pty_writer_start_paste(shared);
+        }
+    }
+
+    if (paste) {
+        pty_writer_paste_destroy(paste);
+    }
+}
+
+struct PtyWriter pty_writer_create(HANDLE output, struct LatencyTracker *latency_tracker) {
+    struct PtyWriterShared *shared = malloc(sizeof(struct PtyWriterShared));
+    assert(shared);
+
+    shared->write_i = 0;
+    shared->read_i = 0;
+    shared->is_waiting_for_space = false;
+    event_init(&shared->has_data_event);
+    event_init(&shared->space_event);
+    mutex_init(&shared->paste_mutex);
+    shared->pending_paste = NULL;
+    shared->is_pasting = false;
+    shared->should_cancel_paste = false;
+    shared->paste_length = 0;
+    shared->paste_written_length = 0;
+    shared->output = output;
+    shared->latency_tracker = latency_tracker;
+    shared->should_stop = false;
+
+    return (struct PtyWriter){
+        .shared = shared,
+        .writer_thread = thread_create(pty_writer_thread_start, shared),
+        .overflow = list_create_uint8_t(16),
+    };
+}
+
+// Copies as much of the data as fits into the queue, returns the number of bytes copied.
+static size_t pty_writer_enqueue(struct PtyWriterShared *shared, const uint8_t *data, size_t length) {
+    uint64_t write_i = shared->write_i;
+    uint64_t read_i = atomic_load_acquire_uint64(&shared->read_i);
+    size_t free_length = PTY_WRITER_QUEUE_CAPACITY - (size_t)(write_i - read_i);
+
+    if (length > free_length) {
+        length = free_length;
+    }
+
+    size_t start = write_i & (PTY_WRITER_QUEUE_CAPACITY - 1);
+    size_t first_length = length < PTY_WRITER_QUEUE_CAPACITY - start ? length : PTY_WRITER_QUEUE_CAPACITY - start;
+
+    memcpy(shared->queue + start, data, first_length);
+    memcpy(shared->queue, data + first_length, length - first_length);
+
+    atomic_store_release_uint64(&shared->write_i, write_i + length);
+
+    return length;
+}
+
+void pty_writer_push(struct PtyWriter *pty_writer, const uint8_t *data, size_t length) {
+    struct PtyWriterShared *shared = pty_writer->shared;
+
+    if (length == 0) {
+        return;
+    }
+
+    // Input can only go straight into the queue when nothing older is still waiting for space.
+    size_t enqueued_length = 0;
+    if (pty_writer->overflow.length == 0) {
+        enqueued_length = pty_writer_enqueue(shared, data, length);
+    }
+
+    for (size_t i = enqueued_length; i < length; i++) {
+        list_push_uint8_t(&pty_writer->overflow, data[i]);
+    }
+
+    // The flag has to be set before waking the writer, otherwise it could miss it and never free up space.
+    if (pty_writer->overflow.length > 0) {
+        atomic_store_release_uint64(&shared->is_waiting_for_space, true);
+    }
+
+    event_set(&shared->has_data_event);
+}
+
+void pty_writer_flush(struct PtyWriter *pty_writer) {
+    struct PtyWriterShared *shared = pty_writer->shared;
+    struct List_uint8_t *overflow = &pty_writer->overflow;
+
+    if (overflow->length == 0) {
+        return;
+    }
+
+    size_t enqueued_length = pty_writer_enqueue(shared, overflow->data, overflow->length);
+
+    memmove(overflow->data, overflow->data + enqueued_length, overflow->length - enqueued_length);
+    overflow->length -= enqueued_length;
+
+    if (overflow->length > 0) {
+        atomic_store_release_uint64(&shared->is_waiting_for_space, true);
+    }
+
+    event_set(&shared->has_data_event);
+}
+
+void pty_writer_paste(
+    struct PtyWriter *pty_writer, const uint8_t *data, size_t length, bool is_bracketed, bool should_normalize_newlines
+) {
+
+    struct PtyWriterShared *shared = pty_writer->shared;
+
+    if (length == 0) {
+        return;
+    }
+
+    struct PtyWriterPaste *paste = malloc(sizeof(struct PtyWriterPaste));
+    assert(paste);
+
+    *paste = (struct PtyWriterPaste){
+        .data = malloc(length),
+        .length = length,
+        .is_bracketed = is_bracketed,
+        .should_normalize_newlines = should_normalize_newlines,
+        .queue_write_i = shared->write_i,
+    };
+    assert(paste->data);
+
+    memcpy(paste->data, data, length);
+
+    pty_writer_cancel_paste(pty_writer);
+
+    mutex_lock(&shared->paste_mutex);
+    shared->pending_paste = paste;
+    mutex_unlock(&shared->paste_mutex);
+
+    event_set(&shared->has_data_event);
+}
+
+void pty_writer_cancel_paste(struct PtyWriter *pty_writer) {
+    struct PtyWriterShared *shared = pty_writer->shared;
+
+    mutex_lock(&shared->paste_mutex);
+
+    if (shared->pending_paste) {
+        pty_writer_paste_destroy(shared->pending_paste);
+        shared->pending_paste = NULL;
+    }
+
+    if (shared->is_pasting) {
+        shared->should_cancel_paste = true;
+    }
+
+    mutex_unlock(&shared->paste_mutex);
+}
+
+bool pty_writer_get_paste_progress(struct PtyWriter *pty_writer, float *progress) {
+    struct PtyWriterShared *shared = pty_writer->shared;
+
+    mutex_lock(&shared->paste_mutex);
+
+    bool is_pasting = shared->is_pasting || shared->pending_paste;
+    *progress = shared->paste_length > 0 ? (float)shared->paste_written_length / shared->paste_length : 0.0f;
+
+    mutex_unlock(&shared->paste_mutex);
+
+    return is_pasting;
+}
+
+size_t pty_writer_get_pending_byte_count(struct PtyWriter *pty_writer) {
+    struct PtyWriterShared *shared = pty_writer->shared;
+    uint64_t read_i = atomic_load_acquire_uint64(&shared->read_i);
+
+    return (size_t)(shared->write_i - read_i) + pty_writer->overflow.length;
+}
+
+void pty_writer_destroy(struct PtyWriter *pty_writer) {
+    struct PtyWriterShared *shared = pty_writer->shared;
+
+    atomic_store_release_uint64(&shared->should_stop, true);
+    event_set(&shared->has_data_event);
+
+    // The writer might be stuck writing to a child that stopped reading, keep cancelling the write until it notices
+    // that it should stop.
+    while (WaitForSingleObject(pty_writer->writer_thread.handle, 1) == WAIT_TIMEOUT) {
+        CancelSynchronousIo(pty_writer->writer_thread.handle);
+    }
+
+    thread_join(&pty_writer->writer_thread);
+
+    if (shared->pending_paste) {
+        pty_writer_paste_destroy(shared->pending_paste);
+    }
+
+    mutex_destroy(&shared->paste_mutex);
+    event_destroy(&shared->has_data_event);
+    event_destroy(&shared->space_event);
+    list_destroy_uint8_t(&pty_writer->overflow);
+    free(shared);
+}
\ No newline at end of file
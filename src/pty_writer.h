@@ -0,0 +1,91 @@
+#ifndef PTY_WRITER_H
+#define PTY_WRITER_H
+
+#include "detect_leak.h"
+
+#include "list.h"
+#include "thread.h"
+#include "latency.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <inttypes.h>
+
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+// Has to be a power of two. Input that doesn't fit waits in the writer's overflow list until the pty catches up.
+#define PTY_WRITER_QUEUE_CAPACITY (1024 * 1024)
+// Pastes are written this many bytes at a time, so that they can be cancelled in between.
+#define PTY_WRITER_PASTE_CHUNK_SIZE 4096
+
+#define PTY_WRITER_PASTE_START "\x1b[200~"
+#define PTY_WRITER_PASTE_END "\x1b[201~"
+
+struct PtyWriterPaste {
+    uint8_t *data;
+    size_t length;
+    bool is_bracketed;
+    bool should_normalize_newlines;
+    // Input that was pushed before the paste, it's written first.
+    uint64_t queue_write_i;
+};
+
+// State shared with the writer thread, allocated separately so that it doesn't move when the writer is copied. The
+// main thread is the only producer and the writer thread is the only consumer, so the queue doesn't need a lock:
+// each side only writes its own index and publishes it after touching the bytes.
+struct PtyWriterShared {
+    uint8_t queue[PTY_WRITER_QUEUE_CAPACITY];
+    uint64_t write_i;
+    uint64_t read_i;
+    // Set by the main thread while input is waiting in the overflow list, so the writer knows to wake it up.
+    uint64_t is_waiting_for_space;
+
+    // Set whenever input is queued.
+    struct Event has_data_event;
+    // Set when the writer frees up space that the main thread is waiting for.
+    struct Event space_event;
+
+    // Protects the paste state. The writer thread owns the paste it's writing, the main thread only hands it the next
+    // one and reads the progress.
+    struct Mutex paste_mutex;
+    struct PtyWriterPaste *pending_paste;
+    bool is_pasting;
+    bool should_cancel_paste;
+    size_t paste_length;
+    size_t paste_written_length;
+
+    HANDLE output;
+    struct LatencyTracker *latency_tracker;
+    uint64_t should_stop;
+};
+
+// Writes input to the pty from its own thread, so that a child that stops reading its input can't block the main
+// loop. Pushing never blocks. Input pushed while a paste is being written waits until the paste is done, so it can't
+// end up inside the paste's brackets.
+struct PtyWriter {
+    struct PtyWriterShared *shared;
+    struct Thread writer_thread;
+
+    // Input that didn't fit in the queue, in order.
+    struct List_uint8_t overflow;
+};
+
+struct PtyWriter pty_writer_create(HANDLE output, struct LatencyTracker *latency_tracker);
+void pty_writer_push(struct PtyWriter *pty_writer, const uint8_t *data, size_t length);
+// Moves input from the overflow list into the queue, call it when the space event is set.
+void pty_writer_flush(struct PtyWriter *pty_writer);
+// Copies the data and has the writer thread stream it to the pty, any paste that's still being written is cancelled.
+void pty_writer_paste(
+    struct PtyWriter *pty_writer, const uint8_t *data, size_t length, bool is_bracketed, bool should_normalize_newlines
+);
+// Stops writing the current paste after the chunk that's being written, bracketed pastes still get their end marker.
+void pty_writer_cancel_paste(struct PtyWriter *pty_writer);
+// Returns true while a paste is waiting to be written or being written, the progress is from 0 to 1.
+bool pty_writer_get_paste_progress(struct PtyWriter *pty_writer, float *progress);
+// Bytes that have been pushed but not written to the pty yet.
+size_t pty_writer_get_pending_byte_count(struct PtyWriter *pty_writer);
+// Has to be called before the pty is closed.
+void pty_writer_destroy(struct PtyWriter *pty_writer);
+
+#endif
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include "reader.h"
 
 #include "font.h"
+#include "clock.h"
+#include "trace.h"
 
 static uint32_t utf8_to_utf32(struct TextBuffer *text_buffer, size_t *i, bool *was_multi_byte) {
     uint8_t first_char = text_buffer->data[*i];
@@ -41,111 +43,206 @@ static uint32_t utf8_to_utf32(struct TextBuffer *text_buffer, size_t *i, bool *w
 
 static void write_char_to_grid(struct Grid *grid, uint32_t character) {
     if (grid->cursor_x >= grid->width) {
+        grid->wrapped_rows[grid->cursor_y] = true;
         grid_cursor_move_to(grid, 0, grid->cursor_y + 1);
     }
     grid_set_char(grid, grid->cursor_x, grid->cursor_y, character);
     grid->cursor_x++;
 }
 
-static DWORD WINAPI read_thread_start(void *start_info) {
-    struct ReadThreadData *data = start_info;
+// The wait time is only changed after getting the lock, since the stats are protected by it.
+static void read_thread_data_lock_timed(struct ReadThreadData *data, double *wait_time) {
+    double start_time = clock_get_time();
+    TRACE_BEGIN("lock wait");
+    WaitForSingleObject(data->mutex, INFINITE);
+    TRACE_END();
+    *wait_time += clock_get_time() - start_time;
+}
 
+// The read time is passed on to the latency tracker.
+static void parse_text_buffer(struct ReadThreadData *data, double read_time) {
     struct Grid *grid = data->grid;
     struct Renderer *renderer = data->renderer;
-    struct PseudoConsole *pseudo_console = data->pseudo_console;
     struct TextBuffer *text_buffer = &data->text_buffer;
 
-    while (true) {
-        if (!ReadFile(
-                pseudo_console->output,
-                text_buffer->data + text_buffer->kept_length,
-                TEXT_BUFFER_CAPACITY - text_buffer->kept_length,
-                &text_buffer->length,
-                NULL
-            )) {
+    text_buffer->length += text_buffer->kept_length;
+    text_buffer->kept_length = 0;
+
+    TRACE_BEGIN("parse");
+    read_thread_data_lock_timed(data, &data->stats->reader_lock_wait_time);
+    data->stats->parsed_byte_count += text_buffer->length;
+
+    for (size_t i = 0; i < text_buffer->length;) {
+        bool was_multi_byte = false;
+        uint32_t character = utf8_to_utf32(text_buffer, &i, &was_multi_byte);
+
+        if (was_multi_byte) {
+            write_char_to_grid(grid, character);
+            continue;
+        }
+
+        // Check for escape sequences.
+        // https://learn.microsoft.com/en-us/windows/console/console-virtual-terminal-sequences If <n>
+        // is omitted for colors, it is assumed to be 0, if <x,y,n> are omitted for positioning, they
+        // are assumed to be 1.
+        size_t furthest_i = 0;
+        if (grid_parse_escape_sequence(grid, text_buffer, &data->title_buffer, &i, &furthest_i)) {
+            continue;
+        } else if (furthest_i >= text_buffer->length && i < text_buffer->length) {
+            // The parse failed due to reaching the end of the buffer, the sequence may have been split
+            // across multiple reads.
+            text_buffer_keep_from_i(text_buffer, i);
             break;
         }
 
-        text_buffer->length += text_buffer->kept_length;
-        text_buffer->kept_length = 0;
+        // Parse escape characters:
+        if (text_buffer_match_char(text_buffer, '\r', &i)) {
+            grid_cursor_move_to(grid, 0, grid->cursor_y);
+            continue;
+        }
+
+        if (text_buffer_match_char(text_buffer, '\n', &i)) {
+            if (grid->cursor_y == grid->height - 1) {
+                renderer_scroll_down(renderer, 1, true);
+                grid_scroll_down(grid);
+            } else {
+                grid_cursor_move(grid, 0, 1);
+            }
+            continue;
+        }
 
-        read_thread_data_lock(data);
+        if (text_buffer_match_char(text_buffer, '\b', &i)) {
+            grid_cursor_move(grid, -1, 0);
+            continue;
+        }
 
-        for (size_t i = 0; i < text_buffer->length;) {
-            bool was_multi_byte = false;
-            uint32_t character = utf8_to_utf32(text_buffer, &i, &was_multi_byte);
+        // \a is the alert/bell escape sequence, ignore it.
+        if (text_buffer_match_char(text_buffer, '\a', &i)) {
+            continue;
+        }
 
-            if (was_multi_byte) {
-                write_char_to_grid(grid, character);
-                continue;
-            }
+        write_char_to_grid(grid, text_buffer->data[i]);
 
-            // Check for escape sequences.
-            // https://learn.microsoft.com/en-us/windows/console/console-virtual-terminal-sequences If <n>
-            // is omitted for colors, it is assumed to be 0, if <x,y,n> are omitted for positioning, they
-            // are assumed to be 1.
-            size_t furthest_i = 0;
-            if (grid_parse_escape_sequence(grid, text_buffer, &data->title_buffer, &i, &furthest_i)) {
-                continue;
-            } else if (furthest_i >= text_buffer->length && i < text_buffer->length) {
-                // The parse failed due to reaching the end of the buffer, the sequence may have been split
-                // across multiple reads.
-                text_buffer_keep_from_i(text_buffer, i);
-                break;
-            }
+        i++;
+    }
 
-            // Parse escape characters:
-            if (text_buffer_match_char(text_buffer, '\r', &i)) {
-                grid_cursor_move_to(grid, 0, grid->cursor_y);
-                continue;
-            }
+    // The echo has to be recorded before the main thread can draw it, otherwise the frame that presents it wouldn't
+    // count.
+    latency_tracker_on_read(data->latency_tracker, read_time);
 
-            if (text_buffer_match_char(text_buffer, '\n', &i)) {
-                if (grid->cursor_y == grid->height - 1) {
-                    renderer_scroll_down(renderer, true);
-                    grid_scroll_down(grid);
-                } else {
-                    grid_cursor_move(grid, 0, 1);
-                }
-                continue;
-            }
+    SetEvent(data->event);
+    read_thread_data_unlock(data);
+    TRACE_END();
+}
 
-            if (text_buffer_match_char(text_buffer, '\b', &i)) {
-                grid_cursor_move(grid, -1, 0);
-                continue;
-            }
+// The shell is started before the window and renderer, so until there is a grid to write to its output is only
+// buffered. The pipe is polled rather than read with a blocking call so that the reader notices when the grid is
+// ready even if the shell has gone quiet, and so that the shell never blocks on a full pipe.
+static void buffer_startup_output(struct ReadThreadData *data) {
+    struct List_uint8_t *startup_output = &data->startup_output;
+
+    while (WaitForSingleObject(data->attach_event, READER_STARTUP_POLL_TIME) == WAIT_TIMEOUT) {
+        DWORD available_length = 0;
+        if (!PeekNamedPipe(data->pseudo_console->output, NULL, 0, NULL, &available_length, NULL) ||
+            available_length == 0) {
+            continue;
+        }
 
-            // \a is the alert/bell escape sequence, ignore it.
-            if (text_buffer_match_char(text_buffer, '\a', &i)) {
-                continue;
-            }
+        while (startup_output->length + available_length > startup_output->capacity) {
+            startup_output->capacity *= 2;
+            startup_output->data = realloc(startup_output->data, startup_output->capacity);
+            assert(startup_output->data);
+        }
 
-            write_char_to_grid(grid, text_buffer->data[i]);
+        DWORD read_length = 0;
+        if (ReadFile(
+                data->pseudo_console->output,
+                startup_output->data + startup_output->length,
+                available_length,
+                &read_length,
+                NULL
+            )) {
+            startup_output->length += read_length;
+        }
+    }
+}
+
+static void parse_startup_output(struct ReadThreadData *data) {
+    struct List_uint8_t *startup_output = &data->startup_output;
+    struct TextBuffer *text_buffer = &data->text_buffer;
+
+    for (size_t i = 0; i < startup_output->length;) {
+        size_t length = startup_output->length - i;
+        size_t free_length = TEXT_BUFFER_CAPACITY - text_buffer->kept_length;
+        if (length > free_length) {
+            length = free_length;
+        }
+
+        memcpy(text_buffer->data + text_buffer->kept_length, startup_output->data + i, length);
+        text_buffer->length = (DWORD)length;
+        i += length;
+
+        // Startup output was read before any input could have been written, so it's never an echo.
+        parse_text_buffer(data, 0.0);
+    }
+
+    list_reset_uint8_t(startup_output);
+}
 
-            i++;
+static DWORD WINAPI read_thread_start(void *start_info) {
+    struct ReadThreadData *data = start_info;
+
+    struct PseudoConsole *pseudo_console = data->pseudo_console;
+    struct TextBuffer *text_buffer = &data->text_buffer;
+
+    TRACE_SET_THREAD_NAME("reader");
+
+    buffer_startup_output(data);
+    parse_startup_output(data);
+    SetEvent(data->startup_parsed_event);
+
+    while (true) {
+        TRACE_BEGIN("read");
+        bool did_read = ReadFile(
+            pseudo_console->output,
+            text_buffer->data + text_buffer->kept_length,
+            TEXT_BUFFER_CAPACITY - text_buffer->kept_length,
+            &text_buffer->length,
+            NULL
+        );
+        double read_time = clock_get_time();
+        TRACE_END();
+
+        if (!did_read) {
+            break;
         }
 
-        SetEvent(data->event);
-        read_thread_data_unlock(data);
+        parse_text_buffer(data, read_time);
     }
 
     return 0;
 }
 
 struct ReadThreadData read_thread_data_create(
-    struct PseudoConsole *pseudo_console, struct Grid *grid, struct Renderer *renderer
+    struct PseudoConsole *pseudo_console, struct Stats *stats, struct LatencyTracker *latency_tracker
 ) {
+
     struct ReadThreadData read_thread_data = (struct ReadThreadData){
         .pseudo_console = pseudo_console,
-        .grid = grid,
-        .renderer = renderer,
+        .stats = stats,
+        .latency_tracker = latency_tracker,
         .text_buffer = text_buffer_create(),
+        .startup_output = list_create_uint8_t(TEXT_BUFFER_CAPACITY),
         .mutex = CreateMutex(NULL, false, NULL),
         .event = CreateEvent(NULL, false, false, NULL),
+        .attach_event = CreateEvent(NULL, false, false, NULL),
+        .startup_parsed_event = CreateEvent(NULL, false, false, NULL),
     };
 
     assert(read_thread_data.mutex);
     assert(read_thread_data.event);
+    assert(read_thread_data.attach_event);
+    assert(read_thread_data.startup_parsed_event);
 
     return read_thread_data;
 }
@@ -153,12 +250,23 @@ struct ReadThreadData read_thread_data_create(
 void read_thread_data_destroy(struct ReadThreadData *read_thread_data) {
     CloseHandle(read_thread_data->mutex);
     CloseHandle(read_thread_data->event);
+    CloseHandle(read_thread_data->attach_event);
+    CloseHandle(read_thread_data->startup_parsed_event);
 
     text_buffer_destroy(&read_thread_data->text_buffer);
+    list_destroy_uint8_t(&read_thread_data->startup_output);
+}
+
+void read_thread_data_attach(struct ReadThreadData *read_thread_data, struct Grid *grid, struct Renderer *renderer) {
+    read_thread_data->grid = grid;
+    read_thread_data->renderer = renderer;
+
+    SetEvent(read_thread_data->attach_event);
+    WaitForSingleObject(read_thread_data->startup_parsed_event, INFINITE);
 }
 
 void read_thread_data_lock(struct ReadThreadData *read_thread_data) {
-    WaitForSingleObject(read_thread_data->mutex, INFINITE);
+    read_thread_data_lock_timed(read_thread_data, &read_thread_data->stats->main_lock_wait_time);
 }
 
 void read_thread_data_unlock(struct ReadThreadData *read_thread_data) {
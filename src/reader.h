@@ -4,28 +4,44 @@
 #include "graphics/renderer.h"
 #include "pseudo_console.h"
 #include "grid.h"
+#include "stats.h"
+#include "latency.h"
 
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
 
+// How often the pipe is checked for output while the window and renderer are still being created.
+#define READER_STARTUP_POLL_TIME 1
+
 struct ReadThreadData {
     struct PseudoConsole *pseudo_console;
     struct Grid *grid;
     struct Renderer *renderer;
+    struct Stats *stats;
+    struct LatencyTracker *latency_tracker;
 
     struct TextBuffer text_buffer;
     struct TitleBuffer title_buffer;
+    // Output received before the grid was attached.
+    struct List_uint8_t startup_output;
 
     HANDLE mutex;
     HANDLE event;
+    HANDLE attach_event;
+    HANDLE startup_parsed_event;
 };
 
 struct Reader {
     HANDLE read_thread;
 };
 
-struct ReadThreadData read_thread_data_create(struct PseudoConsole *pseudo_console, struct Grid *grid, struct Renderer *renderer);
+struct ReadThreadData read_thread_data_create(
+    struct PseudoConsole *pseudo_console, struct Stats *stats, struct LatencyTracker *latency_tracker
+);
 void read_thread_data_destroy(struct ReadThreadData *read_thread_data);
+// Gives the reader a grid to write to, then waits until the output buffered so far has been written to it.
+void read_thread_data_attach(struct ReadThreadData *read_thread_data, struct Grid *grid, struct Renderer *renderer);
+// Only used by the main thread, the time it spends waiting for the lock is added to the stats.
 void read_thread_data_lock(struct ReadThreadData *read_thread_data);
 void read_thread_data_unlock(struct ReadThreadData *read_thread_data);
 
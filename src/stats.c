@@ -0,0 +1,215 @@
+// fopen_s is only available with MSVC.
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "stats.h"
+
+#include "clock.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+struct Stats stats_create(void) {
+    return (struct Stats){
+        .sample_start_time = clock_get_time(),
+    };
+}
+
+void stats_add_frame(struct Stats *stats, double frame_time, size_t built_row_count, size_t upload_byte_count) {
+    stats->frame_times[stats->frame_time_count % STATS_FRAME_TIME_CAPACITY] = (float)frame_time;
+    stats->frame_time_count++;
+
+    stats->rendered_frame_count++;
+    stats->built_row_count += built_row_count;
+    stats->upload_byte_count += upload_byte_count;
+}
+
+void stats_add_input(struct Stats *stats, size_t input_byte_count, size_t pending_input_byte_count) {
+    stats->input_byte_count += input_byte_count;
+
+    if (pending_input_byte_count > stats->max_pending_input_byte_count) {
+        stats->max_pending_input_byte_count = pending_input_byte_count;
+    }
+}
+
+static int32_t stats_compare_frame_times(const void *a, const void *b) {
+    float frame_time_a = *(const float *)a;
+    float frame_time_b = *(const float *)b;
+
+    return (frame_time_a > frame_time_b) - (frame_time_a < frame_time_b);
+}
+
+void stats_add_mouse_reports(struct Stats *stats, uint32_t mouse_event_count, uint32_t mouse_report_count) {
+    stats->mouse_event_count += mouse_event_count;
+    stats->mouse_report_count += mouse_report_count;
+}
+
+void stats_add_scroll_frame(struct Stats *stats, double frame_time, size_t built_row_count) {
+    stats->scroll_frame_count++;
+    stats->scroll_frame_time += frame_time;
+    stats->scroll_built_row_count += built_row_count;
+}
+
+void stats_add_resize(struct Stats *stats, double resize_time) {
+    stats->resize_count++;
+    stats->resize_time += resize_time;
+}
+
+// Nearest rank percentile of sorted frame times, in milliseconds.
+static double stats_get_percentile(const float *frame_times, size_t frame_time_count, double percentile) {
+    if (frame_time_count == 0) {
+        return 0.0;
+    }
+
+    size_t i = (size_t)(percentile * (frame_time_count - 1) + 0.5);
+
+    return frame_times[i] * 1000.0;
+}
+
+struct StatsReport stats_sample(struct Stats *stats, size_t scrollback_line_count, size_t scrollback_byte_count) {
+    double current_time = clock_get_time();
+    double duration = current_time - stats->sample_start_time;
+    double inverse_duration = duration > 0.0 ? 1.0 / duration : 0.0;
+    double inverse_frame_count = stats->rendered_frame_count > 0 ? 1.0 / stats->rendered_frame_count : 0.0;
+    double inverse_scroll_frame_count = stats->scroll_frame_count > 0 ? 1.0 / stats->scroll_frame_count : 0.0;
+    double inverse_resize_count = stats->resize_count > 0 ? 1.0 / stats->resize_count : 0.0;
+
+    size_t frame_time_count = stats->frame_time_count;
+    if (frame_time_count > STATS_FRAME_TIME_CAPACITY) {
+        frame_time_count = STATS_FRAME_TIME_CAPACITY;
+    }
+
+    qsort(stats->frame_times, frame_time_count, sizeof(float), stats_compare_frame_times);
+
+    struct StatsReport report = {
+        .duration = duration,
+        .parsed_bytes_per_second = stats->parsed_byte_count * inverse_duration,
+        .frames_per_second = stats->rendered_frame_count * inverse_duration,
+        .skipped_frames_per_second = stats->skipped_frame_count * inverse_duration,
+        .built_rows_per_frame = stats->built_row_count * inverse_frame_count,
+        .upload_bytes_per_frame = stats->upload_byte_count * inverse_frame_count,
+        .input_bytes_per_second = stats->input_byte_count * inverse_duration,
+        .max_pending_input_byte_count = stats->max_pending_input_byte_count,
+        .mouse_events_per_second = stats->mouse_event_count * inverse_duration,
+        .mouse_reports_per_second = stats->mouse_report_count * inverse_duration,
+        .scroll_frames_per_second = stats->scroll_frame_count * inverse_duration,
+        .scroll_frame_time = stats->scroll_frame_time * 1000.0 * inverse_scroll_frame_count,
+        .scroll_built_rows_per_frame = stats->scroll_built_row_count * inverse_scroll_frame_count,
+        .resize_count = stats->resize_count,
+        .resize_time = stats->resize_time * 1000.0 * inverse_resize_count,
+        .reader_lock_wait_per_second = stats->reader_lock_wait_time * 1000.0 * inverse_duration,
+        .main_lock_wait_per_second = stats->main_lock_wait_time * 1000.0 * inverse_duration,
+        .frame_time_p50 = stats_get_percentile(stats->frame_times, frame_time_count, 0.5),
+        .frame_time_p99 = stats_get_percentile(stats->frame_times, frame_time_count, 0.99),
+        .scrollback_line_count = scrollback_line_count,
+        .scrollback_byte_count = scrollback_byte_count,
+    };
+
+    *stats = (struct Stats){
+        .sample_start_time = current_time,
+    };
+
+    return report;
+}
+
+size_t stats_report_format(struct StatsReport *report, char *text, size_t text_capacity) {
+    int32_t length = snprintf(
+        text,
+        text_capacity,
+        "parser   %.1f KiB/s\n"
+        "frames   %.1f/s, %.1f/s skipped\n"
+        "frame    p50 %.2f ms, p99 %.2f ms\n"
+        "rows     %.1f built/frame\n"
+        "upload   %.1f KiB/frame\n"
+        "input    %.1f B/s, %zu B max pending\n"
+        "mouse    %.1f events/s, %.1f reports/s\n"
+        "scroll   %.1f frames/s, %.2f ms/frame, %.1f rows/frame\n"
+        "resize   %" PRIu32 " resizes, %.2f ms/resize\n"
+        "lock     main %.2f ms/s, reader %.2f ms/s\n"
+        "history  %zu lines, %.1f MiB",
+        report->parsed_bytes_per_second / 1024.0,
+        report->frames_per_second,
+        report->skipped_frames_per_second,
+        report->frame_time_p50,
+        report->frame_time_p99,
+        report->built_rows_per_frame,
+        report->upload_bytes_per_frame / 1024.0,
+        report->input_bytes_per_second,
+        report->max_pending_input_byte_count,
+        report->mouse_events_per_second,
+        report->mouse_reports_per_second,
+        report->scroll_frames_per_second,
+        report->scroll_frame_time,
+        report->scroll_built_rows_per_frame,
+        report->resize_count,
+        report->resize_time,
+        report->main_lock_wait_per_second,
+        report->reader_lock_wait_per_second,
+        report->scrollback_line_count,
+        report->scrollback_byte_count / (1024.0 * 1024.0)
+    );
+
+    if (length < 0) {
+        return 0;
+    }
+
+    return (size_t)length < text_capacity ? (size_t)length : text_capacity - 1;
+}
+
+// Writes the report as JSON so that it can be attached to bug reports and read by scripts.
+bool stats_report_dump(struct StatsReport *report, const char *path) {
+    FILE *file = fopen(path, "w");
+
+    if (!file) {
+        return false;
+    }
+
+    fprintf(
+        file,
+        "{\n"
+        "    \"duration_s\": %f,\n"
+        "    \"parsed_bytes_per_s\": %f,\n"
+        "    \"frames_per_s\": %f,\n"
+        "    \"skipped_frames_per_s\": %f,\n"
+        "    \"frame_time_p50_ms\": %f,\n"
+        "    \"frame_time_p99_ms\": %f,\n"
+        "    \"built_rows_per_frame\": %f,\n"
+        "    \"upload_bytes_per_frame\": %f,\n"
+        "    \"input_bytes_per_s\": %f,\n"
+        "    \"max_pending_input_bytes\": %zu,\n"
+        "    \"mouse_events_per_s\": %f,\n"
+        "    \"mouse_reports_per_s\": %f,\n"
+        "    \"scroll_frames_per_s\": %f,\n"
+        "    \"scroll_frame_time_ms\": %f,\n"
+        "    \"scroll_built_rows_per_frame\": %f,\n"
+        "    \"resizes\": %" PRIu32 ",\n"
+        "    \"resize_time_ms\": %f,\n"
+        "    \"main_lock_wait_ms_per_s\": %f,\n"
+        "    \"reader_lock_wait_ms_per_s\": %f,\n"
+        "    \"scrollback_lines\": %zu,\n"
+        "    \"scrollback_bytes\": %zu\n"
+        "}\n",
+        report->duration,
+        report->parsed_bytes_per_second,
+        report->frames_per_second,
+        report->skipped_frames_per_second,
+        report->frame_time_p50,
+        report->frame_time_p99,
+        report->built_rows_per_frame,
+        report->upload_bytes_per_frame,
+        report->input_bytes_per_second,
+        report->max_pending_input_byte_count,
+        report->mouse_events_per_second,
+        report->mouse_reports_per_second,
+        report->scroll_frames_per_second,
+        report->scroll_frame_time,
+        report->scroll_built_rows_per_frame,
+        report->resize_count,
+        report->resize_time,
+        report->main_lock_wait_per_second,
+        report->reader_lock_wait_per_second,
+        report->scrollback_line_count,
+        report->scrollback_byte_count
+    );
+
+    return fclose(file) == 0;
+}
\ No newline at end of file
@@ -0,0 +1,81 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include "detect_leak.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <inttypes.h>
+
+// Frame times past this many per sample overwrite the oldest ones, percentiles are taken from what's left.
+#define STATS_FRAME_TIME_CAPACITY 1024
+#define STATS_DEFAULT_DUMP_PATH "term-stats.json"
+
+// Counters for the current sample, they're shared between the main thread and the reader so they're only touched
+// while holding the reader's lock.
+struct Stats {
+    double sample_start_time;
+
+    size_t parsed_byte_count;
+    uint32_t rendered_frame_count;
+    // Times the main loop woke up without anything to draw.
+    uint32_t skipped_frame_count;
+    size_t built_row_count;
+    size_t upload_byte_count;
+    size_t input_byte_count;
+    // The most input that was waiting to be written to the pty at once.
+    size_t max_pending_input_byte_count;
+    uint32_t mouse_event_count;
+    uint32_t mouse_report_count;
+    // Frames drawn while a scroll was animating, they're also counted as regular frames.
+    uint32_t scroll_frame_count;
+    double scroll_frame_time;
+    size_t scroll_built_row_count;
+    uint32_t resize_count;
+    double resize_time;
+    double reader_lock_wait_time;
+    double main_lock_wait_time;
+
+    float frame_times[STATS_FRAME_TIME_CAPACITY];
+    size_t frame_time_count;
+};
+
+// Rates are per second and times are in milliseconds.
+struct StatsReport {
+    double duration;
+    double parsed_bytes_per_second;
+    double frames_per_second;
+    double skipped_frames_per_second;
+    double built_rows_per_frame;
+    double upload_bytes_per_frame;
+    double input_bytes_per_second;
+    size_t max_pending_input_byte_count;
+    double mouse_events_per_second;
+    double mouse_reports_per_second;
+    double scroll_frames_per_second;
+    double scroll_frame_time;
+    double scroll_built_rows_per_frame;
+    uint32_t resize_count;
+    double resize_time;
+    double reader_lock_wait_per_second;
+    double main_lock_wait_per_second;
+    double frame_time_p50;
+    double frame_time_p99;
+    size_t scrollback_line_count;
+    size_t scrollback_byte_count;
+};
+
+struct Stats stats_create(void);
+void stats_add_frame(struct Stats *stats, double frame_time, size_t built_row_count, size_t upload_byte_count);
+void stats_add_input(struct Stats *stats, size_t input_byte_count, size_t pending_input_byte_count);
+// Mouse events are coalesced into fewer reports before they're written to the pty.
+void stats_add_mouse_reports(struct Stats *stats, uint32_t mouse_event_count, uint32_t mouse_report_count);
+void stats_add_scroll_frame(struct Stats *stats, double frame_time, size_t built_row_count);
+void stats_add_resize(struct Stats *stats, double resize_time);
+// Summarizes the counters since the last sample, then resets them.
+struct StatsReport stats_sample(struct Stats *stats, size_t scrollback_line_count, size_t scrollback_byte_count);
+// Formats the report as a few lines of text, returns the number of characters written.
+size_t stats_report_format(struct StatsReport *report, char *text, size_t text_capacity);
+bool stats_report_dump(struct StatsReport *report, const char *path);
+
+#endif
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include "text_buffer.h"
 
 #include <stdlib.h>
+#include <string.h>
+#include <wctype.h>
 #include <assert.h>
 
 struct TextBuffer text_buffer_create(void) {
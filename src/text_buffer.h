@@ -2,15 +2,24 @@
 #define DATA_H
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <inttypes.h>
 
+#ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
+#endif
 
 #define TEXT_BUFFER_CAPACITY 8192
 
 struct TextBuffer {
     char *data;
+    // The reader passes this straight to ReadFile, which needs a DWORD.
+#ifdef _WIN32
     DWORD length;
+#else
+    uint32_t length;
+#endif
     // The number of characters kept from the last read.
     size_t kept_length;
 };
@@ -0,0 +1,207 @@
+#include "thread.h"
+
+#include <stdlib.h>
+#include <assert.h>
+
+struct ThreadStartInfo {
+    void (*start)(void *data);
+    void *data;
+};
+
+#ifdef _WIN32
+static DWORD WINAPI thread_start(void *start_info) {
+    struct ThreadStartInfo info = *(struct ThreadStartInfo *)start_info;
+    free(start_info);
+
+    info.start(info.data);
+
+    return 0;
+}
+
+struct Thread thread_create(void (*start)(void *data), void *data) {
+    struct ThreadStartInfo *start_info = malloc(sizeof(struct ThreadStartInfo));
+    assert(start_info);
+
+    *start_info = (struct ThreadStartInfo){
+        .start = start,
+        .data = data,
+    };
+
+    HANDLE handle = CreateThread(NULL, 0, thread_start, start_info, 0, NULL);
+    assert(handle);
+
+    return (struct Thread){
+        .handle = handle,
+    };
+}
+
+void thread_join(struct Thread *thread) {
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+}
+
+uint32_t thread_get_processor_count(void) {
+    SYSTEM_INFO system_info;
+    GetSystemInfo(&system_info);
+
+    return system_info.dwNumberOfProcessors;
+}
+
+void mutex_init(struct Mutex *mutex) {
+    InitializeSRWLock(&mutex->lock);
+}
+
+void mutex_lock(struct Mutex *mutex) {
+    AcquireSRWLockExclusive(&mutex->lock);
+}
+
+void mutex_unlock(struct Mutex *mutex) {
+    ReleaseSRWLockExclusive(&mutex->lock);
+}
+
+void mutex_destroy(struct Mutex *mutex) {
+    // SRW locks don't own any resources.
+}
+
+void condition_variable_init(struct ConditionVariable *condition_variable) {
+    InitializeConditionVariable(&condition_variable->condition_variable);
+}
+
+void condition_variable_wait(struct ConditionVariable *condition_variable, struct Mutex *mutex) {
+    SleepConditionVariableSRW(&condition_variable->condition_variable, &mutex->lock, INFINITE, 0);
+}
+
+void condition_variable_signal(struct ConditionVariable *condition_variable) {
+    WakeConditionVariable(&condition_variable->condition_variable);
+}
+
+void condition_variable_broadcast(struct ConditionVariable *condition_variable) {
+    WakeAllConditionVariable(&condition_variable->condition_variable);
+}
+
+void condition_variable_destroy(struct ConditionVariable *condition_variable) {
+    // Condition variables don't own any resources.
+}
+
+void event_init(struct Event *event) {
+    event->handle = CreateEvent(NULL, false, false, NULL);
+    assert(event->handle);
+}
+
+void event_set(struct Event *event) {
+    SetEvent(event->handle);
+}
+
+void event_wait(struct Event *event) {
+    WaitForSingleObject(event->handle, INFINITE);
+}
+
+void event_destroy(struct Event *event) {
+    CloseHandle(event->handle);
+}
+#else
+#include <stdio.h>
+#include <unistd.h>
+
+static void *thread_start(void *start_info) {
+    struct ThreadStartInfo info = *(struct ThreadStartInfo *)start_info;
+    free(start_info);
+
+    info.start(info.data);
+
+    return NULL;
+}
+
+struct Thread thread_create(void (*start)(void *data), void *data) {
+    struct ThreadStartInfo *start_info = malloc(sizeof(struct ThreadStartInfo));
+    assert(start_info);
+
+    *start_info = (struct ThreadStartInfo){
+        .start = start,
+        .data = data,
+    };
+
+    struct Thread thread;
+    if (pthread_create(&thread.thread, NULL, thread_start, start_info) != 0) {
+        puts("Failed to create thread");
+        exit(-1);
+    }
+
+    return thread;
+}
+
+void thread_join(struct Thread *thread) {
+    pthread_join(thread->thread, NULL);
+}
+
+uint32_t thread_get_processor_count(void) {
+    long processor_count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return processor_count > 0 ? (uint32_t)processor_count : 1;
+}
+
+void mutex_init(struct Mutex *mutex) {
+    pthread_mutex_init(&mutex->mutex, NULL);
+}
+
+void mutex_lock(struct Mutex *mutex) {
+    pthread_mutex_lock(&mutex->mutex);
+}
+
+void mutex_unlock(struct Mutex *mutex) {
+    pthread_mutex_unlock(&mutex->mutex);
+}
+
+void mutex_destroy(struct Mutex *mutex) {
+    pthread_mutex_destroy(&mutex->mutex);
+}
+
+void condition_variable_init(struct ConditionVariable *condition_variable) {
+    pthread_cond_init(&condition_variable->condition_variable, NULL);
+}
+
+void condition_variable_wait(struct ConditionVariable *condition_variable, struct Mutex *mutex) {
+    pthread_cond_wait(&condition_variable->condition_variable, &mutex->mutex);
+}
+
+void condition_variable_signal(struct ConditionVariable *condition_variable) {
+    pthread_cond_signal(&condition_variable->condition_variable);
+}
+
+void condition_variable_broadcast(struct ConditionVariable *condition_variable) {
+    pthread_cond_broadcast(&condition_variable->condition_variable);
+}
+
+void condition_variable_destroy(struct ConditionVariable *condition_variable) {
+    pthread_cond_destroy(&condition_variable->condition_variable);
+}
+
+void event_init(struct Event *event) {
+    pthread_mutex_init(&event->mutex, NULL);
+    pthread_cond_init(&event->condition_variable, NULL);
+    event->is_set = false;
+}
+
+void event_set(struct Event *event) {
+    pthread_mutex_lock(&event->mutex);
+    event->is_set = true;
+    pthread_cond_signal(&event->condition_variable);
+    pthread_mutex_unlock(&event->mutex);
+}
+
+void event_wait(struct Event *event) {
+    pthread_mutex_lock(&event->mutex);
+
+    while (!event->is_set) {
+        pthread_cond_wait(&event->condition_variable, &event->mutex);
+    }
+
+    event->is_set = false;
+    pthread_mutex_unlock(&event->mutex);
+}
+
+void event_destroy(struct Event *event) {
+    pthread_cond_destroy(&event->condition_variable);
+    pthread_mutex_destroy(&event->mutex);
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,74 @@
+#ifndef THREAD_H
+#define THREAD_H
+
+#include "detect_leak.h"
+
+#include <stdbool.h>
+#include <inttypes.h>
+
+// The terminal itself only runs on Windows, other platforms are supported so that tools like the render benchmark
+// can run on them.
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+
+struct Thread {
+    HANDLE handle;
+};
+
+struct Mutex {
+    SRWLOCK lock;
+};
+
+struct ConditionVariable {
+    CONDITION_VARIABLE condition_variable;
+};
+
+// An auto-reset event, waiting on it consumes the signal.
+struct Event {
+    HANDLE handle;
+};
+#else
+#include <pthread.h>
+
+struct Thread {
+    pthread_t thread;
+};
+
+struct Mutex {
+    pthread_mutex_t mutex;
+};
+
+struct ConditionVariable {
+    pthread_cond_t condition_variable;
+};
+
+// An auto-reset event, waiting on it consumes the signal.
+struct Event {
+    pthread_mutex_t mutex;
+    pthread_cond_t condition_variable;
+    bool is_set;
+};
+#endif
+
+struct Thread thread_create(void (*start)(void *data), void *data);
+void thread_join(struct Thread *thread);
+uint32_t thread_get_processor_count(void);
+
+void mutex_init(struct Mutex *mutex);
+void mutex_lock(struct Mutex *mutex);
+void mutex_unlock(struct Mutex *mutex);
+void mutex_destroy(struct Mutex *mutex);
+
+void condition_variable_init(struct ConditionVariable *condition_variable);
+void condition_variable_wait(struct ConditionVariable *condition_variable, struct Mutex *mutex);
+void condition_variable_signal(struct ConditionVariable *condition_variable);
+void condition_variable_broadcast(struct ConditionVariable *condition_variable);
+void condition_variable_destroy(struct ConditionVariable *condition_variable);
+
+void event_init(struct Event *event);
+void event_set(struct Event *event);
+void event_wait(struct Event *event);
+void event_destroy(struct Event *event);
+
+#endif
\ No newline at end of file
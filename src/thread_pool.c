@@ -0,0 +1,224 @@
+#include "thread_pool.h"
+
+#include "trace.h"
+
+#include <stdlib.h>
+#include <assert.h>
+
+static bool thread_pool_take_task(struct ThreadPoolQueue *queue, size_t *task_i) {
+    bool has_task = false;
+
+    mutex_lock(&queue->mutex);
+
+    if (queue->start < queue->end) {
+        *task_i = queue->start;
+        queue->start++;
+        has_task = true;
+    }
+
+    mutex_unlock(&queue->mutex);
+
+    return has_task;
+}
+
+// Moves half of another queue's tasks into the thief's queue, except for the first one which is returned to be run
+// right away.
+static bool thread_pool_steal_task(struct ThreadPoolShared *shared, size_t thief_i, size_t *task_i) {
+    for (size_t offset = 1; offset < shared->queue_count; offset++) {
+        struct ThreadPoolQueue *victim = &shared->queues[(thief_i + offset) % shared->queue_count];
+
+        mutex_lock(&victim->mutex);
+
+        size_t stolen_count = (victim->end - victim->start + 1) / 2;
+        size_t stolen_start = victim->end - stolen_count;
+        victim->end = stolen_start;
+
+        mutex_unlock(&victim->mutex);
+
+        if (stolen_count == 0) {
+            continue;
+        }
+
+        struct ThreadPoolQueue *queue = &shared->queues[thief_i];
+
+        mutex_lock(&queue->mutex);
+        queue->start = stolen_start + 1;
+        queue->end = stolen_start + stolen_count;
+        mutex_unlock(&queue->mutex);
+
+        *task_i = stolen_start;
+
+        return true;
+    }
+
+    return false;
+}
+
+// Runs tasks until there are none left to take or steal, returns how many were run.
+static size_t thread_pool_work(struct ThreadPoolShared *shared, size_t worker_i) {
+    size_t completed_count = 0;
+    size_t task_i;
+
+    while (thread_pool_take_task(&shared->queues[worker_i], &task_i) ||
+           thread_pool_steal_task(shared, worker_i, &task_i)) {
+        shared->task(shared->data, task_i, worker_i);
+        completed_count++;
+    }
+
+    return completed_count;
+}
+
+static void thread_pool_complete_tasks(struct ThreadPoolShared *shared, size_t completed_count) {
+    shared->remaining_task_count -= completed_count;
+
+    if (shared->remaining_task_count == 0) {
+        condition_variable_broadcast(&shared->is_done);
+    }
+}
+
+static void thread_pool_worker_start(void *data) {
+    struct ThreadPoolWorker *worker = data;
+    struct ThreadPoolShared *shared = worker->shared;
+
+    uint32_t generation = 0;
+
+    TRACE_SET_THREAD_NAME("thread pool");
+
+    mutex_lock(&shared->mutex);
+
+    while (true) {
+        while (!shared->should_stop && shared->generation == generation) {
+            condition_variable_wait(&shared->has_work, &shared->mutex);
+        }
+
+        if (shared->should_stop) {
+            break;
+        }
+
+        generation = shared->generation;
+
+        mutex_unlock(&shared->mutex);
+        TRACE_BEGIN("work");
+        size_t completed_count = thread_pool_work(shared, worker->i);
+        TRACE_END();
+        mutex_lock(&shared->mutex);
+
+        thread_pool_complete_tasks(shared, completed_count);
+    }
+
+    mutex_unlock(&shared->mutex);
+}
+
+struct ThreadPool thread_pool_create(size_t thread_count) {
+    struct ThreadPoolShared *shared = malloc(sizeof(struct ThreadPoolShared));
+    assert(shared);
+
+    size_t queue_count = thread_count + 1;
+
+    *shared = (struct ThreadPoolShared){
+        .queues = malloc(queue_count * sizeof(struct ThreadPoolQueue)),
+        .workers = malloc(thread_count * sizeof(struct ThreadPoolWorker)),
+        .queue_count = queue_count,
+    };
+
+    struct ThreadPool thread_pool = (struct ThreadPool){
+        .shared = shared,
+        .threads = malloc(thread_count * sizeof(struct Thread)),
+        .thread_count = thread_count,
+    };
+
+    assert(shared->queues);
+    assert(thread_count == 0 || shared->workers);
+    assert(thread_count == 0 || thread_pool.threads);
+
+    mutex_init(&shared->mutex);
+    condition_variable_init(&shared->has_work);
+    condition_variable_init(&shared->is_done);
+
+    for (size_t i = 0; i < queue_count; i++) {
+        shared->queues[i] = (struct ThreadPoolQueue){0};
+        mutex_init(&shared->queues[i].mutex);
+    }
+
+    for (size_t i = 0; i < thread_count; i++) {
+        shared->workers[i] = (struct ThreadPoolWorker){
+            .shared = shared,
+            .i = i,
+        };
+
+        thread_pool.threads[i] = thread_create(thread_pool_worker_start, &shared->workers[i]);
+    }
+
+    return thread_pool;
+}
+
+void thread_pool_run(struct ThreadPool *thread_pool, size_t task_count, ThreadPoolTask task, void *data) {
+    struct ThreadPoolShared *shared = thread_pool->shared;
+
+    if (task_count == 0) {
+        return;
+    }
+
+    mutex_lock(&shared->mutex);
+
+    shared->task = task;
+    shared->data = data;
+    shared->remaining_task_count = task_count;
+
+    for (size_t i = 0; i < shared->queue_count; i++) {
+        struct ThreadPoolQueue *queue = &shared->queues[i];
+
+        mutex_lock(&queue->mutex);
+        queue->start = task_count * i / shared->queue_count;
+        queue->end = task_count * (i + 1) / shared->queue_count;
+        mutex_unlock(&queue->mutex);
+    }
+
+    shared->generation++;
+    condition_variable_broadcast(&shared->has_work);
+
+    mutex_unlock(&shared->mutex);
+
+    // The calling thread uses the last queue.
+    size_t completed_count = thread_pool_work(shared, shared->queue_count - 1);
+
+    mutex_lock(&shared->mutex);
+
+    thread_pool_complete_tasks(shared, completed_count);
+
+    while (shared->remaining_task_count > 0) {
+        condition_variable_wait(&shared->is_done, &shared->mutex);
+    }
+
+    mutex_unlock(&shared->mutex);
+}
+
+size_t thread_pool_get_worker_count(struct ThreadPool *thread_pool) {
+    return thread_pool->shared->queue_count;
+}
+
+void thread_pool_destroy(struct ThreadPool *thread_pool) {
+    struct ThreadPoolShared *shared = thread_pool->shared;
+
+    mutex_lock(&shared->mutex);
+    shared->should_stop = true;
+    condition_variable_broadcast(&shared->has_work);
+    mutex_unlock(&shared->mutex);
+
+    for (size_t i = 0; i < thread_pool->thread_count; i++) {
+        thread_join(&thread_pool->threads[i]);
+    }
+
+    for (size_t i = 0; i < shared->queue_count; i++) {
+        mutex_destroy(&shared->queues[i].mutex);
+    }
+
+    mutex_destroy(&shared->mutex);
+    condition_variable_destroy(&shared->has_work);
+    condition_variable_destroy(&shared->is_done);
+
+    free(shared->queues);
+    free(shared->workers);
+    free(shared);
+    free(thread_pool->threads);
+}
\ No newline at end of file
@@ -0,0 +1,64 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include "detect_leak.h"
+
+#include "thread.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <inttypes.h>
+
+// Runs a task on a thread from the pool. The worker index is unique among the threads running the same batch, so it
+// can be used to pick per-thread scratch data.
+typedef void (*ThreadPoolTask)(void *data, size_t task_i, size_t worker_i);
+
+// Task indices that are waiting to run, the owner takes them from the start and thieves take from the end.
+struct ThreadPoolQueue {
+    struct Mutex mutex;
+    size_t start;
+    size_t end;
+};
+
+struct ThreadPoolWorker {
+    struct ThreadPoolShared *shared;
+    size_t i;
+};
+
+// State shared with the worker threads, allocated separately so that it doesn't move when the pool is copied.
+struct ThreadPoolShared {
+    struct Mutex mutex;
+    struct ConditionVariable has_work;
+    struct ConditionVariable is_done;
+
+    ThreadPoolTask task;
+    void *data;
+    // Changes whenever a batch starts, so waiting workers can tell a new batch from a spurious wake up.
+    uint32_t generation;
+    size_t remaining_task_count;
+
+    // One queue per worker thread, plus one for the thread that runs the batch, which works on it too.
+    struct ThreadPoolQueue *queues;
+    struct ThreadPoolWorker *workers;
+    size_t queue_count;
+
+    bool should_stop;
+};
+
+// Each batch of tasks is split evenly between the threads' queues. Threads that run out of tasks steal half of the
+// remaining tasks from another queue, so batches with uneven tasks still keep every thread busy.
+struct ThreadPool {
+    struct ThreadPoolShared *shared;
+    struct Thread *threads;
+    size_t thread_count;
+};
+
+struct ThreadPool thread_pool_create(size_t thread_count);
+// Runs tasks 0 to task_count - 1 and returns once all of them are finished. Tasks may run in any order and on any
+// thread, including the calling thread.
+void thread_pool_run(struct ThreadPool *thread_pool, size_t task_count, ThreadPoolTask task, void *data);
+// The number of threads that can run a batch, including the calling thread.
+size_t thread_pool_get_worker_count(struct ThreadPool *thread_pool);
+void thread_pool_destroy(struct ThreadPool *thread_pool);
+
+#endif
\ No newline at end of file
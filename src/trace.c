@@ -0,0 +1,238 @@
+// fopen_s is only available with MSVC.
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "trace.h"
+
+#include "clock.h"
+#include "thread.h"
+#include "atomic.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <inttypes.h>
+
+#ifdef _MSC_VER
+#define TRACE_THREAD_LOCAL __declspec(thread)
+#else
+#define TRACE_THREAD_LOCAL _Thread_local
+#endif
+
+enum TraceEventType {
+    TRACE_EVENT_TYPE_BEGIN,
+    TRACE_EVENT_TYPE_END,
+};
+
+struct TraceEvent {
+    const char *name;
+    double time;
+    enum TraceEventType type;
+};
+
+// Only its own thread writes to a buffer. The write count is published after each event is written, so the buffer
+// can be read without stopping the thread.
+struct TraceBuffer {
+    struct TraceEvent events[TRACE_BUFFER_CAPACITY];
+    uint64_t write_count;
+
+    const char *thread_name;
+    uint32_t thread_id;
+    struct TraceBuffer *next;
+};
+
+static bool trace_is_enabled;
+static double trace_start_time;
+
+// Protects the list of buffers, which only changes when a thread records its first event.
+static struct Mutex trace_mutex;
+static struct TraceBuffer *trace_buffers;
+static uint32_t trace_thread_count;
+
+static TRACE_THREAD_LOCAL struct TraceBuffer *trace_thread_buffer;
+
+bool trace_start(void) {
+#ifdef TERM_TRACE
+    mutex_init(&trace_mutex);
+    trace_start_time = clock_get_time();
+    trace_is_enabled = true;
+
+    return true;
+#else
+    return false;
+#endif
+}
+
+static struct TraceBuffer *trace_get_thread_buffer(void) {
+    if (trace_thread_buffer) {
+        return trace_thread_buffer;
+    }
+
+    struct TraceBuffer *buffer = malloc(sizeof(struct TraceBuffer));
+    assert(buffer);
+
+    buffer->write_count = 0;
+    buffer->thread_name = NULL;
+
+    mutex_lock(&trace_mutex);
+    buffer->thread_id = trace_thread_count;
+    buffer->next = trace_buffers;
+    trace_buffers = buffer;
+    trace_thread_count++;
+    mutex_unlock(&trace_mutex);
+
+    trace_thread_buffer = buffer;
+
+    return buffer;
+}
+
+static void trace_push_event(const char *name, enum TraceEventType type) {
+    if (!trace_is_enabled) {
+        return;
+    }
+
+    struct TraceBuffer *buffer = trace_get_thread_buffer();
+    uint64_t write_count = buffer->write_count;
+
+    buffer->events[write_count % TRACE_BUFFER_CAPACITY] = (struct TraceEvent){
+        .name = name,
+        .time = clock_get_time(),
+        .type = type,
+    };
+
+    atomic_store_release_uint64(&buffer->write_count, write_count + 1);
+}
+
+void trace_begin(const char *name) {
+    trace_push_event(name, TRACE_EVENT_TYPE_BEGIN);
+}
+
+void trace_end(void) {
+    trace_push_event(NULL, TRACE_EVENT_TYPE_END);
+}
+
+void trace_set_thread_name(const char *name) {
+    if (!trace_is_enabled) {
+        return;
+    }
+
+    trace_get_thread_buffer()->thread_name = name;
+}
+
+static void trace_write_buffer(FILE *file, struct TraceBuffer *buffer, struct TraceEvent *events, bool *is_first) {
+    uint64_t end = atomic_load_acquire_uint64(&buffer->write_count);
+    uint64_t start = end > TRACE_BUFFER_CAPACITY ? end - TRACE_BUFFER_CAPACITY : 0;
+
+    for (uint64_t i = start; i < end; i++) {
+        events[i - start] = buffer->events[i % TRACE_BUFFER_CAPACITY];
+    }
+
+    // Events written while copying may have replaced the oldest copied ones. The slot after the last published event
+    // may be half written too, it's the same slot as the oldest event that's still in the buffer.
+    uint64_t new_end = atomic_load_acquire_uint64(&buffer->write_count);
+    uint64_t valid_start = new_end + 1 > TRACE_BUFFER_CAPACITY ? new_end + 1 - TRACE_BUFFER_CAPACITY : 0;
+    if (valid_start < start) {
+        valid_start = start;
+    }
+
+    if (valid_start > end) {
+        valid_start = end;
+    }
+
+    if (buffer->thread_name) {
+        fprintf(
+            file,
+            "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%" PRIu32 ",\"args\":{\"name\":\"%s\"}}",
+            *is_first ? "" : ",",
+            buffer->thread_id,
+            buffer->thread_name
+        );
+        *is_first = false;
+    }
+
+    // The start of the ring may be in the middle of a span, ends without a matching begin are dropped.
+    uint32_t depth = 0;
+
+    for (uint64_t i = valid_start; i < end; i++) {
+        struct TraceEvent *event = &events[i - start];
+        double timestamp = (event->time - trace_start_time) * 1000000.0;
+
+        if (event->type == TRACE_EVENT_TYPE_BEGIN) {
+            fprintf(
+                file,
+                "%s\n{\"name\":\"%s\",\"ph\":\"B\",\"pid\":1,\"tid\":%" PRIu32 ",\"ts\":%.3f}",
+                *is_first ? "" : ",",
+                event->name,
+                buffer->thread_id,
+                timestamp
+            );
+            depth++;
+        } else if (depth > 0) {
+            fprintf(
+                file,
+                "%s\n{\"ph\":\"E\",\"pid\":1,\"tid\":%" PRIu32 ",\"ts\":%.3f}",
+                *is_first ? "" : ",",
+                buffer->thread_id,
+                timestamp
+            );
+            depth--;
+        } else {
+            continue;
+        }
+
+        *is_first = false;
+    }
+}
+
+bool trace_write(const char *path) {
+    if (!trace_is_enabled) {
+        return false;
+    }
+
+    FILE *file = fopen(path, "w");
+
+    if (!file) {
+        return false;
+    }
+
+    struct TraceEvent *events = malloc(TRACE_BUFFER_CAPACITY * sizeof(struct TraceEvent));
+    assert(events);
+
+    fputs("{\"traceEvents\":[", file);
+
+    bool is_first = true;
+
+    mutex_lock(&trace_mutex);
+
+    for (struct TraceBuffer *buffer = trace_buffers; buffer; buffer = buffer->next) {
+        trace_write_buffer(file, buffer, events, &is_first);
+    }
+
+    mutex_unlock(&trace_mutex);
+
+    fputs("\n],\"displayTimeUnit\":\"ms\"}\n", file);
+
+    free(events);
+
+    return fclose(file) == 0;
+}
+
+// Other threads have to be done recording before their buffers are freed.
+void trace_destroy(void) {
+    if (!trace_is_enabled) {
+        return;
+    }
+
+    trace_is_enabled = false;
+
+    struct TraceBuffer *buffer = trace_buffers;
+
+    while (buffer) {
+        struct TraceBuffer *next = buffer->next;
+        free(buffer);
+        buffer = next;
+    }
+
+    trace_buffers = NULL;
+    trace_thread_count = 0;
+    mutex_destroy(&trace_mutex);
+}
\ No newline at end of file
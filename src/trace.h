@@ -0,0 +1,34 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "detect_leak.h"
+
+#include <stdbool.h>
+
+// Spans are recorded into a ring buffer per thread, then written out in the Chrome trace event format which can be
+// opened with chrome://tracing or ui.perfetto.dev. Without TERM_TRACE the macros compile to nothing, otherwise they
+// cost a check of a global flag until tracing is started.
+// Span names must be string literals, only the pointers are stored.
+#ifdef TERM_TRACE
+#define TRACE_BEGIN(name) trace_begin(name)
+#define TRACE_END() trace_end()
+#define TRACE_SET_THREAD_NAME(name) trace_set_thread_name(name)
+#else
+#define TRACE_BEGIN(name)
+#define TRACE_END()
+#define TRACE_SET_THREAD_NAME(name)
+#endif
+
+// Events past this many per thread overwrite the oldest ones, so a trace keeps the last few seconds of each thread.
+#define TRACE_BUFFER_CAPACITY 65536
+
+// Returns false if tracing was compiled out.
+bool trace_start(void);
+void trace_begin(const char *name);
+void trace_end(void);
+void trace_set_thread_name(const char *name);
+// Can be called while other threads are still recording, events they overwrite while it runs are left out.
+bool trace_write(const char *path);
+void trace_destroy(void);
+
+#endif
\ No newline at end of file
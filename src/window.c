@@ -2,16 +2,29 @@
 
 #include "GLFW/glfw3.h"
 #include "font.h"
-#include "pseudo_console.h"
 #include "grid.h"
+#include "thread.h"
+#include "atomic.h"
 #include "graphics/renderer.h"
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <math.h>
 
 const float min_zoom_level = 1;
 const float max_zoom_level = 4;
 
+// Selections with at least this many cells are turned into text on their own thread.
+#define WINDOW_COPY_THREAD_MIN_CELL_COUNT (1024 * 1024)
+
+// GLFW's clipboard can only be used from the main thread, so it gets the text once the copy thread is done.
+struct WindowCopy {
+    struct GridTextSnapshot snapshot;
+    char *text;
+    uint64_t is_done;
+    struct Thread thread;
+};
+
 static void framebuffer_size_callback(GLFWwindow *glfw_window, int32_t width, int32_t height) {
     if (width == 0 && height == 0) {
         // The window is being minimized, don't change the size to 0 because
@@ -32,53 +45,62 @@ static void focused_callback(GLFWwindow *glfw_window, int32_t is_focused) {
     struct Window *window = glfwGetWindowUserPointer(glfw_window);
 
     window->is_focused = is_focused;
-    renderer_on_row_changed(window->renderer, window->grid->cursor_y);
+    // The cursor is only drawn while focused.
+    window->renderer->needs_redraw = true;
 }
 
-static void window_copy_selection(struct Window *window) {
-    list_reset_char(&window->copied_chars);
+static void window_copy_thread_start(void *data) {
+    struct WindowCopy *copy = data;
 
-    struct Selection sorted_selection = selection_sorted(&window->renderer->selection);
+    copy->text = grid_text_snapshot_to_utf8(&copy->snapshot, NULL);
+    atomic_store_release_uint64(&copy->is_done, true);
 
-    for (int32_t y = sorted_selection.start_y; y <= sorted_selection.end_y; y++) {
-        int32_t row_start_x = 0;
+    // Wakes up the main loop so it can put the text on the clipboard.
+    glfwPostEmptyEvent();
+}
 
-        if (y == sorted_selection.start_y) {
-            row_start_x = sorted_selection.start_x;
-        }
+// Waits for the copy thread if it isn't done yet.
+static void window_finish_copy(struct Window *window) {
+    struct WindowCopy *copy = window->copy;
 
-        int32_t row_end_x = window->grid->width - 1;
+    thread_join(&copy->thread);
+    glfwSetClipboardString(window->glfw_window, copy->text);
 
-        if (y == sorted_selection.end_y) {
-            row_end_x = sorted_selection.end_x;
-        }
+    free(copy->text);
+    grid_text_snapshot_destroy(&copy->snapshot);
+    free(copy);
+    window->copy = NULL;
+}
 
-        for (int32_t x = row_start_x; x <= row_end_x; x++) {
-            char grid_char = ' ';
+static void window_copy_selection(struct Window *window) {
+    if (window->copy) {
+        window_finish_copy(window);
+    }
 
-            if (y < 0) {
-                int32_t scrollback_y = window->grid->scrollback_lines.length + y;
-                struct ScrollbackLine *scrollback_line = &window->grid->scrollback_lines.data[scrollback_y];
+    struct Selection sorted_selection = selection_sorted(&window->renderer->selection);
+    struct GridTextSnapshot snapshot = grid_text_snapshot_create(window->grid, &sorted_selection);
 
-                if (x < scrollback_line->length) {
-                    grid_char = scrollback_line->data[x];
-                }
-            } else {
-                grid_char = window->grid->data[y * window->grid->width + x];
-            }
+    renderer_clear_selection(window->renderer);
 
-            list_push_char(&window->copied_chars, grid_char);
-        }
+    if (snapshot.cell_count < WINDOW_COPY_THREAD_MIN_CELL_COUNT) {
+        char *text = grid_text_snapshot_to_utf8(&snapshot, NULL);
+        glfwSetClipboardString(window->glfw_window, text);
 
-        if (y < sorted_selection.end_y) {
-            list_push_char(&window->copied_chars, '\n');
-        }
+        free(text);
+        grid_text_snapshot_destroy(&snapshot);
+
+        return;
     }
 
-    renderer_clear_selection(window->renderer);
+    struct WindowCopy *copy = malloc(sizeof(struct WindowCopy));
+    assert(copy);
 
-    list_push_char(&window->copied_chars, '\0');
-    glfwSetClipboardString(window->glfw_window, window->copied_chars.data);
+    *copy = (struct WindowCopy){
+        .snapshot = snapshot,
+    };
+    copy->thread = thread_create(window_copy_thread_start, copy);
+
+    window->copy = copy;
 }
 
 static void key_callback(GLFWwindow *glfw_window, int32_t key, int32_t scancode, int32_t action, int32_t mods) {
@@ -141,6 +163,23 @@ static void key_callback(GLFWwindow *glfw_window, int32_t key, int32_t scancode,
             write_char = 'F';
             break;
         }
+        case GLFW_KEY_INSERT: {
+            if (mods & GLFW_MOD_SHIFT) {
+                window->did_request_paste = true;
+            }
+
+            return;
+        }
+        case GLFW_KEY_F12: {
+            if (mods & GLFW_MOD_SHIFT) {
+                window->did_request_stats_dump = true;
+            } else {
+                window->is_stats_hud_visible = !window->is_stats_hud_visible;
+                window->did_toggle_stats_hud = true;
+            }
+
+            return;
+        }
         default: {
             needs_write = false;
             break;
@@ -158,7 +197,14 @@ static void key_callback(GLFWwindow *glfw_window, int32_t key, int32_t scancode,
         return;
     }
 
+    if (is_ctrl_pressed && is_shift_pressed && key == GLFW_KEY_V) {
+        window->did_request_paste = true;
+        return;
+    }
+
     if (needs_write) {
+        window->did_type = true;
+
         if (is_key_cursor) {
             list_push_uint8_t(&window->typed_chars, '\x1b');
             list_push_uint8_t(&window->typed_chars, '[');
@@ -236,6 +282,7 @@ static void key_callback(GLFWwindow *glfw_window, int32_t key, int32_t scancode,
     }
 
     list_push_uint8_t(&window->typed_chars, key_char);
+    window->did_type = true;
 }
 
 static void list_push_digits(struct List_uint8_t *list, uint32_t x) {
@@ -286,6 +333,11 @@ static void send_mouse_input_normal(struct Window *window, uint8_t encoded_butto
 }
 
 static void send_mouse_input(struct Window *window, int32_t button, int32_t action, int32_t mods, bool is_motion) {
+    window->reported_mouse_tile_x = window->mouse_tile_x;
+    window->reported_mouse_tile_y = window->mouse_tile_y;
+    window->reported_mouse_button = button;
+    window->mouse_report_count++;
+
     uint8_t encoded_button = button;
     if (mods & GLFW_MOD_SHIFT) {
         encoded_button += 4;
@@ -308,6 +360,43 @@ static void send_mouse_input(struct Window *window, int32_t button, int32_t acti
     send_mouse_input_normal(window, encoded_button, action, mods);
 }
 
+// High rate mice and trackpads send many events per frame. Only the last motion is reported, and only if it's in a
+// different cell or has a different button held than the last report. Wheel deltas are summed and sent as one report
+// per whole step, trackpads that scroll by fractions of a step keep the remainder for later.
+void window_flush_mouse_reports(struct Window *window) {
+    if (window->has_pending_mouse_motion) {
+        window->has_pending_mouse_motion = false;
+
+        bool is_same_cell = window->mouse_tile_x == window->reported_mouse_tile_x &&
+                            window->mouse_tile_y == window->reported_mouse_tile_y &&
+                            window->pending_mouse_motion_button == window->reported_mouse_button;
+
+        if (!is_same_cell) {
+            send_mouse_input(window, window->pending_mouse_motion_button, GLFW_PRESS, 0, true);
+        }
+    }
+
+    while (window->pending_mouse_scroll >= 1.0) {
+        send_mouse_input(window, 64, GLFW_PRESS, 0, false);
+        window->pending_mouse_scroll -= 1.0;
+    }
+
+    while (window->pending_mouse_scroll <= -1.0) {
+        send_mouse_input(window, 65, GLFW_PRESS, 0, false);
+        window->pending_mouse_scroll += 1.0;
+    }
+}
+
+// The row under the mouse, taking into account that rows are shifted down while scrolled by part of a row. That can
+// put the partially visible row above the screen under the mouse, which is row -1.
+static int32_t window_get_mouse_row(struct Window *window) {
+    // The renderer's scroll offset is in unscaled pixels.
+    double unscaled_mouse_y = window->mouse_y / window->scale;
+    int32_t row = (int32_t)floor((unscaled_mouse_y - window->renderer->scroll_offset) / FONT_GLYPH_HEIGHT);
+
+    return int32_clamp(row, -1, window->grid->height - 1);
+}
+
 static void mouse_button_callback(GLFWwindow *glfw_window, int32_t button, int32_t action, int32_t mods) {
     struct Window *window = glfwGetWindowUserPointer(glfw_window);
     input_update_button(&window->input, button, action);
@@ -316,13 +405,22 @@ static void mouse_button_callback(GLFWwindow *glfw_window, int32_t button, int32
 
     if (mouse_mode == GRID_MOUSE_MODE_NONE) {
         if (input_is_button_pressed(&window->input, GLFW_MOUSE_BUTTON_LEFT)) {
-            renderer_set_selection_start(window->renderer, window->mouse_tile_x - 1, window->mouse_tile_y - 1);
+            renderer_set_selection_start(
+                window->renderer,
+                window->grid,
+                window->mouse_tile_x - 1,
+                window_get_mouse_row(window)
+            );
         }
 
         return;
     }
 
+    window->mouse_event_count++;
+
     if (button >= 0 && button <= 2) {
+        // Held reports are sent first to keep them in order.
+        window_flush_mouse_reports(window);
         send_mouse_input(window, button, action, mods, false);
         return;
     }
@@ -339,12 +437,18 @@ static void mouse_move_callback(GLFWwindow *glfw_window, double mouse_x, double
 
     window->mouse_tile_x = mouse_tile_x;
     window->mouse_tile_y = mouse_tile_y;
+    window->mouse_y = mouse_y;
 
     enum GridMouseMode mouse_mode = grid_get_mouse_mode(window->grid);
 
     if (mouse_mode == GRID_MOUSE_MODE_NONE) {
         if (input_is_button_held(&window->input, GLFW_MOUSE_BUTTON_LEFT)) {
-            renderer_set_selection_end(window->renderer, window->mouse_tile_x - 1, window->mouse_tile_y - 1);
+            renderer_set_selection_end(
+                window->renderer,
+                window->grid,
+                window->mouse_tile_x - 1,
+                window_get_mouse_row(window)
+            );
         }
 
         return;
@@ -367,36 +471,32 @@ static void mouse_move_callback(GLFWwindow *glfw_window, double mouse_x, double
         return;
     }
 
-    send_mouse_input(window, button, GLFW_PRESS, 0, true);
+    // Replaces the motion that's waiting to be reported, if there is one.
+    window->mouse_event_count++;
+    window->has_pending_mouse_motion = true;
+    window->pending_mouse_motion_button = button;
 }
 
 static void mouse_scroll_callback(GLFWwindow *glfw_window, double scroll_x, double scroll_y) {
     struct Window *window = glfwGetWindowUserPointer(glfw_window);
 
     if (grid_get_mouse_mode(window->grid) == GRID_MOUSE_MODE_NONE) {
-        const int32_t scroll_distance = 3;
+        // Wheels report whole steps and trackpads report fractions of a step, both are scrolled by the pixel.
+        const float lines_per_step = 3.0f;
 
-        for (int32_t i = 0; i < scroll_distance; i++) {
-            if (scroll_y < 0) {
-                renderer_scroll_down(window->renderer, false);
-            } else if (scroll_y > 0) {
-                renderer_scroll_up(window->renderer, window->grid);
-            }
-        }
+        renderer_scroll_by(window->renderer, (float)scroll_y * lines_per_step * FONT_GLYPH_HEIGHT);
 
         return;
     }
 
-    if (scroll_y < 0) {
-        send_mouse_input(window, 65, GLFW_PRESS, 0, false);
-    } else if (scroll_y > 0) {
-        send_mouse_input(window, 64, GLFW_PRESS, 0, false);
-    }
+    window->mouse_event_count++;
+    window->pending_mouse_scroll += scroll_y;
 }
 
 static void character_callback(GLFWwindow *glfw_window, uint32_t codepoint) {
     struct Window *window = glfwGetWindowUserPointer(glfw_window);
     list_push_uint8_t(&window->typed_chars, (uint8_t)codepoint);
+    window->did_type = true;
 }
 
 struct Window window_create(char *title, int32_t width, int32_t height) {
@@ -431,7 +531,6 @@ struct Window window_create(char *title, int32_t width, int32_t height) {
         .glfw_window = glfw_window,
         .input = input_create(),
         .typed_chars = list_create_uint8_t(16),
-        .copied_chars = list_create_char(16),
         .width = width,
         .height = height,
         .scale = 1.0f,
@@ -474,12 +573,19 @@ void window_setup(struct Window *window, struct Grid *grid, struct Renderer *ren
 void window_update(struct Window *window) {
     input_update(&window->input);
 
+    if (window->copy && atomic_load_acquire_uint64(&window->copy->is_done)) {
+        window_finish_copy(window);
+    }
+
     if (window->typed_chars.length > 0) {
         renderer_scroll_reset(window->renderer);
         renderer_clear_selection(window->renderer);
     }
 
     list_reset_uint8_t(&window->typed_chars);
+    window->did_type = false;
+    window->mouse_event_count = 0;
+    window->mouse_report_count = 0;
 }
 
 void window_set_title(struct Window *window, char *title) {
@@ -491,9 +597,12 @@ void window_swap_buffers(struct Window *window) {
 }
 
 void window_destroy(struct Window *window) {
+    if (window->copy) {
+        window_finish_copy(window);
+    }
+
     input_destroy(&window->input);
     list_destroy_uint8_t(&window->typed_chars);
-    list_destroy_char(&window->copied_chars);
 
     glfwTerminate();
 }
\ No newline at end of file
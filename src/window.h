@@ -15,9 +15,7 @@
 struct PseudoConsole;
 struct Grid;
 struct Renderer;
-
-LIST_DEFINE(uint8_t)
-LIST_DEFINE(char)
+struct WindowCopy;
 
 struct Window {
     GLFWwindow *glfw_window;
@@ -28,6 +26,14 @@ struct Window {
     bool did_resize;
     bool is_visible;
     bool is_focused;
+    // F12 toggles the stats HUD and shift + F12 requests a stats dump, they're handled by the main loop.
+    bool is_stats_hud_visible;
+    bool did_toggle_stats_hud;
+    bool did_request_stats_dump;
+    // Ctrl + shift + V and shift + insert request a paste, the main loop reads the clipboard and hands it to the pty
+    // writer. Typing cancels a paste that's still being written.
+    bool did_request_paste;
+    bool did_type;
 
     struct Input input;
     // TODO: Move to input struct:
@@ -35,7 +41,23 @@ struct Window {
     struct List_uint8_t typed_chars;
     uint32_t mouse_tile_x;
     uint32_t mouse_tile_y;
-    struct List_char copied_chars;
+    double mouse_y;
+
+    // Motion and wheel reports are held until the end of each poll, see window_flush_mouse_reports.
+    bool has_pending_mouse_motion;
+    int32_t pending_mouse_motion_button;
+    double pending_mouse_scroll;
+    // Where the last report was sent from, motion that stays in the same cell isn't reported.
+    uint32_t reported_mouse_tile_x;
+    uint32_t reported_mouse_tile_y;
+    int32_t reported_mouse_button;
+    // Mouse events received while the application wants reports, and the reports they were coalesced into. They're
+    // counted until the next window_update, for the stats.
+    uint32_t mouse_event_count;
+    uint32_t mouse_report_count;
+
+    // Large selections are turned into text on another thread, this is the copy that's in progress if there is one.
+    struct WindowCopy *copy;
 
     struct Grid *grid;
     struct Renderer *renderer;
@@ -44,6 +66,8 @@ struct Window {
 struct Window window_create(char *title, int32_t width, int32_t height);
 void window_show(struct Window *window);
 void window_setup(struct Window *window, struct Grid *grid, struct Renderer *renderer);
+// Sends the motion and wheel reports that were held during the poll, call it after polling events.
+void window_flush_mouse_reports(struct Window *window);
 void window_update(struct Window *window);
 void window_set_title(struct Window *window, char *title);
 void window_swap_buffers(struct Window *window);
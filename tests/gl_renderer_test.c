@@ -0,0 +1,168 @@
+// Draws the test scene with the GL renderer, reads it back and compares it against what the software renderer draws
+// for the same grid. The software renderer doesn't depend on the vertex format or the shaders, so this catches
+// changes to either that move or recolor pixels. It needs an offscreen context from OSMesa and skips without one.
+//
+// Usage: term-gl-renderer-test
+
+#include "test_image.h"
+#include "test_scene.h"
+
+#include "window.h"
+#include "font.h"
+#include "graphics/renderer.h"
+#include "graphics/software_renderer.h"
+
+#include <embedded_assets.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+// Tells CTest that the test was skipped rather than failed.
+#define TEST_SKIP_EXIT_CODE 77
+#define TEST_ACTUAL_PATH "gl_renderer_actual.ppm"
+#define TEST_EXPECTED_PATH "gl_renderer_expected.ppm"
+
+static const enum GridCursorStyle test_cursor_styles[] = {
+    GRID_CURSOR_STYLE_BLOCK,
+    GRID_CURSOR_STYLE_UNDERLINE,
+    GRID_CURSOR_STYLE_BAR,
+};
+
+// window_create exits when it can't create a context, so check that one can be created first.
+static bool test_can_create_context(void) {
+    if (!glfwInit()) {
+        return false;
+    }
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+    GLFWwindow *glfw_window = glfwCreateWindow(1, 1, "term-gl-renderer-test", NULL, NULL);
+    if (!glfw_window) {
+        return false;
+    }
+
+    glfwDestroyWindow(glfw_window);
+
+    return true;
+}
+
+// Returns the framebuffer with the top row first, the same as the software renderer's.
+static uint8_t *test_read_framebuffer(int32_t width, int32_t height) {
+    size_t row_size = (size_t)width * 4;
+    uint8_t *pixels = malloc(row_size * height);
+    uint8_t *flipped_pixels = malloc(row_size * height);
+    assert(pixels);
+    assert(flipped_pixels);
+
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+
+    for (int32_t y = 0; y < height; y++) {
+        memcpy(flipped_pixels + row_size * y, pixels + row_size * (height - 1 - y), row_size);
+    }
+
+    free(pixels);
+
+    return flipped_pixels;
+}
+
+static bool test_draw_scene(struct Window *window, enum GridCursorStyle cursor_style, struct Selection selection) {
+    struct Renderer renderer = renderer_create(TEST_SCENE_WIDTH, TEST_SCENE_HEIGHT, 1);
+    renderer_resize_viewport(&renderer, window->width, window->height);
+
+    struct Grid grid = grid_create(
+        TEST_SCENE_WIDTH,
+        TEST_SCENE_HEIGHT,
+        &renderer,
+        renderer_on_row_changed_callback,
+        renderer_on_cursor_changed_callback
+    );
+    test_scene_fill(&grid, cursor_style);
+
+    // Nothing is in the scrollback, so screen rows and absolute lines are the same.
+    renderer_set_selection_start(&renderer, &grid, selection.start_x, selection.start_y);
+    renderer_set_selection_end(&renderer, &grid, selection.end_x, selection.end_y);
+
+    renderer_update_glyph_cache(&renderer);
+    renderer_draw(&renderer, &grid, renderer.viewport_height, window);
+    glFinish();
+
+    // OSMesa contexts are single buffered, so what was drawn is still there after the swap.
+    uint8_t *pixels = test_read_framebuffer(window->width, window->height);
+
+    int32_t expected_width;
+    int32_t expected_height;
+    uint8_t *expected_pixels = software_renderer_render_to_image(
+        &grid,
+        &selection,
+        embedded_texture_atlas_png.pixels,
+        embedded_texture_atlas_png.width,
+        embedded_texture_atlas_png.height,
+        &expected_width,
+        &expected_height
+    );
+    assert(expected_width == window->width && expected_height == window->height);
+
+    bool did_pass = test_image_compare(pixels, expected_pixels, window->width, window->height);
+
+    if (!did_pass) {
+        test_image_write(TEST_ACTUAL_PATH, pixels, window->width, window->height);
+        test_image_write(TEST_EXPECTED_PATH, expected_pixels, window->width, window->height);
+        printf("wrote what was drawn to %s and what was expected to %s\n", TEST_ACTUAL_PATH, TEST_EXPECTED_PATH);
+    }
+
+    free(pixels);
+    free(expected_pixels);
+
+    // The renderer's prefetch thread may still be reading scrollback lines, so it has to stop before the grid is
+    // freed.
+    renderer_destroy(&renderer);
+    grid_destroy(&grid);
+
+    return did_pass;
+}
+
+int main(int argc, char **argv) {
+    if (!test_can_create_context()) {
+        puts("skipped, no GL context could be created");
+        return TEST_SKIP_EXIT_CODE;
+    }
+
+    // Without the real atlas, eg: when it's a Git LFS pointer that wasn't fetched, there's nothing to compare.
+    int32_t min_atlas_width = (FONT_LENGTH + 1) * (FONT_GLYPH_WIDTH + FONT_GLYPH_PADDING);
+    if (embedded_texture_atlas_png.width < min_atlas_width || embedded_texture_atlas_png.height < FONT_GLYPH_HEIGHT) {
+        puts("skipped, the embedded texture atlas is too small to hold the font");
+        return TEST_SKIP_EXIT_CODE;
+    }
+
+    struct Window window = window_create(
+        "term-gl-renderer-test",
+        TEST_SCENE_WIDTH * FONT_GLYPH_WIDTH,
+        TEST_SCENE_HEIGHT * FONT_GLYPH_HEIGHT
+    );
+    // The cursor is only drawn while focused.
+    window.is_focused = true;
+
+    int32_t exit_code = 0;
+
+    size_t cursor_style_count = sizeof(test_cursor_styles) / sizeof(test_cursor_styles[0]);
+    for (size_t i = 0; i < cursor_style_count; i++) {
+        if (!test_draw_scene(&window, test_cursor_styles[i], test_scene_get_selection())) {
+            printf("cursor style %d doesn't match\n", test_cursor_styles[i]);
+            exit_code = -1;
+        }
+    }
+
+    if (!test_draw_scene(&window, GRID_CURSOR_STYLE_BLOCK, test_scene_get_colored_selection())) {
+        puts("the selection over colored text doesn't match");
+        exit_code = -1;
+    }
+
+    window_destroy(&window);
+
+    return exit_code;
+}
\ No newline at end of file
@@ -0,0 +1,257 @@
+// Draws the test scene with each cursor style, then with a selection over colored text, and compares it against a
+// golden image. Run with --update to write the golden image instead, after a change that's meant to change how the
+// scene looks.
+//
+// Usage: term-software-renderer-test [golden image path] [--update]
+
+#include "test_image.h"
+#include "test_scene.h"
+
+#include "font.h"
+#include "graphics/software_renderer.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#define TEST_DEFAULT_GOLDEN_PATH "software_renderer.ppm"
+#define TEST_ACTUAL_PATH "software_renderer_actual.ppm"
+#define TEST_ATLAS_CELL_WIDTH (FONT_GLYPH_WIDTH + FONT_GLYPH_PADDING)
+#define TEST_ATLAS_WIDTH ((FONT_LENGTH + 1) * TEST_ATLAS_CELL_WIDTH)
+#define TEST_ATLAS_HEIGHT FONT_GLYPH_HEIGHT
+
+static const enum GridCursorStyle test_cursor_styles[] = {
+    GRID_CURSOR_STYLE_BLOCK,
+    GRID_CURSOR_STYLE_UNDERLINE,
+    GRID_CURSOR_STYLE_BAR,
+};
+
+static void test_on_row_changed(void *context, int32_t y) {}
+
+static void test_on_cursor_changed(void *context) {}
+
+// Every glyph gets a different pattern, so drawing one from the wrong place in the atlas changes the image. That way
+// the golden image doesn't depend on the font that's embedded into the terminal.
+static uint8_t *test_create_atlas(void) {
+    uint8_t *pixels = calloc(TEST_ATLAS_WIDTH * TEST_ATLAS_HEIGHT, 4);
+    assert(pixels);
+
+    for (int32_t glyph_i = 0; glyph_i <= FONT_LENGTH; glyph_i++) {
+        for (int32_t y = 0; y < FONT_GLYPH_HEIGHT; y++) {
+            for (int32_t x = 0; x < FONT_GLYPH_WIDTH; x++) {
+                if ((x + y * 3 + glyph_i * 5) % 7 >= 3) {
+                    continue;
+                }
+
+                size_t i = ((size_t)y * TEST_ATLAS_WIDTH + glyph_i * TEST_ATLAS_CELL_WIDTH + x) * 4;
+                memset(pixels + i, 0xff, 4);
+            }
+        }
+    }
+
+    return pixels;
+}
+
+static struct Grid test_create_grid(enum GridCursorStyle cursor_style) {
+    struct Grid grid = grid_create(
+        TEST_SCENE_WIDTH,
+        TEST_SCENE_HEIGHT,
+        NULL,
+        test_on_row_changed,
+        test_on_cursor_changed
+    );
+    test_scene_fill(&grid, cursor_style);
+
+    return grid;
+}
+
+// Draws the scene into part of a larger image.
+static void test_draw_scene(
+    const uint8_t *atlas_pixels, enum GridCursorStyle cursor_style, struct Selection *selection, uint8_t *pixels
+) {
+
+    struct Grid grid = test_create_grid(cursor_style);
+
+    int32_t image_width;
+    int32_t image_height;
+    uint8_t *image = software_renderer_render_to_image(
+        &grid,
+        selection,
+        atlas_pixels,
+        TEST_ATLAS_WIDTH,
+        TEST_ATLAS_HEIGHT,
+        &image_width,
+        &image_height
+    );
+    assert(image_width == TEST_SCENE_WIDTH * FONT_GLYPH_WIDTH && image_height == TEST_SCENE_HEIGHT * FONT_GLYPH_HEIGHT);
+
+    memcpy(pixels, image, (size_t)image_width * image_height * 4);
+
+    free(image);
+    grid_destroy(&grid);
+}
+
+static bool test_is_pixel_color(const uint8_t *pixel, uint32_t hex) {
+    return pixel[0] == ((hex >> 16) & 0xff) && pixel[1] == ((hex >> 8) & 0xff) && pixel[2] == (hex & 0xff);
+}
+
+// Selected cells swap their own colors, so the red "r" on the default background has to be drawn in the default
+// background color on red. This doesn't rely on the golden image, which could have been written with the wrong colors.
+static bool test_selection_colors(const uint8_t *atlas_pixels) {
+    struct Grid grid = test_create_grid(GRID_CURSOR_STYLE_BLOCK);
+    struct Selection selection = test_scene_get_colored_selection();
+
+    int32_t width;
+    int32_t height;
+    uint8_t *pixels = software_renderer_render_to_image(
+        &grid,
+        &selection,
+        atlas_pixels,
+        TEST_ATLAS_WIDTH,
+        TEST_ATLAS_HEIGHT,
+        &width,
+        &height
+    );
+
+    uint32_t foreground_hex = grid_color_to_hex(&grid, GRID_COLOR_RED);
+    uint32_t background_hex = grid_color_to_hex(&grid, GRID_COLOR_BACKGROUND_DEFAULT);
+    size_t foreground_count = 0;
+    size_t background_count = 0;
+
+    // The "r" is in the first cell of the second row.
+    for (int32_t y = FONT_GLYPH_HEIGHT; y < FONT_GLYPH_HEIGHT * 2; y++) {
+        for (int32_t x = 0; x < FONT_GLYPH_WIDTH; x++) {
+            const uint8_t *pixel = pixels + ((size_t)y * width + x) * 4;
+
+            foreground_count += test_is_pixel_color(pixel, foreground_hex);
+            background_count += test_is_pixel_color(pixel, background_hex);
+        }
+    }
+
+    free(pixels);
+    grid_destroy(&grid);
+
+    return foreground_count > 0 && background_count > 0 &&
+           foreground_count + background_count == FONT_GLYPH_WIDTH * FONT_GLYPH_HEIGHT;
+}
+
+// Rows that weren't changed are kept from the last draw, so drawing the scene over a different one has to give the
+// same image as drawing it from scratch.
+static bool test_redraw(const uint8_t *atlas_pixels, const uint8_t *expected_pixels) {
+    struct Grid grid = test_create_grid(GRID_CURSOR_STYLE_BLOCK);
+
+    struct SoftwareRenderer software_renderer =
+        software_renderer_create(grid.width, grid.height, atlas_pixels, TEST_ATLAS_WIDTH, TEST_ATLAS_HEIGHT);
+    grid.callback_context = &software_renderer;
+    grid.on_row_changed = software_renderer_on_row_changed_callback;
+    grid.on_cursor_changed = software_renderer_on_cursor_changed_callback;
+
+    struct Selection other_selection = {.start_x = 2, .start_y = 3, .end_x = 20, .end_y = 4};
+    grid_cursor_move_to(&grid, 12, 0);
+    software_renderer_draw(&software_renderer, &grid, &other_selection);
+
+    struct Selection selection = test_scene_get_selection();
+    grid_cursor_move_to(&grid, 3, 5);
+    software_renderer_draw(&software_renderer, &grid, &selection);
+
+    bool did_pass = test_image_compare(
+        software_renderer.pixels,
+        expected_pixels,
+        software_renderer.width,
+        software_renderer.height
+    );
+
+    software_renderer_destroy(&software_renderer);
+    grid_destroy(&grid);
+
+    return did_pass;
+}
+
+int main(int argc, char **argv) {
+    const char *golden_path = TEST_DEFAULT_GOLDEN_PATH;
+    bool should_update = false;
+
+    for (int32_t i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--update") == 0) {
+            should_update = true;
+        } else {
+            golden_path = argv[i];
+        }
+    }
+
+    uint8_t *atlas_pixels = test_create_atlas();
+
+    // The scene is drawn once for each cursor style, then once with the colored selection, one below the other.
+    size_t cursor_style_count = sizeof(test_cursor_styles) / sizeof(test_cursor_styles[0]);
+    size_t scene_count = cursor_style_count + 1;
+    int32_t scene_width = TEST_SCENE_WIDTH * FONT_GLYPH_WIDTH;
+    int32_t scene_height = TEST_SCENE_HEIGHT * FONT_GLYPH_HEIGHT;
+    int32_t width = scene_width;
+    int32_t height = scene_height * (int32_t)scene_count;
+    size_t scene_size = (size_t)scene_width * scene_height * 4;
+
+    uint8_t *pixels = malloc(scene_size * scene_count);
+    assert(pixels);
+
+    struct Selection selection = test_scene_get_selection();
+    struct Selection colored_selection = test_scene_get_colored_selection();
+
+    for (size_t i = 0; i < cursor_style_count; i++) {
+        test_draw_scene(atlas_pixels, test_cursor_styles[i], &selection, pixels + scene_size * i);
+    }
+
+    uint8_t *colored_selection_pixels = pixels + scene_size * cursor_style_count;
+    test_draw_scene(atlas_pixels, GRID_CURSOR_STYLE_BLOCK, &colored_selection, colored_selection_pixels);
+
+    int32_t exit_code = 0;
+
+    if (should_update) {
+        if (test_image_write(golden_path, pixels, width, height)) {
+            printf("wrote %s\n", golden_path);
+        } else {
+            printf("failed to write %s\n", golden_path);
+            exit_code = -1;
+        }
+    } else {
+        int32_t golden_width;
+        int32_t golden_height;
+        uint8_t *golden_pixels = test_image_read(golden_path, &golden_width, &golden_height);
+
+        if (!golden_pixels) {
+            printf("failed to read %s\n", golden_path);
+            exit_code = -1;
+        } else if (golden_width != width || golden_height != height) {
+            printf(
+                "%s is %" PRId32 "x%" PRId32 " instead of %" PRId32 "x%" PRId32 "\n",
+                golden_path,
+                golden_width,
+                golden_height,
+                width,
+                height
+            );
+            exit_code = -1;
+        } else if (!test_image_compare(pixels, golden_pixels, width, height)) {
+            test_image_write(TEST_ACTUAL_PATH, pixels, width, height);
+            printf("wrote what was drawn to %s\n", TEST_ACTUAL_PATH);
+            exit_code = -1;
+        }
+
+        free(golden_pixels);
+    }
+
+    if (!test_redraw(atlas_pixels, pixels)) {
+        puts("drawing over an older frame doesn't match drawing from scratch");
+        exit_code = -1;
+    }
+
+    if (!test_selection_colors(atlas_pixels)) {
+        puts("selected cells don't swap their own foreground and background colors");
+        exit_code = -1;
+    }
+
+    free(pixels);
+    free(atlas_pixels);
+
+    return exit_code;
+}
\ No newline at end of file
@@ -0,0 +1,103 @@
+// fopen_s is only available with MSVC.
+#define _CRT_SECURE_NO_WARNINGS
+
+#include "test_image.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+
+uint8_t *test_image_read(const char *path, int32_t *width, int32_t *height) {
+    FILE *file = fopen(path, "rb");
+
+    if (!file) {
+        return NULL;
+    }
+
+    int32_t max_value = 0;
+    if (fscanf(file, "P6 %" SCNd32 " %" SCNd32 " %" SCNd32, width, height, &max_value) != 3 || max_value != 255 ||
+        *width <= 0 || *height <= 0 || fgetc(file) == EOF) {
+
+        fclose(file);
+        return NULL;
+    }
+
+    size_t pixel_count = (size_t)*width * *height;
+    uint8_t *pixels = malloc(pixel_count * 4);
+    assert(pixels);
+
+    for (size_t i = 0; i < pixel_count; i++) {
+        if (fread(pixels + i * 4, 1, 3, file) != 3) {
+            free(pixels);
+            fclose(file);
+            return NULL;
+        }
+
+        pixels[i * 4 + 3] = 0xff;
+    }
+
+    fclose(file);
+
+    return pixels;
+}
+
+bool test_image_write(const char *path, const uint8_t *pixels, int32_t width, int32_t height) {
+    FILE *file = fopen(path, "wb");
+
+    if (!file) {
+        return false;
+    }
+
+    fprintf(file, "P6\n%" PRId32 " %" PRId32 "\n255\n", width, height);
+
+    size_t pixel_count = (size_t)width * height;
+    for (size_t i = 0; i < pixel_count; i++) {
+        fwrite(pixels + i * 4, 1, 3, file);
+    }
+
+    return fclose(file) == 0;
+}
+
+bool test_image_compare(const uint8_t *pixels, const uint8_t *expected_pixels, int32_t width, int32_t height) {
+    size_t mismatch_count = 0;
+    size_t first_mismatch_i = 0;
+    size_t pixel_count = (size_t)width * height;
+
+    // Alpha isn't stored in golden images, so only the colors are compared.
+    for (size_t i = 0; i < pixel_count; i++) {
+        const uint8_t *pixel = pixels + i * 4;
+        const uint8_t *expected_pixel = expected_pixels + i * 4;
+
+        if (pixel[0] == expected_pixel[0] && pixel[1] == expected_pixel[1] && pixel[2] == expected_pixel[2]) {
+            continue;
+        }
+
+        if (mismatch_count == 0) {
+            first_mismatch_i = i;
+        }
+        mismatch_count++;
+    }
+
+    if (mismatch_count == 0) {
+        return true;
+    }
+
+    const uint8_t *pixel = pixels + first_mismatch_i * 4;
+    const uint8_t *expected_pixel = expected_pixels + first_mismatch_i * 4;
+
+    printf(
+        "%zu of %zu pixels differ, the first is at %zu, %zu: %02x%02x%02x instead of %02x%02x%02x\n",
+        mismatch_count,
+        pixel_count,
+        first_mismatch_i % width,
+        first_mismatch_i / width,
+        pixel[0],
+        pixel[1],
+        pixel[2],
+        expected_pixel[0],
+        expected_pixel[1],
+        expected_pixel[2]
+    );
+
+    return false;
+}
\ No newline at end of file
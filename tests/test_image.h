@@ -0,0 +1,14 @@
+#ifndef TEST_IMAGE_H
+#define TEST_IMAGE_H
+
+#include <stdbool.h>
+#include <inttypes.h>
+
+// Images are RGBA with the top row first, the same as the software renderer's framebuffer. Golden images are stored
+// as binary PPM without the alpha channel, so they can be opened by common tools and don't need an image library.
+uint8_t *test_image_read(const char *path, int32_t *width, int32_t *height);
+bool test_image_write(const char *path, const uint8_t *pixels, int32_t width, int32_t height);
+// Prints how many pixels differ and where the first one is, returns true if they all match.
+bool test_image_compare(const uint8_t *pixels, const uint8_t *expected_pixels, int32_t width, int32_t height);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,79 @@
+#include "test_scene.h"
+
+#include <assert.h>
+
+static void test_scene_write(struct Grid *grid, int32_t x, int32_t y, const char *text) {
+    for (const char *c = text; *c != '\0'; c++) {
+        grid_set_char(grid, x, y, (uint8_t)*c);
+        x++;
+    }
+}
+
+static void test_scene_write_colored(
+    struct Grid *grid, int32_t x, int32_t y, const char *text, uint32_t foreground_color, uint32_t background_color
+) {
+
+    grid->current_foreground_color = foreground_color;
+    grid->current_background_color = background_color;
+    test_scene_write(grid, x, y, text);
+
+    grid->current_foreground_color = GRID_COLOR_FOREGROUND_DEFAULT;
+    grid->current_background_color = GRID_COLOR_BACKGROUND_DEFAULT;
+}
+
+void test_scene_fill(struct Grid *grid, enum GridCursorStyle cursor_style) {
+    assert(grid->width == TEST_SCENE_WIDTH && grid->height == TEST_SCENE_HEIGHT);
+
+    test_scene_write(grid, 0, 0, "Hello, world! 0123456789");
+
+    test_scene_write_colored(grid, 0, 1, "red", GRID_COLOR_RED, GRID_COLOR_BACKGROUND_DEFAULT);
+    test_scene_write_colored(grid, 4, 1, "on blue", GRID_COLOR_BRIGHT_WHITE, GRID_COLOR_BLUE);
+    test_scene_write_colored(
+        grid,
+        12,
+        1,
+        "truecolor",
+        GRID_COLOR_TRUECOLOR | 0x102030,
+        GRID_COLOR_TRUECOLOR | 0xf0c040
+    );
+
+    grid_set_char(grid, 0, 2, 0x250C);
+    grid_set_char(grid, 7, 2, 0x2510);
+    grid_set_char(grid, 0, 3, 0x2502);
+    grid_set_char(grid, 7, 3, 0x2502);
+    grid_set_char(grid, 0, 4, 0x2514);
+    grid_set_char(grid, 7, 4, 0x2518);
+
+    for (int32_t x = 1; x < 7; x++) {
+        grid_set_char(grid, x, 2, 0x2500);
+        grid_set_char(grid, x, 4, 0x2500);
+    }
+
+    test_scene_write(grid, 2, 3, "box");
+    test_scene_write_colored(grid, 10, 3, "[ ok ]", GRID_COLOR_GREEN, GRID_COLOR_BRIGHT_BLACK);
+
+    test_scene_write(grid, 0, 5, "$ ls -la");
+
+    // On the "s", so block cursors have a glyph to invert.
+    grid->should_show_cursor = true;
+    grid_cursor_move_to(grid, 3, 5);
+    grid_set_cursor_style(grid, cursor_style);
+}
+
+struct Selection test_scene_get_selection(void) {
+    return (struct Selection){
+        .start_x = 14,
+        .start_y = 0,
+        .end_x = 6,
+        .end_y = 1,
+    };
+}
+
+struct Selection test_scene_get_colored_selection(void) {
+    return (struct Selection){
+        .start_x = 0,
+        .start_y = 1,
+        .end_x = 15,
+        .end_y = 3,
+    };
+}
\ No newline at end of file
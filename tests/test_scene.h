@@ -0,0 +1,18 @@
+#ifndef TEST_SCENE_H
+#define TEST_SCENE_H
+
+#include "grid.h"
+#include "selection.h"
+
+#define TEST_SCENE_WIDTH 24
+#define TEST_SCENE_HEIGHT 6
+
+// Fills a grid of the scene's size with what the pixel tests draw: plain and colored text, a box made of box drawing
+// characters and a prompt with the cursor on it.
+void test_scene_fill(struct Grid *grid, enum GridCursorStyle cursor_style);
+// Ends partway through the line after the one it starts on, over both default and colored backgrounds.
+struct Selection test_scene_get_selection(void);
+// Covers text with colored foregrounds, on both the default and colored backgrounds.
+struct Selection test_scene_get_colored_selection(void);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,176 @@
+// Generates a C source and header that embed the given assets, so that the terminal doesn't need to read or decode
+// anything from disk at startup. PNG images are decoded to RGBA pixels, every other file is embedded as a
+// null-terminated string.
+//
+// Usage: embed_assets <output directory> <asset path>...
+// Each asset is named after its file name, with characters that aren't valid in identifiers replaced by underscores,
+// eg: assets/shader_2d.vert becomes embedded_shader_2d_vert.
+
+#define _CRT_SECURE_NO_WARNINGS
+
+// Only PNG images are embedded, which also avoids needing the math library for HDR images.
+#define STBI_ONLY_PNG
+#define STBI_NO_LINEAR
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image/stb_image.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <ctype.h>
+
+#define EMBED_ASSETS_MAX_NAME_LENGTH 256
+#define EMBED_ASSETS_BYTES_PER_LINE 16
+
+static void get_asset_name(const char *path, char *name) {
+    const char *file_name = path;
+    for (const char *c = path; *c; c++) {
+        if (*c == '/' || *c == '\\') {
+            file_name = c + 1;
+        }
+    }
+
+    size_t length = 0;
+    for (; file_name[length] && length < EMBED_ASSETS_MAX_NAME_LENGTH - 1; length++) {
+        char c = file_name[length];
+        name[length] = isalnum((unsigned char)c) ? c : '_';
+    }
+
+    name[length] = '\0';
+}
+
+static bool has_extension(const char *path, const char *extension) {
+    size_t path_length = strlen(path);
+    size_t extension_length = strlen(extension);
+
+    return path_length >= extension_length && strcmp(path + path_length - extension_length, extension) == 0;
+}
+
+static void write_bytes(FILE *file, const uint8_t *data, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        if (i % EMBED_ASSETS_BYTES_PER_LINE == 0) {
+            fputs("\n   ", file);
+        }
+
+        fprintf(file, " 0x%02x,", data[i]);
+    }
+
+    fputc('\n', file);
+}
+
+static bool embed_image(FILE *source_file, FILE *header_file, const char *path, const char *name) {
+    int width;
+    int height;
+    int channel_count;
+    uint8_t *pixels = stbi_load(path, &width, &height, &channel_count, 4);
+
+    if (!pixels) {
+        fprintf(stderr, "Failed to load image: %s\n", path);
+        return false;
+    }
+
+    fprintf(source_file, "static const uint8_t embedded_%s_pixels[] = {", name);
+    write_bytes(source_file, pixels, (size_t)width * height * 4);
+    fprintf(source_file, "};\n\n");
+
+    fprintf(
+        source_file,
+        "const struct EmbeddedImage embedded_%s = {\n    .pixels = embedded_%s_pixels,\n    .width = %d,\n"
+        "    .height = %d,\n};\n\n",
+        name,
+        name,
+        width,
+        height
+    );
+
+    fprintf(header_file, "extern const struct EmbeddedImage embedded_%s;\n", name);
+
+    stbi_image_free(pixels);
+
+    return true;
+}
+
+static bool embed_text(FILE *source_file, FILE *header_file, const char *path, const char *name) {
+    FILE *file = fopen(path, "rb");
+
+    if (!file) {
+        fprintf(stderr, "Failed to open file: %s\n", path);
+        return false;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    rewind(file);
+
+    // Room for the null terminator.
+    uint8_t *data = malloc(length + 1);
+    if (!data) {
+        fclose(file);
+        return false;
+    }
+
+    size_t read_length = fread(data, 1, length, file);
+    data[read_length] = '\0';
+    fclose(file);
+
+    fprintf(source_file, "const char embedded_%s[] = {", name);
+    write_bytes(source_file, data, read_length + 1);
+    fprintf(source_file, "};\n\n");
+
+    fprintf(header_file, "extern const char embedded_%s[];\n", name);
+
+    free(data);
+
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s <output directory> <asset path>...\n", argv[0]);
+        return 1;
+    }
+
+    char source_path[1024];
+    char header_path[1024];
+    snprintf(source_path, sizeof(source_path), "%s/embedded_assets.c", argv[1]);
+    snprintf(header_path, sizeof(header_path), "%s/embedded_assets.h", argv[1]);
+
+    FILE *source_file = fopen(source_path, "wb");
+    FILE *header_file = fopen(header_path, "wb");
+
+    if (!source_file || !header_file) {
+        fprintf(stderr, "Failed to create output files in: %s\n", argv[1]);
+        return 1;
+    }
+
+    fputs("// Generated by tools/embed_assets.c, don't edit.\n\n#include \"embedded_assets.h\"\n\n", source_file);
+    fputs(
+        "// Generated by tools/embed_assets.c, don't edit.\n\n"
+        "#ifndef EMBEDDED_ASSETS_H\n#define EMBEDDED_ASSETS_H\n\n#include <inttypes.h>\n\n"
+        "// Decoded RGBA pixels.\n"
+        "struct EmbeddedImage {\n    const uint8_t *pixels;\n    int32_t width;\n    int32_t height;\n};\n\n",
+        header_file
+    );
+
+    bool did_succeed = true;
+
+    for (int i = 2; i < argc && did_succeed; i++) {
+        char name[EMBED_ASSETS_MAX_NAME_LENGTH];
+        get_asset_name(argv[i], name);
+
+        if (has_extension(argv[i], ".png")) {
+            did_succeed = embed_image(source_file, header_file, argv[i], name);
+        } else {
+            did_succeed = embed_text(source_file, header_file, argv[i], name);
+        }
+    }
+
+    fputs("\n#endif\n", header_file);
+
+    fclose(source_file);
+    fclose(header_file);
+
+    return did_succeed ? 0 : 1;
+}
\ No newline at end of file